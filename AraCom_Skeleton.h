@@ -3,6 +3,12 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
 #include <cstdint>
 
 namespace ara {
@@ -14,11 +20,301 @@ using InstanceIdentifier = uint16_t;
 using MethodId = uint16_t;
 // Identifier for a service event
 using EventId = uint16_t;
+// Identifier of one outstanding request (transport specific, e.g. client/session)
+using RequestToken = uint32_t;
+
+// Shared, reference-counted view of message bytes. Copying a Payload only
+// bumps a reference count; the bytes stay in the buffer they arrived in
+// (e.g. the transport's receive payload) for as long as any view is alive.
+// A borrowed view (Borrowed()) is only lent for the duration of a callback:
+// reading it costs nothing, copying it copies the bytes, so any copy that is
+// kept stays valid after the lender reuses its buffer.
+class Payload {
+    std::shared_ptr<const void> owner_; // keeps the underlying buffer alive
+    const uint8_t* data_{nullptr};
+    size_t size_{0};
+    std::vector<uint8_t>* vec_{nullptr}; // set when owner_ is a vector created by this class
+    const void* kind_{nullptr};          // transport tag of owner_ (see Owner())
+
+public:
+    Payload() = default;
+
+    // Take ownership of a vector without copying it
+    Payload(std::vector<uint8_t>&& v) {
+        auto sp = std::make_shared<std::vector<uint8_t>>(std::move(v));
+        data_ = sp->data();
+        size_ = sp->size();
+        vec_ = sp.get();
+        owner_ = std::move(sp);
+    }
+
+    // Copy bytes from a vector the caller keeps
+    Payload(const std::vector<uint8_t>& v) : Payload(std::vector<uint8_t>(v)) {}
+
+    // Wrap a buffer owned by someone else; kind tags the owner type for Owner()
+    Payload(std::shared_ptr<const void> owner, const uint8_t* data, size_t size,
+            const void* kind = nullptr)
+        : owner_(std::move(owner)), data_(data), size_(size), kind_(kind) {}
+
+    // View of bytes the caller lends until its callback returns
+    static Payload Borrowed(const uint8_t* data, size_t size) {
+        return Payload(nullptr, data, size, BorrowedKind());
+    }
+
+    Payload(const Payload& o) : owner_(o.owner_), data_(o.data_), size_(o.size_), vec_(o.vec_), kind_(o.kind_) {
+        if (o.IsBorrowed()) *this = Payload(std::vector<uint8_t>(o.begin(), o.end()));
+    }
+    Payload(Payload&&) = default;
+    Payload& operator=(const Payload& o) {
+        if (this != &o) *this = Payload(o);
+        return *this;
+    }
+    Payload& operator=(Payload&&) = default;
+
+    bool IsBorrowed() const { return kind_ == BorrowedKind(); }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const uint8_t* begin() const { return data_; }
+    const uint8_t* end() const { return data_ + size_; }
+    uint8_t operator[](size_t i) const { return data_[i]; }
+
+    // View of [offset, offset + len) sharing the same buffer
+    Payload Slice(size_t offset, size_t len) const {
+        return Payload(owner_, data_ + offset, len, IsBorrowed() ? kind_ : nullptr);
+    }
+
+    // Owner buffer if it was tagged with kind and this view covers all of it
+    template <typename T>
+    std::shared_ptr<T> Owner(const void* kind) const {
+        if (kind_ != kind || !owner_) return nullptr;
+        return std::static_pointer_cast<T>(std::const_pointer_cast<void>(owner_));
+    }
+
+    // Hand the bytes over as a vector: moved out when this view is the only
+    // owner of a vector it created, copied otherwise. Leaves the view empty.
+    std::vector<uint8_t> Release() {
+        std::vector<uint8_t> out;
+        if (vec_ && owner_.use_count() == 1 && data_ == vec_->data() && size_ == vec_->size()) {
+            out = std::move(*vec_);
+        } else {
+            out.assign(begin(), end());
+        }
+        *this = Payload();
+        return out;
+    }
+
+    long UseCount() const { return owner_.use_count(); }
+
+private:
+    static const void* BorrowedKind() {
+        static const char tag = 0;
+        return &tag;
+    }
+};
 
 // Structure representing a message exchanged between client and server
 struct Message {
     MethodId method; // ID of the related method for this message
-    std::vector<uint8_t> payload; // Data payload of the message
+    Payload payload; // Data payload of the message (shared, not copied between hops)
+    RequestToken request{0}; // Token of the request this message belongs to (copy it into the response)
+};
+
+// Why an asynchronous method call did not produce a response
+enum class CallStatus { kOk, kTimeout, kCancelled, kError, kUnavailable };
+
+// Error stored in a call future when no regular response arrives
+class CallError : public std::runtime_error {
+    CallStatus status_;
+public:
+    CallError(CallStatus st, const std::string& what) : std::runtime_error(what), status_(st) {}
+    CallStatus Status() const { return status_; }
+};
+
+// Shared completion state of one asynchronous call; the first Complete/Fail wins
+class CallState {
+    std::promise<Message> promise_;
+    std::atomic<bool> done_{false};
+    const std::chrono::steady_clock::time_point issued_{std::chrono::steady_clock::now()};
+    std::mutex then_mu_;
+    bool settled_{false};          // the future is ready (guarded by then_mu_)
+    std::function<void()> then_;   // run once when it becomes ready
+
+    void Settled() {
+        std::function<void()> fn;
+        {
+            std::lock_guard<std::mutex> lk(then_mu_);
+            settled_ = true;
+            fn = std::move(then_);
+        }
+        if (fn) fn();
+    }
+
+public:
+    // When the call was created (just before its request was sent)
+    std::chrono::steady_clock::time_point Issued() const { return issued_; }
+
+    std::future<Message> GetFuture() { return promise_.get_future(); }
+
+    bool Complete(Message&& m) {
+        if (done_.exchange(true)) return false;
+        promise_.set_value(std::move(m));
+        Settled();
+        return true;
+    }
+
+    bool Fail(CallStatus st, const std::string& what) {
+        if (done_.exchange(true)) return false;
+        promise_.set_exception(std::make_exception_ptr(CallError(st, what)));
+        Settled();
+        return true;
+    }
+
+    bool Done() const { return done_.load(); }
+
+    // Run fn once the future is ready: on the thread that completes the call,
+    // or right here if it already is. One continuation per call.
+    void Then(std::function<void()> fn) {
+        {
+            std::lock_guard<std::mutex> lk(then_mu_);
+            if (!settled_) {
+                then_ = std::move(fn);
+                return;
+            }
+        }
+        fn();
+    }
+};
+
+// Handle returned by an asynchronous MethodCall: a future for the response
+// plus the correlation token and cancellation
+class CallHandle {
+    std::shared_ptr<CallState> state_;
+    std::future<Message> future_;
+    RequestToken token_{0};
+
+public:
+    CallHandle() = default;
+    CallHandle(std::shared_ptr<CallState> st, RequestToken token)
+        : state_(std::move(st)), future_(state_->GetFuture()), token_(token) {}
+
+    bool Valid() const { return future_.valid(); }
+    RequestToken Token() const { return token_; }
+
+    // Block until the response arrives; throws CallError on timeout/cancel/error
+    Message Get() { return future_.get(); }
+
+    template <typename Rep, typename Period>
+    bool WaitFor(const std::chrono::duration<Rep, Period>& d) const {
+        return future_.wait_for(d) == std::future_status::ready;
+    }
+
+    // Give up on the call; a late response is discarded
+    bool Cancel() {
+        return state_ && state_->Fail(CallStatus::kCancelled, "method call cancelled");
+    }
+
+    std::future<Message>& Future() { return future_; }
+
+    // Run fn once the response (or error) is ready instead of blocking in Get()
+    void Then(std::function<void()> fn) { state_->Then(std::move(fn)); }
+};
+
+// Wait for every handle (e.g. a pipelined batch) until deadline; returns number ready
+inline size_t WaitAll(std::vector<CallHandle>& calls, std::chrono::steady_clock::time_point deadline) {
+    size_t ready = 0;
+    for (auto& c : calls) {
+        if (c.Valid() && c.Future().wait_until(deadline) == std::future_status::ready) ++ready;
+    }
+    return ready;
+}
+
+// How a skeleton runs the handler of one method
+struct MethodConcurrency {
+    enum Mode { kInline, kSerialized, kParallel };
+    Mode mode{kInline};
+    size_t parallel{1};   // handlers in flight (kParallel)
+    size_t maxQueue{256}; // requests waiting for a handler before new ones are rejected
+
+    // On the transport's receive thread, one request at a time (default)
+    static MethodConcurrency Inline() { return MethodConcurrency(); }
+    // On the executor, one at a time in arrival order
+    static MethodConcurrency Serialized(size_t maxQueue = 256) {
+        MethodConcurrency c;
+        c.mode = kSerialized;
+        c.maxQueue = maxQueue;
+        return c;
+    }
+    // On the executor, up to n at a time
+    static MethodConcurrency Parallel(size_t n, size_t maxQueue = 256) {
+        MethodConcurrency c;
+        c.mode = kParallel;
+        c.parallel = n;
+        c.maxQueue = maxQueue;
+        return c;
+    }
+};
+
+// Response cache of an idempotent method: a request whose payload was seen
+// before is answered with the stored response instead of running the handler
+struct ResponseCacheConfig {
+    size_t capacity{256};                                  // responses kept (least recently used go first)
+    std::chrono::milliseconds ttl{std::chrono::minutes(1)}; // age at which a response is recomputed
+};
+
+// How a proxy hands the notifications of one event to its callback
+struct EventDelivery {
+    enum Mode { kInline, kQueued };
+    // What a full queue does with a new notification
+    enum Overflow {
+        kDropOldest, // discard the oldest queued one (consumers want fresh data)
+        kDropNewest, // discard the new one (consumers want every one they can get, in order)
+        kBlock       // the receive thread waits for room (stalls reception of other events too)
+    };
+    Mode mode{kInline};
+    size_t capacity{64};
+    Overflow overflow{kDropOldest};
+
+    // On the transport's receive thread, one notification at a time (default)
+    static EventDelivery Inline() { return EventDelivery(); }
+    // On a consumer thread of the event, behind a queue of capacity notifications
+    static EventDelivery Queued(size_t capacity = 64, Overflow overflow = kDropOldest) {
+        EventDelivery d;
+        d.mode = kQueued;
+        d.capacity = capacity;
+        d.overflow = overflow;
+        return d;
+    }
+};
+
+// Delivery policy of one subscriber for one event, negotiated when it
+// subscribes so the skeleton does not send what the consumer would discard.
+// Decimation is applied first, then the rate limit.
+struct EventPolicy {
+    std::chrono::microseconds minInterval{0}; // at most one notification per interval (0 = no limit)
+    uint32_t everyNth{1};                     // deliver one of every n notifications
+    bool latestOnly{false};                   // rate limited: send the newest suppressed value at the
+                                              // end of the interval instead of dropping it
+
+    bool Unshaped() const { return minInterval.count() == 0 && everyNth <= 1; }
+
+    static EventPolicy MaxRate(double hz) {
+        EventPolicy p;
+        p.minInterval = std::chrono::microseconds(hz > 0 ? static_cast<int64_t>(1e6 / hz) : 0);
+        return p;
+    }
+    static EventPolicy EveryNth(uint32_t n) {
+        EventPolicy p;
+        p.everyNth = n ? n : 1;
+        return p;
+    }
+    // At most hz notifications per second, always ending on the newest value
+    static EventPolicy LatestOnly(double hz) {
+        EventPolicy p = MaxRate(hz);
+        p.latestOnly = true;
+        return p;
+    }
 };
 
 // Skeleton interface representing the server/service side
@@ -28,10 +324,25 @@ public:
     virtual void OfferService() = 0;
     // Stop offering the service
     virtual void StopOfferService() = 0;
-    // Send a response message to the client after processing a method
-    virtual void SendResponse(const Message& msg) = 0;
-    // Send an event to all subscribed clients
-    virtual void SendEvent(EventId event, const std::vector<uint8_t>& data) = 0;
+    // Send a response message to the client after processing a method.
+    // msg.request selects which outstanding call is answered; may be called from any thread.
+    virtual void SendResponse(Message msg) = 0;
+    // Send an event to all subscribed clients (pass an rvalue to hand over the buffer)
+    virtual void SendEvent(EventId event, Payload data) = 0;
+    // Choose how the handler of method runs (call before OfferService). Requests
+    // beyond the method's queue limit are answered with an error.
+    virtual void SetConcurrency(MethodId method, MethodConcurrency c) = 0;
+    // Declare method idempotent: its responses are cached per request payload
+    // (call before OfferService). Transports without a cache run the handler
+    // for every request.
+    virtual void SetIdempotent(MethodId method, ResponseCacheConfig cfg = ResponseCacheConfig()) {
+        (void)method;
+        (void)cfg;
+    }
+    // Forget every cached response, e.g. because the application mode changed
+    virtual void InvalidateResponses() {}
+    // JSON snapshot of the binding's per-method/per-event metrics ("{}" if it has none)
+    virtual std::string MetricsSnapshot() const { return "{}"; }
     // Virtual destructor to ensure proper resource cleanup
     virtual ~Skeleton() = default;
 };
@@ -44,12 +355,35 @@ public:
     // Stop searching for a service
     virtual void StopFindService(InstanceIdentifier instance) = 0;
     // Send a method call request to the server
-    virtual void MethodCall(MethodId method, const std::vector<uint8_t>& req) = 0;
+    virtual void MethodCall(MethodId method, Payload req) = 0;
+    // Send a method call and get a handle to its response; fails with
+    // CallStatus::kTimeout if no response arrives within timeout
+    virtual CallHandle MethodCall(MethodId method, Payload req, std::chrono::milliseconds timeout) = 0;
     // Subscribe to an event from the server, with a callback to handle event data
-    virtual void SubscribeEvent(EventId event, std::function<void(const std::vector<uint8_t>&)> cb) = 0;
+    virtual void SubscribeEvent(EventId event, std::function<void(const Payload&)> cb) = 0;
+    // Same with a delivery policy applied by the skeleton; transports that
+    // cannot shape per subscriber deliver every notification
+    virtual void SubscribeEvent(EventId event, std::function<void(const Payload&)> cb, const EventPolicy& policy) {
+        (void)policy;
+        SubscribeEvent(event, std::move(cb));
+    }
+    // Choose the thread that runs the callback of event; transports without
+    // delivery queues run every callback inline
+    virtual void SetDelivery(EventId event, EventDelivery d) {
+        (void)event;
+        (void)d;
+    }
     // Register a callback to handle responses for a specific method
     virtual void RegisterResponseHandler(MethodId method,
-        std::function<void(const std::vector<uint8_t>&)> cb) = 0;
+        std::function<void(const Payload&)> cb) = 0;
+    // Block until the service found by FindService is offered; false after
+    // timeout. Transports that do not track availability report it available.
+    virtual bool WaitAvailable(std::chrono::milliseconds timeout) {
+        (void)timeout;
+        return true;
+    }
+    // JSON snapshot of the binding's per-method/per-event metrics ("{}" if it has none)
+    virtual std::string MetricsSnapshot() const { return "{}"; }
     // Virtual destructor to ensure proper resource cleanup
     virtual ~Proxy() = default;
 };
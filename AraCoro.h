@@ -0,0 +1,538 @@
+// AraCoro.h - C++20 coroutines over proxies, skeleton handlers and events
+//
+// Optional layer (CMake option ARACOM_COROUTINES); the rest of the tree stays
+// on C++14 and does not include this header.
+//
+//   coro::Task<void> Flow(com::Proxy& p) {
+//       com::Message r = co_await coro::Call(p, radar::Calibrate::kId, req, 1s);
+//       ...
+//   }
+//   coro::Spawn(exec, Flow(*proxy));
+//
+// Coroutines run on an Executor: a suspended coroutine holds no thread, and
+// the one that completes its call or notification only posts the resumption,
+// so thousands of logical requests share the executor's few workers.
+#pragma once
+#if !defined(__cpp_impl_coroutine)
+#error "AraCoro.h needs C++20 coroutines (configure with -DARACOM_COROUTINES=ON)"
+#endif
+#include "AraCom_Skeleton.h"
+#include "Executor.h"
+#include "SomeipSerializer.h"
+#include "AraLog.h"
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace ara {
+namespace com {
+namespace coro {
+
+// Coroutine frames come from per-thread free lists in 64-byte size classes up
+// to 1 KiB; larger frames use the global heap. A frame freed on another thread
+// joins that thread's list. A list that grows past kKeep hands half of it to
+// a shared list of its class, which refills lists that run dry, so frames
+// allocated on a receive thread and freed on a worker still circulate and a
+// steady stream of requests allocates nothing once the lists are warm.
+class FramePool {
+public:
+    static void* Allocate(size_t n) {
+        const size_t c = Class(n);
+        if (c < kClasses) {
+            Lists& l = Local();
+            if (!l.head[c]) Refill(l, c);
+            if (Free* f = l.head[c]) {
+                l.head[c] = f->next;
+                --l.count[c];
+                return f;
+            }
+            n = (c + 1) * kGranule;
+        }
+        heap_.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(n);
+    }
+
+    static void Release(void* p, size_t n) {
+        const size_t c = Class(n);
+        if (c >= kClasses) {
+            ::operator delete(p);
+            return;
+        }
+        Lists& l = Local();
+        l.head[c] = new (p) Free{l.head[c]};
+        if (++l.count[c] > kKeep) Spill(l, c);
+    }
+
+    // Frames taken from the global heap so far (misses of the free lists)
+    static uint64_t HeapAllocations() { return heap_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kGranule = 64;
+    static constexpr size_t kClasses = 16;
+    static constexpr size_t kKeep = 256;         // per thread and class
+    static constexpr size_t kShared = 64 * kKeep; // in the shared list of a class
+
+    struct Free {
+        Free* next;
+    };
+    static void FreeAll(Free* f) {
+        while (f) {
+            Free* next = f->next;
+            ::operator delete(f);
+            f = next;
+        }
+    }
+    struct Lists {
+        Free* head[kClasses]{};
+        size_t count[kClasses]{};
+        ~Lists() {
+            for (size_t c = 0; c < kClasses; ++c) Spill(*this, c, count[c]);
+        }
+    };
+    struct Shared {
+        std::mutex mu;
+        Free* head{nullptr};
+        size_t count{0};
+    };
+
+    // Move up to kKeep / 2 frames of class c from the shared list to l
+    static void Refill(Lists& l, size_t c) {
+        Shared& s = SharedList(c);
+        std::lock_guard<std::mutex> lk(s.mu);
+        for (size_t i = 0; i < kKeep / 2 && s.head; ++i) {
+            Free* f = s.head;
+            s.head = f->next;
+            --s.count;
+            f->next = l.head[c];
+            l.head[c] = f;
+            ++l.count[c];
+        }
+    }
+
+    // Move n frames of class c from l to the shared list (freed if it is full)
+    static void Spill(Lists& l, size_t c, size_t n = kKeep / 2) {
+        if (!n) return;
+        Free* first = l.head[c];
+        Free* last = first;
+        for (size_t i = 1; i < n; ++i) last = last->next;
+        l.head[c] = last->next;
+        l.count[c] -= n;
+        Shared& s = SharedList(c);
+        std::unique_lock<std::mutex> lk(s.mu);
+        if (s.count + n > kShared) {
+            lk.unlock();
+            last->next = nullptr;
+            FreeAll(first);
+            return;
+        }
+        last->next = s.head;
+        s.head = first;
+        s.count += n;
+    }
+
+    static size_t Class(size_t n) { return n ? (n - 1) / kGranule : 0; }
+    static Lists& Local() {
+        static thread_local Lists lists;
+        return lists;
+    }
+    static Shared& SharedList(size_t c) {
+        static Shared shared[kClasses];
+        return shared[c];
+    }
+
+    static inline std::atomic<uint64_t> heap_{0};
+};
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+inline void Resume(std::coroutine_handle<> h, Executor* exec) {
+    if (exec) {
+        exec->Submit([h] { h.resume(); });
+    } else {
+        h.resume();
+    }
+}
+
+inline void LogDetached(const std::exception_ptr& e) {
+    try {
+        std::rethrow_exception(e);
+    } catch (const std::exception& ex) {
+        ARA_LOG_ERROR("[Com] Coroutine ended with an exception: {}", ex.what());
+    } catch (...) {
+        ARA_LOG_ERROR("[Com] Coroutine ended with an unknown exception");
+    }
+}
+
+// State shared by the promises of every Task: the executor the coroutine
+// resumes on, the coroutine awaiting it (if any) and how it ended
+struct PromiseBase {
+    Executor* exec{nullptr};
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+    bool detached{false}; // started by Spawn: destroys itself when done
+
+    static void* operator new(size_t n) { return FramePool::Allocate(n); }
+    static void operator delete(void* p, size_t n) { FramePool::Release(p, n); }
+
+    struct Final {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            PromiseBase& p = h.promise();
+            if (p.continuation) return p.continuation;
+            if (p.detached) {
+                if (p.error) LogDetached(p.error);
+                h.destroy();
+            }
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    Final final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    template <typename U>
+    void return_value(U&& v) {
+        value.emplace(std::forward<U>(v));
+    }
+    T Take() {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    void return_void() {}
+    void Take() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+
+// Lazily started coroutine producing a T. co_await it from another Task (it
+// runs on the awaiting coroutine's executor), or start it with Spawn/SyncWait.
+template <typename T>
+class Task {
+public:
+    struct promise_type : detail::Promise<T> {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    Task(Task&& o) noexcept : h_(std::exchange(o.h_, {})) {}
+    Task& operator=(Task&& o) noexcept {
+        if (this != &o) {
+            if (h_) h_.destroy();
+            h_ = std::exchange(o.h_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (h_) h_.destroy();
+    }
+
+    bool Valid() const { return static_cast<bool>(h_); }
+
+    // Give up ownership of the coroutine (see Spawn)
+    Handle Release() { return std::exchange(h_, {}); }
+
+    struct Awaiter {
+        Handle h;
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> parent) noexcept {
+            h.promise().continuation = parent;
+            h.promise().exec = parent.promise().exec;
+            return h;
+        }
+        T await_resume() { return h.promise().Take(); }
+    };
+    Awaiter operator co_await() && { return Awaiter{h_}; }
+    Awaiter operator co_await() & { return Awaiter{h_}; }
+
+private:
+    explicit Task(Handle h) : h_(h) {}
+    Handle h_;
+};
+
+// Start task on exec without waiting for it. Its result is discarded; an
+// exception it ends with is logged.
+template <typename T>
+void Spawn(Executor& exec, Task<T> task) {
+    auto h = task.Release();
+    h.promise().exec = &exec;
+    h.promise().detached = true;
+    exec.Submit([h] { h.resume(); });
+}
+
+namespace detail {
+
+template <typename T>
+Task<void> Fulfil(Task<T> task, std::promise<T>& done) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await std::move(task);
+            done.set_value();
+        } else {
+            done.set_value(co_await std::move(task));
+        }
+    } catch (...) {
+        done.set_exception(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+// Run task on exec and block the calling thread (not one of exec's) until it ends
+template <typename T>
+T SyncWait(Executor& exec, Task<T> task) {
+    std::promise<T> done;
+    auto result = done.get_future();
+    Spawn(exec, detail::Fulfil(std::move(task), done));
+    return result.get();
+}
+
+// co_await Yield(): continue on the coroutine's executor, e.g. to leave the
+// thread that resumed it or to let other coroutines run
+struct Yield {
+    bool await_ready() noexcept { return false; }
+    template <typename P>
+    void await_suspend(std::coroutine_handle<P> h) {
+        detail::Resume(h, h.promise().exec);
+    }
+    void await_resume() noexcept {}
+};
+
+// Awaitable asynchronous method call: suspends until the response arrives
+// (or the call fails) and resumes on the awaiting coroutine's executor.
+// Returns the response message; throws CallError like CallHandle::Get.
+class CallAwaiter {
+public:
+    explicit CallAwaiter(CallHandle call) : call_(std::move(call)) {}
+
+    bool await_ready() const { return call_.WaitFor(std::chrono::seconds(0)); }
+    template <typename P>
+    void await_suspend(std::coroutine_handle<P> h) {
+        Executor* exec = h.promise().exec;
+        // May resume h before returning: nothing of this frame is touched after it
+        call_.Then([h, exec] { detail::Resume(h, exec); });
+    }
+    Message await_resume() { return call_.Get(); }
+
+    RequestToken Token() const { return call_.Token(); }
+
+private:
+    CallHandle call_;
+};
+
+inline CallAwaiter Call(Proxy& proxy, MethodId method, Payload req, std::chrono::milliseconds timeout) {
+    return CallAwaiter(proxy.MethodCall(method, std::move(req), timeout));
+}
+
+// Typed variant: req is serialized with M::Request and the response decoded
+// into M::Response (a malformed one fails with CallStatus::kError)
+template <typename M>
+Task<typename M::Response> Call(Proxy& proxy, typename M::Request req, std::chrono::milliseconds timeout) {
+    Message m = co_await Call(proxy, M::kId, ser::Encode(req), timeout);
+    typename M::Response out;
+    if (!ser::Decode(m.payload, out)) throw CallError(CallStatus::kError, "malformed response");
+    co_return out;
+}
+
+namespace detail {
+
+template <typename Fn>
+struct Handler {
+    Fn fn;
+    std::function<void(Message)> respond;
+};
+
+template <typename Fn>
+Task<void> Serve(std::shared_ptr<const Handler<Fn>> h, Message req) {
+    Payload resp = co_await h->fn(req);
+    h->respond(Message{req.method, std::move(resp), req.request});
+}
+
+} // namespace detail
+
+// Skeleton handler that runs fn(const Message&) -> Task<Payload> as a
+// coroutine on exec and sends what it co_returns through respond, usually
+//   [&](com::Message m) { skeleton->SendResponse(std::move(m)); }
+// A handler that throws sends nothing (the caller sees its timeout).
+template <typename Fn>
+std::function<void(const Message&)> CoHandler(std::shared_ptr<Executor> exec, Fn fn,
+                                              std::function<void(Message)> respond) {
+    auto h = std::make_shared<const detail::Handler<Fn>>(detail::Handler<Fn>{std::move(fn), std::move(respond)});
+    return [exec, h](const Message& req) { Spawn(*exec, detail::Serve(h, req)); };
+}
+
+// Notifications of one event as an asynchronous sequence:
+//   auto s = coro::Subscribe<radar::DetectionsEvent>(*proxy, 16);
+//   while (auto list = co_await s.Next()) Use(*list);
+// Up to capacity notifications are buffered while no coroutine waits, beyond
+// that the oldest is dropped. One coroutine awaits Next() at a time. Next()
+// yields nothing once the stream is closed (or destroyed).
+template <typename T = Payload>
+class EventStream {
+    struct State {
+        explicit State(size_t cap) : capacity(cap ? cap : 1) {}
+
+        void Push(T v) {
+            std::coroutine_handle<> h;
+            Executor* exec = nullptr;
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                if (closed) return;
+                if (!waiter) {
+                    if (items.size() >= capacity) {
+                        items.pop_front();
+                        ++dropped;
+                    }
+                    items.push_back(std::move(v));
+                    return;
+                }
+                slot->emplace(std::move(v));
+                h = std::exchange(waiter, {});
+                exec = waiterExec;
+            }
+            detail::Resume(h, exec);
+        }
+
+        void Close() {
+            std::coroutine_handle<> h;
+            Executor* exec = nullptr;
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                closed = true;
+                h = std::exchange(waiter, {});
+                exec = waiterExec;
+            }
+            if (h) detail::Resume(h, exec);
+        }
+
+        std::mutex mu;
+        std::deque<T> items;
+        const size_t capacity;
+        uint64_t dropped{0};
+        bool closed{false};
+        std::coroutine_handle<> waiter; // coroutine suspended in Next()
+        Executor* waiterExec{nullptr};
+        std::optional<T>* slot{nullptr}; // where Push puts the value for it
+    };
+
+public:
+    explicit EventStream(size_t capacity = 64) : st_(std::make_shared<State>(capacity)) {}
+    EventStream(EventStream&&) noexcept = default;
+    EventStream& operator=(EventStream&&) noexcept = default;
+    ~EventStream() { Close(); }
+
+    // Callback for Proxy::SubscribeEvent feeding this stream (it may outlive the stream).
+    // An EventStream<Payload> keeps the views the binding delivers: owning views
+    // are shared without a copy (decoders and reassemblers never reuse a buffer a
+    // view still holds), borrowed ones (SHM ring slots) copy their bytes when
+    // stored, so a notification read long after it arrived is intact.
+    std::function<void(const Payload&)> Sink(EventId event) const {
+        std::shared_ptr<State> st = st_;
+        return [st, event](const Payload& data) {
+            T v;
+            if (!ser::Decode(data, v)) {
+                ARA_LOG_WARN("[Client] Malformed payload for event 0x{:x}", event);
+                return;
+            }
+            st->Push(std::move(v));
+        };
+    }
+
+    // Deliver v to the stream (what Sink does for each notification)
+    void Push(T v) { st_->Push(std::move(v)); }
+
+    // Stop the stream: a coroutine waiting in Next() resumes with nothing
+    void Close() {
+        if (st_) st_->Close();
+    }
+
+    struct NextAwaiter {
+        std::shared_ptr<State> st;
+        std::optional<T> value;
+
+        bool await_ready() {
+            std::lock_guard<std::mutex> lk(st->mu);
+            return Take() || st->closed;
+        }
+        template <typename P>
+        bool await_suspend(std::coroutine_handle<P> h) {
+            std::lock_guard<std::mutex> lk(st->mu);
+            if (Take() || st->closed) return false;
+            st->waiter = h;
+            st->waiterExec = h.promise().exec;
+            st->slot = &value;
+            return true;
+        }
+        std::optional<T> await_resume() { return std::move(value); }
+
+    private:
+        bool Take() {
+            if (st->items.empty()) return false;
+            value.emplace(std::move(st->items.front()));
+            st->items.pop_front();
+            return true;
+        }
+    };
+
+    // Next notification, waiting for one if none is buffered
+    NextAwaiter Next() { return NextAwaiter{st_, std::nullopt}; }
+
+    // Notifications dropped because the buffer was full
+    uint64_t Dropped() const {
+        std::lock_guard<std::mutex> lk(st_->mu);
+        return st_->dropped;
+    }
+
+private:
+    std::shared_ptr<State> st_;
+};
+
+// Subscribe to event and receive its notifications as a stream of payloads
+inline EventStream<Payload> Subscribe(Proxy& proxy, EventId event, size_t capacity = 64) {
+    EventStream<Payload> s(capacity);
+    proxy.SubscribeEvent(event, s.Sink(event));
+    return s;
+}
+
+// Typed variant: each notification is decoded into an E::Type
+template <typename E>
+EventStream<typename E::Type> Subscribe(Proxy& proxy, size_t capacity = 64) {
+    EventStream<typename E::Type> s(capacity);
+    proxy.SubscribeEvent(E::kId, s.Sink(E::kId));
+    return s;
+}
+
+} // namespace coro
+} // namespace com
+} // namespace ara
@@ -4,14 +4,17 @@
 #include <functional>
 #include <atomic>
 #include <thread>
-#include <iostream>
 #include <vector>
+#include <cstdlib>
+#include "AraLog.h"
 
 
 /**
  * Standardized: ara::exec instead of ara::excev.
  * - API remains the same as previous ApplicationClient.
  * - Macro EXCEV_SIMULATE_CRASH for demo auto-crash after 5s (off by default).
+ * - Under a process supervisor (ARA_EXEC_SUPERVISED set) a crash aborts the
+ *   process and the supervisor respawns it instead of an in-process restart.
  * - ara::excev alias for backward compatibility.
  */
 namespace ara {
@@ -33,7 +36,7 @@ public:
 
     // Register the application
     bool RegisterApplication() {
-        std::cout << "[ExecM] Register app: " << app_id_ << std::endl;
+        ARA_LOG_INFO("[ExecM] Register app: {}", app_id_);
         state_ = AppState::kRegistered;
         return true;
     }
@@ -43,7 +46,7 @@ public:
 
     // Start the application
     void Start() {
-        std::cout << "[ExecM] Start app: " << app_id_ << std::endl;
+        ARA_LOG_INFO("[ExecM] Start app: {}", app_id_);
         state_ = AppState::kRunning;
 
 #if defined(EXCEV_SIMULATE_CRASH)
@@ -51,11 +54,7 @@ public:
         monitor_thread_ = std::thread([this]() {
             using namespace std::chrono_literals;
             std::this_thread::sleep_for(5s);
-            if (state_ == AppState::kRunning) {
-                std::cerr << "[ExecM] Crash detected in app " << app_id_ << std::endl;
-                state_ = AppState::kCrashed;
-                if (auto_restart_) Restart();
-            }
+            if (state_ == AppState::kRunning) Crash();
         });
         monitor_thread_.detach();
 #endif
@@ -63,24 +62,31 @@ public:
 
     // Stop the application
     void Stop() {
-        std::cout << "[ExecM] Stop app: " << app_id_ << std::endl;
+        ARA_LOG_INFO("[ExecM] Stop app: {}", app_id_);
         state_ = AppState::kStopped;
         if (stop_handler_) stop_handler_();
     }
 
     // Restart the application
     void Restart() {
-        std::cout << "[ExecM] Restarting app: " << app_id_ << std::endl;
+        ARA_LOG_INFO("[ExecM] Restarting app: {}", app_id_);
         Stop();
         Start();
     }
 
     // Allow intentional crash from business logic thread
     void Crash() {
-        std::cerr << "[ExecM] Crash detected in " << app_id_ << std::endl;
+        ARA_LOG_ERROR("[ExecM] Crash detected in {}", app_id_);
         state_ = AppState::kCrashed;
+        if (Supervised()) {
+            ara::log::Logger::Instance().Flush();
+            std::abort();
+        }
         if (auto_restart_) Restart();
     }
+
+    // True when launched by ProcessSupervisor
+    static bool Supervised() { return std::getenv("ARA_EXEC_SUPERVISED") != nullptr; }
     // NEW: Check if APP_MODE is in modes; if not, warn & fallback
     static std::string ValidateMode(const std::string& requested,
                                     const std::string& fallback,
@@ -93,9 +99,8 @@ public:
         for (const auto& m : modes) {
             if (m == requested) return requested;
         }
-        std::cerr << "[Manifest][WARN] APP_MODE=\"" << requested
-                << "\" is not in applicationModeDeclarations. "
-                << "Fallback to defaultMode=\"" << fallback << "\"\n";
+        ARA_LOG_WARN("[Manifest][WARN] APP_MODE=\"{}\" is not in applicationModeDeclarations. "
+                     "Fallback to defaultMode=\"{}\"", requested, fallback);
         return fallback;
     }
 
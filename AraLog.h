@@ -0,0 +1,518 @@
+// AraLog.h - Asynchronous binary logger
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+#include <unistd.h>
+
+/**
+ * Logging without the stream lock or a flush on the calling thread:
+ * - ARA_LOG_INFO("[Server] Calibrate called with: {} (mode={})", cfg, mode);
+ *   The format string is checked against the argument count at compile time
+ *   and registered once per call site; a call only copies a site ID, a
+ *   timestamp and the binary-encoded arguments into a per-thread lock-free ring.
+ * - A background writer drains the rings. By default it formats the records
+ *   as text (Info/Debug to stdout, Warn/Error to stderr); with ARA_LOG_FILE
+ *   set it appends the raw binary records to that file instead, for the
+ *   offline decoder (tools/log_decode). "%p" in the path is replaced by the
+ *   process ID; every process start appends a new session to the file.
+ * - Placeholders: {} and {:x} (hex). Every '{' starts a placeholder.
+ * - A full ring drops the record (counted) rather than block the caller.
+ * - ARA_LOG_LEVEL=debug|info|warn|error sets the minimum level.
+ */
+namespace ara {
+namespace log {
+
+enum class Level : uint8_t { kDebug, kInfo, kWarn, kError };
+
+inline const char* ToString(Level l) {
+    switch (l) {
+    case Level::kDebug: return "DEBUG";
+    case Level::kInfo:  return "INFO";
+    case Level::kWarn:  return "WARN";
+    case Level::kError: return "ERROR";
+    }
+    return "?";
+}
+
+// Argument encodings; a site stores one tag per argument
+enum Tag : uint8_t { kI64, kU64, kF64, kBool, kChar, kStr };
+
+// One logging statement of the source
+struct Site {
+    Level level;
+    const char* fmt;
+    const char* file;
+    int line;
+    std::vector<uint8_t> tags;
+};
+
+// Number of placeholders in a format string (compile time)
+constexpr size_t CountPlaceholders(const char* f) {
+    size_t n = 0;
+    for (; *f; ++f) {
+        if (*f == '{') ++n;
+    }
+    return n;
+}
+
+namespace detail {
+
+template <typename T, typename = void>
+struct Codec; // unsupported argument type
+
+template <typename T>
+struct Codec<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value &&
+                                        !std::is_same<T, char>::value>::type> {
+    static constexpr Tag kTag = kI64;
+    static size_t Size(T) { return 8; }
+    static void Put(uint8_t*& p, T v) { const int64_t x = v; std::memcpy(p, &x, 8); p += 8; }
+};
+
+template <typename T>
+struct Codec<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                                        !std::is_same<T, bool>::value>::type> {
+    static constexpr Tag kTag = kU64;
+    static size_t Size(T) { return 8; }
+    static void Put(uint8_t*& p, T v) { const uint64_t x = v; std::memcpy(p, &x, 8); p += 8; }
+};
+
+template <typename T>
+struct Codec<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static constexpr Tag kTag = kF64;
+    static size_t Size(T) { return 8; }
+    static void Put(uint8_t*& p, T v) { const double x = v; std::memcpy(p, &x, 8); p += 8; }
+};
+
+template <>
+struct Codec<bool> {
+    static constexpr Tag kTag = kBool;
+    static size_t Size(bool) { return 1; }
+    static void Put(uint8_t*& p, bool v) { *p++ = v ? 1 : 0; }
+};
+
+template <>
+struct Codec<char> {
+    static constexpr Tag kTag = kChar;
+    static size_t Size(char) { return 1; }
+    static void Put(uint8_t*& p, char v) { *p++ = static_cast<uint8_t>(v); }
+};
+
+// Strings are copied (u32 length + bytes), so the caller's buffer may go away
+struct StrCodec {
+    static constexpr Tag kTag = kStr;
+    static size_t Len(const char* s) { return s ? std::strlen(s) : 0; }
+    static void PutBytes(uint8_t*& p, const char* s, size_t n) {
+        const uint32_t len = static_cast<uint32_t>(n);
+        std::memcpy(p, &len, 4);
+        if (n) std::memcpy(p + 4, s, n);
+        p += 4 + n;
+    }
+};
+
+template <>
+struct Codec<const char*> : StrCodec {
+    static size_t Size(const char* s) { return 4 + Len(s); }
+    static void Put(uint8_t*& p, const char* s) { PutBytes(p, s, Len(s)); }
+};
+
+template <>
+struct Codec<char*> : Codec<const char*> {};
+
+template <>
+struct Codec<std::string> : StrCodec {
+    static size_t Size(const std::string& s) { return 4 + s.size(); }
+    static void Put(uint8_t*& p, const std::string& s) { PutBytes(p, s.data(), s.size()); }
+};
+
+template <typename T>
+using CodecOf = Codec<typename std::decay<T>::type>;
+
+inline size_t SizeOf() { return 0; }
+template <typename A, typename... R>
+size_t SizeOf(const A& a, const R&... r) { return CodecOf<A>::Size(a) + SizeOf(r...); }
+
+inline void PutAll(uint8_t*&) {}
+template <typename A, typename... R>
+void PutAll(uint8_t*& p, const A& a, const R&... r) {
+    CodecOf<A>::Put(p, a);
+    PutAll(p, r...);
+}
+
+template <typename T>
+T Read(const uint8_t*& p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    p += sizeof(T);
+    return v;
+}
+
+} // namespace detail
+
+// Render the binary arguments of one record with its site's format string.
+// False if the argument bytes do not match the site (truncated record).
+inline bool Format(const Site& site, const uint8_t* args, size_t len, std::string& out) {
+    const uint8_t* p = args;
+    const uint8_t* end = args + len;
+    size_t arg = 0;
+    for (const char* f = site.fmt; *f; ++f) {
+        if (*f != '{') {
+            out += *f;
+            continue;
+        }
+        const char* close = std::strchr(f, '}');
+        if (!close) { out += f; break; }
+        const bool hex = close - f == 3 && f[1] == ':' && f[2] == 'x';
+        f = close;
+        if (arg >= site.tags.size()) { out += "{?}"; continue; }
+        char buf[32];
+        switch (site.tags[arg++]) {
+        case kI64:
+            if (end - p < 8) return false;
+            std::snprintf(buf, sizeof(buf), hex ? "%llx" : "%lld",
+                          static_cast<long long>(detail::Read<int64_t>(p)));
+            out += buf;
+            break;
+        case kU64:
+            if (end - p < 8) return false;
+            std::snprintf(buf, sizeof(buf), hex ? "%llx" : "%llu",
+                          static_cast<unsigned long long>(detail::Read<uint64_t>(p)));
+            out += buf;
+            break;
+        case kF64:
+            if (end - p < 8) return false;
+            std::snprintf(buf, sizeof(buf), "%g", detail::Read<double>(p));
+            out += buf;
+            break;
+        case kBool:
+            if (end - p < 1) return false;
+            out += *p++ ? "true" : "false";
+            break;
+        case kChar:
+            if (end - p < 1) return false;
+            out += static_cast<char>(*p++);
+            break;
+        case kStr: {
+            if (end - p < 4) return false;
+            const uint32_t n = detail::Read<uint32_t>(p);
+            if (static_cast<size_t>(end - p) < n) return false;
+            out.append(reinterpret_cast<const char*>(p), n);
+            p += n;
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+// Layout of the ARA_LOG_FILE output, also read by tools/log_decode:
+//   "ARALOG01"  starts a session (site IDs are per session)
+//   'S' u32 id, u8 level, u8 nargs, u8 tags[nargs], u32 line, u16 n, file[n], u16 n, fmt[n]
+//   'L' u32 id, u64 unix time ns, u32 n, args[n]
+//   'D' u64 records dropped since the previous 'D'
+constexpr char kFileMagic[8] = {'A', 'R', 'A', 'L', 'O', 'G', '0', '1'};
+
+// Single-producer/single-consumer byte ring of one thread. A record is
+// [u32 len][u32 site][u64 time][args] and never wraps: a length of 0 (or
+// fewer than 4 bytes before the end) sends the reader back to offset 0.
+class Ring {
+public:
+    static constexpr size_t kBytes = 1 << 16;
+    static constexpr size_t kHeader = 16;
+
+    // Producer side; false (and counted) if the record does not fit
+    template <typename... Args>
+    bool Push(uint32_t site, uint64_t ns, const Args&... args) {
+        const size_t total = kHeader + detail::SizeOf(args...);
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        size_t off = tail & (kBytes - 1);
+        const size_t toEnd = kBytes - off;
+        const size_t need = total + (toEnd < total ? toEnd : 0);
+        if (total > kBytes / 2 || kBytes - (tail - head) < need) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint64_t at = tail;
+        if (toEnd < total) {
+            if (toEnd >= 4) std::memset(buf_ + off, 0, 4);
+            at += toEnd;
+            off = 0;
+        }
+        uint8_t* p = buf_ + off;
+        const uint32_t len = static_cast<uint32_t>(total);
+        std::memcpy(p, &len, 4);
+        std::memcpy(p + 4, &site, 4);
+        std::memcpy(p + 8, &ns, 8);
+        p += kHeader;
+        detail::PutAll(p, args...);
+        tail_.store(at + total, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: fn(site, ns, args, argLen) per record; returns records read
+    template <typename F>
+    size_t Drain(F&& fn) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        size_t n = 0;
+        while (head != tail) {
+            const size_t off = head & (kBytes - 1);
+            const size_t toEnd = kBytes - off;
+            uint32_t len = 0;
+            if (toEnd >= 4) std::memcpy(&len, buf_ + off, 4);
+            if (len == 0) {
+                head += toEnd;
+                continue;
+            }
+            uint32_t site;
+            uint64_t ns;
+            std::memcpy(&site, buf_ + off + 4, 4);
+            std::memcpy(&ns, buf_ + off + 8, 8);
+            fn(site, ns, buf_ + off + kHeader, len - kHeader);
+            head += len;
+            ++n;
+        }
+        head_.store(head, std::memory_order_release);
+        return n;
+    }
+
+    size_t Used() const {
+        return static_cast<size_t>(tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed));
+    }
+    uint64_t TakeDropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+    std::atomic<bool> retired{false}; // owning thread exited; freed once drained
+
+private:
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+    uint8_t buf_[kBytes];
+};
+
+// Process-wide logger: site registry, per-thread rings and the writer thread.
+// Never destroyed, so threads that log during exit never see a dead logger;
+// an atexit hook drains what is left.
+class Logger {
+public:
+    static Logger& Instance() {
+        static Logger* inst = new Logger;
+        return *inst;
+    }
+
+    Level MinLevel() const { return static_cast<Level>(minLevel_.load(std::memory_order_relaxed)); }
+    void SetLevel(Level l) { minLevel_.store(static_cast<uint8_t>(l), std::memory_order_relaxed); }
+
+    // Register a call site; its ID indexes sites_
+    uint32_t Register(Level level, const char* fmt, const char* file, int line, std::vector<uint8_t> tags) {
+        std::lock_guard<std::mutex> lk(mu_);
+        sites_.push_back(std::unique_ptr<Site>(new Site{level, fmt, file, line, std::move(tags)}));
+        return static_cast<uint32_t>(sites_.size() - 1);
+    }
+
+    template <typename... Args>
+    void Write(uint32_t site, const Args&... args) {
+        Ring& r = LocalRing();
+        const uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        r.Push(site, ns, args...);
+        // Wake the writer early only when the ring is filling up
+        if (r.Used() > Ring::kBytes / 2) cv_.notify_one();
+    }
+
+    // Write out everything logged so far (e.g. before abort())
+    void Flush() {
+        std::lock_guard<std::mutex> lk(drainMu_);
+        DrainAll();
+    }
+
+private:
+    Logger() {
+        if (const char* lvl = std::getenv("ARA_LOG_LEVEL")) {
+            const std::string s(lvl);
+            if (s == "debug") SetLevel(Level::kDebug);
+            else if (s == "warn") SetLevel(Level::kWarn);
+            else if (s == "error") SetLevel(Level::kError);
+        }
+        if (const char* env = std::getenv("ARA_LOG_FILE")) {
+            std::string path(env);
+            const size_t pid = path.find("%p");
+            if (pid != std::string::npos) path.replace(pid, 2, std::to_string(getpid()));
+            file_ = std::fopen(path.c_str(), "ab");
+            if (!file_) {
+                std::fprintf(stderr, "[Log] Cannot open ARA_LOG_FILE=%s, logging as text\n", path.c_str());
+            } else {
+                std::fwrite(kFileMagic, 1, sizeof(kFileMagic), file_);
+            }
+        }
+        writer_ = std::thread([this] { WriterLoop(); });
+        writer_.detach();
+        std::atexit([] { Logger::Instance().Flush(); });
+    }
+
+    // Ring of the calling thread, created on its first log call
+    Ring& LocalRing() {
+        struct Holder {
+            std::shared_ptr<Ring> ring;
+            ~Holder() { if (ring) ring->retired.store(true, std::memory_order_release); }
+        };
+        static thread_local Holder h;
+        if (!h.ring) {
+            h.ring = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> lk(mu_);
+            rings_.push_back(h.ring);
+        }
+        return *h.ring;
+    }
+
+    void WriterLoop() {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                cv_.wait_for(lk, std::chrono::milliseconds(10));
+            }
+            std::lock_guard<std::mutex> lk(drainMu_);
+            DrainAll();
+        }
+    }
+
+    // Caller holds drainMu_. Records of one pass are emitted in timestamp
+    // order, so lines of different threads interleave as they happened.
+    void DrainAll() {
+        std::vector<std::shared_ptr<Ring>> rings;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            rings = rings_;
+        }
+        uint64_t dropped = 0;
+        batch_.clear();
+        bytes_.clear();
+        for (auto& r : rings) {
+            const bool retired = r->retired.load(std::memory_order_acquire);
+            r->Drain([this](uint32_t site, uint64_t ns, const uint8_t* args, size_t len) {
+                batch_.push_back(Pending{ns, site, bytes_.size(), len});
+                bytes_.insert(bytes_.end(), args, args + len);
+            });
+            dropped += r->TakeDropped();
+            if (retired) {
+                std::lock_guard<std::mutex> lk(mu_);
+                rings_.erase(std::remove(rings_.begin(), rings_.end(), r), rings_.end());
+            }
+        }
+        std::stable_sort(batch_.begin(), batch_.end(),
+                         [](const Pending& a, const Pending& b) { return a.ns < b.ns; });
+        for (const Pending& p : batch_) Emit(p.site, p.ns, bytes_.data() + p.off, p.len);
+        if (dropped) {
+            if (file_) {
+                std::fputc('D', file_);
+                std::fwrite(&dropped, 8, 1, file_);
+            } else {
+                std::fprintf(stderr, "[Log] %llu records dropped (ring full)\n",
+                             static_cast<unsigned long long>(dropped));
+            }
+        }
+        if (file_) std::fflush(file_);
+        std::fflush(stdout);
+        std::fflush(stderr);
+    }
+
+    // Caller holds drainMu_
+    void Emit(uint32_t id, uint64_t ns, const uint8_t* args, size_t len) {
+        const Site* site;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (id >= sites_.size()) return;
+            site = sites_[id].get(); // sites are never removed
+        }
+        if (file_) {
+            if (written_.insert(id).second) WriteSite(id, *site);
+            const uint32_t n = static_cast<uint32_t>(len);
+            std::fputc('L', file_);
+            std::fwrite(&id, 4, 1, file_);
+            std::fwrite(&ns, 8, 1, file_);
+            std::fwrite(&n, 4, 1, file_);
+            std::fwrite(args, 1, len, file_);
+            return;
+        }
+        line_.clear();
+        if (!Format(*site, args, len, line_)) line_ += " <truncated>";
+        line_ += '\n';
+        std::fwrite(line_.data(), 1, line_.size(), site->level >= Level::kWarn ? stderr : stdout);
+    }
+
+    void WriteSite(uint32_t id, const Site& s) {
+        const uint8_t level = static_cast<uint8_t>(s.level);
+        const uint8_t nargs = static_cast<uint8_t>(s.tags.size());
+        const uint32_t line = static_cast<uint32_t>(s.line);
+        const uint16_t fileLen = static_cast<uint16_t>(std::strlen(s.file));
+        const uint16_t fmtLen = static_cast<uint16_t>(std::strlen(s.fmt));
+        std::fputc('S', file_);
+        std::fwrite(&id, 4, 1, file_);
+        std::fwrite(&level, 1, 1, file_);
+        std::fwrite(&nargs, 1, 1, file_);
+        std::fwrite(s.tags.data(), 1, nargs, file_);
+        std::fwrite(&line, 4, 1, file_);
+        std::fwrite(&fileLen, 2, 1, file_);
+        std::fwrite(s.file, 1, fileLen, file_);
+        std::fwrite(&fmtLen, 2, 1, file_);
+        std::fwrite(s.fmt, 1, fmtLen, file_);
+    }
+
+    std::atomic<uint8_t> minLevel_{static_cast<uint8_t>(Level::kInfo)};
+    std::mutex mu_;                 // sites_, rings_; the writer sleeps on cv_
+    std::condition_variable cv_;
+    std::vector<std::unique_ptr<Site>> sites_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::mutex drainMu_;            // one drainer at a time (writer or Flush)
+    std::FILE* file_{nullptr};      // binary output (ARA_LOG_FILE), else text
+    std::unordered_set<uint32_t> written_; // sites already described in file_
+    std::string line_;
+    struct Pending {
+        uint64_t ns;
+        uint32_t site;
+        size_t off; // into bytes_
+        size_t len;
+    };
+    std::vector<Pending> batch_;    // records of the current drain pass
+    std::vector<uint8_t> bytes_;
+    std::thread writer_;
+};
+
+// Used by the ARA_LOG macros: registers the site on the first call (one per
+// call site, as SiteTag is a distinct lambda type each time) and checks the
+// placeholder count at compile time
+template <size_t Placeholders, typename SiteTag, typename... Args>
+void Write(Level level, const char* fmt, const char* file, int line, SiteTag, const Args&... args) {
+    static_assert(Placeholders == sizeof...(Args), "log format placeholders do not match the arguments");
+    Logger& lg = Logger::Instance();
+    if (level < lg.MinLevel()) return;
+    static const uint32_t site =
+        lg.Register(level, fmt, file, line, std::vector<uint8_t>{detail::CodecOf<Args>::kTag...});
+    lg.Write(site, args...);
+}
+
+} // namespace log
+} // namespace ara
+
+#define ARA_LOG(level, fmt, ...)                                                                  \
+    ::ara::log::Write<::ara::log::CountPlaceholders(fmt)>(level, fmt, __FILE__, __LINE__, [] {}, \
+                                                          ##__VA_ARGS__)
+#define ARA_LOG_DEBUG(fmt, ...) ARA_LOG(::ara::log::Level::kDebug, fmt, ##__VA_ARGS__)
+#define ARA_LOG_INFO(fmt, ...)  ARA_LOG(::ara::log::Level::kInfo, fmt, ##__VA_ARGS__)
+#define ARA_LOG_WARN(fmt, ...)  ARA_LOG(::ara::log::Level::kWarn, fmt, ##__VA_ARGS__)
+#define ARA_LOG_ERROR(fmt, ...) ARA_LOG(::ara::log::Level::kError, fmt, ##__VA_ARGS__)
@@ -0,0 +1,71 @@
+// ComFactory.h - Pick the transport binding of a service from configuration
+#pragma once
+#include "SomeipBinding.h"
+#include "ShmBinding.h"
+#include "Manifest.h"
+#include "AraLog.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ara {
+namespace com {
+
+enum class Transport { kSomeip, kShm };
+
+// "someip" | "shm"; anything else falls back to SOME/IP
+inline Transport ParseTransport(const std::string& s) {
+    if (s == "shm") return Transport::kShm;
+    if (s != "someip") {
+        ARA_LOG_WARN("[Com] Unknown transport \"{}\", using someip", s);
+    }
+    return Transport::kSomeip;
+}
+
+inline const char* ToString(Transport t) {
+    return t == Transport::kShm ? "shm" : "someip";
+}
+
+// One "serviceBindings" entry of the manifest
+struct ServiceBinding {
+    ServiceId service{0};
+    InstanceIdentifier instance{0};
+    Transport transport{Transport::kSomeip};
+};
+
+// "serviceBindings" of a loaded manifest
+inline std::vector<ServiceBinding> BindingsFromManifest(const manifest::Manifest& m) {
+    std::vector<ServiceBinding> out;
+    if (!m.Valid()) return out;
+    out.reserve(m.NumBindings());
+    for (uint32_t i = 0; i < m.NumBindings(); ++i) {
+        const manifest::Binding b = m.BindingAt(i);
+        out.push_back(ServiceBinding{b.service, b.instance, ParseTransport(b.transport)});
+    }
+    return out;
+}
+
+// Transport configured for Service (SOME/IP if it is not listed)
+template <typename Service>
+Transport TransportFor(const std::vector<ServiceBinding>& bindings) {
+    for (const auto& b : bindings) {
+        if (b.service == Service::kServiceId && b.instance == Service::kInstanceId) return b.transport;
+    }
+    return Transport::kSomeip;
+}
+
+template <typename Service>
+std::unique_ptr<Skeleton> MakeSkeleton(Transport t, const std::string& name,
+                                       std::function<void(const Message&)> cb) {
+    if (t == Transport::kShm) return std::unique_ptr<Skeleton>(new ShmSkeleton<Service>(name, cb));
+    return std::unique_ptr<Skeleton>(new SomeipSkeleton<Service>(name, cb));
+}
+
+template <typename Service>
+std::unique_ptr<Proxy> MakeProxy(Transport t, const std::string& name) {
+    if (t == Transport::kShm) return std::unique_ptr<Proxy>(new ShmProxy<Service>(name));
+    return std::unique_ptr<Proxy>(new SomeipProxy<Service>(name));
+}
+
+} // namespace com
+} // namespace ara
@@ -0,0 +1,178 @@
+// EventBatcher.h
+#pragma once
+#include "AraCom_Skeleton.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ara {
+namespace com {
+
+// Batch frame layout: repeated records of [uint32 length, big endian][length bytes]
+inline void AppendRecord(std::vector<uint8_t>& frame, const uint8_t* data, size_t size) {
+    const uint32_t len = static_cast<uint32_t>(size);
+    const uint8_t hdr[4] = {uint8_t(len >> 24), uint8_t(len >> 16), uint8_t(len >> 8), uint8_t(len)};
+    frame.insert(frame.end(), hdr, hdr + 4);
+    frame.insert(frame.end(), data, data + size);
+}
+
+// Call fn(Payload) for every record of a batch frame; records are views into
+// the frame (no copy). Returns false if the frame is truncated.
+template <typename F>
+bool ForEachRecord(const Payload& frame, F&& fn) {
+    size_t off = 0;
+    while (off < frame.size()) {
+        if (frame.size() - off < 4) return false;
+        const uint8_t* p = frame.data() + off;
+        const size_t len = (size_t(p[0]) << 24) | (size_t(p[1]) << 16) | (size_t(p[2]) << 8) | p[3];
+        off += 4;
+        if (frame.size() - off < len) return false;
+        fn(frame.Slice(off, len));
+        off += len;
+    }
+    return true;
+}
+
+// Per-event batching limits: a batch is flushed when its oldest record is
+// window old or when it reaches maxBytes, whichever comes first
+struct BatchConfig {
+    std::chrono::microseconds window{1000};
+    size_t maxBytes{1400}; // fits one UDP datagram on a 1500 byte MTU
+};
+
+// Collects notifications per slot (one slot per batched event) and hands full
+// or expired frames to flush. One timer thread serves all slots.
+class EventBatcher {
+public:
+    using Clock = std::chrono::steady_clock;
+    using FlushFn = std::function<void(size_t slot, const uint8_t* data, size_t size)>;
+
+    EventBatcher(size_t slots, FlushFn flush) : flush_(std::move(flush)) {
+        for (size_t i = 0; i < slots; ++i) slots_.emplace_back(new Slot);
+        timer_ = std::thread([this] { TimerLoop(); });
+    }
+
+    ~EventBatcher() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (timer_.joinable()) timer_.join();
+        FlushAll();
+    }
+
+    void Configure(size_t slot, BatchConfig cfg) {
+        std::lock_guard<std::mutex> lk(slots_[slot]->mu);
+        slots_[slot]->cfg = cfg;
+        slots_[slot]->frame.reserve(cfg.maxBytes + 64);
+    }
+
+    // Append one notification to the slot's batch
+    void Add(size_t slot, const uint8_t* data, size_t size) {
+        Slot& s = *slots_[slot];
+        bool arm = false;
+        Clock::time_point deadline;
+        {
+            std::lock_guard<std::mutex> lk(s.mu);
+            // Keep a batch within budget: flush what is there before overflowing it
+            if (s.records > 0 && s.frame.size() + 4 + size > s.cfg.maxBytes) FlushLocked(slot, s);
+            AppendRecord(s.frame, data, size);
+            ++s.records;
+            if (s.frame.size() >= s.cfg.maxBytes || s.cfg.window.count() == 0) {
+                FlushLocked(slot, s);
+            } else if (s.records == 1) {
+                s.deadline = Clock::now() + s.cfg.window;
+                deadline = s.deadline;
+                arm = true;
+            }
+        }
+        if (arm) {
+            std::lock_guard<std::mutex> lk(mu_);
+            const bool earliest = timers_.empty() || deadline < timers_.top().first;
+            timers_.emplace(deadline, slot);
+            if (earliest) cv_.notify_one();
+        }
+    }
+
+    void Flush(size_t slot) {
+        Slot& s = *slots_[slot];
+        std::lock_guard<std::mutex> lk(s.mu);
+        FlushLocked(slot, s);
+    }
+
+    void FlushAll() {
+        for (size_t i = 0; i < slots_.size(); ++i) Flush(i);
+    }
+
+    uint64_t Batches() const { return batches_.load(std::memory_order_relaxed); }
+    uint64_t Records() const { return records_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::mutex mu;
+        std::vector<uint8_t> frame; // capacity is kept across flushes
+        size_t records{0};
+        Clock::time_point deadline;
+        BatchConfig cfg;
+    };
+
+    void FlushLocked(size_t slot, Slot& s) {
+        if (s.records == 0) return;
+        flush_(slot, s.frame.data(), s.frame.size());
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        records_.fetch_add(s.records, std::memory_order_relaxed);
+        s.frame.clear();
+        s.records = 0;
+    }
+
+    // Flush batches whose window expired; sleeps until the earliest deadline
+    void TimerLoop() {
+        std::unique_lock<std::mutex> lk(mu_);
+        while (!stopping_) {
+            if (timers_.empty()) {
+                cv_.wait(lk);
+                continue;
+            }
+            const auto next = timers_.top().first;
+            if (cv_.wait_until(lk, next) != std::cv_status::timeout && Clock::now() < next) continue;
+            const auto now = Clock::now();
+            std::vector<size_t> due;
+            while (!timers_.empty() && timers_.top().first <= now) {
+                due.push_back(timers_.top().second);
+                timers_.pop();
+            }
+            lk.unlock();
+            for (size_t slot : due) {
+                Slot& s = *slots_[slot];
+                std::lock_guard<std::mutex> sl(s.mu);
+                // A size-triggered flush may already have sent this batch
+                if (s.records > 0 && s.deadline <= now) FlushLocked(slot, s);
+            }
+            lk.lock();
+        }
+    }
+
+    using Timer = std::pair<Clock::time_point, size_t>;
+
+    FlushFn flush_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    bool stopping_{false};
+    std::thread timer_;
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> records_{0};
+};
+
+} // namespace com
+} // namespace ara
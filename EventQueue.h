@@ -0,0 +1,217 @@
+// EventQueue.h - Bounded hand-off of event notifications to a consumer thread
+#pragma once
+#include "AraCom_Skeleton.h"
+#include "Metrics.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace ara {
+namespace com {
+
+// Bounded multi-producer / multi-consumer ring (Vyukov). Every cell carries a
+// sequence number saying whose turn it is, so a push or pop is one CAS on the
+// shared position followed by plain accesses to the claimed cell. Capacity is
+// rounded up to a power of two.
+template <typename T>
+class BoundedQueue {
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+public:
+    explicit BoundedQueue(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) n <<= 1;
+        mask_ = n - 1;
+        cells_.reset(new Cell[n]);
+        for (size_t i = 0; i < n; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Moves v in only on success
+    bool TryPush(T& v) {
+        size_t pos = enqueue_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            const intptr_t dif = static_cast<intptr_t>(c.seq.load(std::memory_order_acquire)) -
+                                 static_cast<intptr_t>(pos);
+            if (dif == 0) {
+                if (enqueue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = std::move(v);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false; // full
+            } else {
+                pos = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPop(T& out) {
+        size_t pos = dequeue_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            const intptr_t dif = static_cast<intptr_t>(c.seq.load(std::memory_order_acquire)) -
+                                 static_cast<intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (dequeue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = std::move(c.value);
+                    c.value = T();
+                    c.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false; // empty
+            } else {
+                pos = dequeue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Elements claimed by producers and not yet by consumers (approximate under contention)
+    size_t Size() const {
+        const size_t d = dequeue_.load(std::memory_order_acquire);
+        const size_t e = enqueue_.load(std::memory_order_acquire);
+        return e > d ? e - d : 0;
+    }
+
+    size_t Capacity() const { return mask_ + 1; }
+
+private:
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_{0};
+    // Producer and consumer positions on separate cache lines (padding rather
+    // than alignas: C++14 new ignores over-alignment)
+    char pad0_[64];
+    std::atomic<size_t> enqueue_{0};
+    char pad1_[64];
+    std::atomic<size_t> dequeue_{0};
+    char pad2_[64];
+};
+
+// Notifications of one event on their way from the transport's receive thread
+// to a consumer thread of their own, so a slow callback delays only its own
+// event. When the queue is full the EventDelivery overflow policy decides:
+// drop the oldest queued notification, drop the new one, or make the receive
+// thread wait. Neither side takes a lock unless the other one sleeps. Queue
+// depth (sampled on every push) and drops are recorded in the event's metrics.
+class EventQueue {
+public:
+    using Deliver = std::function<void(const Payload&)>;
+
+    EventQueue(const EventDelivery& cfg, Deliver deliver, EventMetrics& metrics)
+        : ring_(cfg.capacity), overflow_(cfg.overflow), deliver_(std::move(deliver)), metrics_(metrics) {
+        thread_ = std::thread([this] { Run(); });
+    }
+
+    // Delivers what is still queued, then joins the consumer
+    ~EventQueue() { Stop(); }
+
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    // Receive thread: false if p (or, for kDropOldest, nothing) was dropped.
+    // Taking p by value gives a borrowed view its own bytes before it is queued.
+    bool Push(Payload p) {
+        for (;;) {
+            if (stopping_.load(std::memory_order_acquire)) return Dropped(1);
+            if (ring_.TryPush(p)) {
+                metrics_.queueDepth.Record(ring_.Size());
+                Wake(consumerWaiting_, notEmpty_);
+                return true;
+            }
+            switch (overflow_) {
+            case EventDelivery::kDropNewest:
+                return Dropped(1);
+            case EventDelivery::kDropOldest: {
+                Payload old;
+                if (ring_.TryPop(old)) Dropped(1);
+                break; // retry: the consumer may have made room meanwhile
+            }
+            case EventDelivery::kBlock: {
+                std::unique_lock<std::mutex> lk(mu_);
+                producersWaiting_.fetch_add(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                notFull_.wait(lk, [&] { return ring_.Size() < ring_.Capacity() || stopping_.load(); });
+                producersWaiting_.fetch_sub(1);
+                break;
+            }
+            }
+        }
+    }
+
+    // Stop accepting notifications, deliver the queued ones and join the consumer
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stopping_.store(true);
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    size_t Depth() const { return ring_.Size(); }
+    size_t Capacity() const { return ring_.Capacity(); }
+
+private:
+    bool Dropped(uint64_t n) {
+        metrics_.dropped.fetch_add(n, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Signal the other side if it announced it sleeps; the fence orders the
+    // caller's queue operation before the check (pairs with the waiter's
+    // increment, which precedes its own look at the queue)
+    void Wake(const std::atomic<int>& waiting, std::condition_variable& cv) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> lk(mu_);
+        cv.notify_all();
+    }
+
+    void Run() {
+        Payload p;
+        for (;;) {
+            if (ring_.TryPop(p)) {
+                Wake(producersWaiting_, notFull_);
+                deliver_(p);
+                p = Payload(); // release the buffer before waiting
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(mu_);
+            consumerWaiting_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            notEmpty_.wait(lk, [&] { return ring_.Size() > 0 || stopping_.load(); });
+            consumerWaiting_.fetch_sub(1);
+            if (stopping_.load() && ring_.Size() == 0) return;
+        }
+    }
+
+    BoundedQueue<Payload> ring_;
+    const EventDelivery::Overflow overflow_;
+    Deliver deliver_;
+    std::mutex mu_; // only for sleeping and waking
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::atomic<int> consumerWaiting_{0};
+    std::atomic<int> producersWaiting_{0};
+    std::atomic<bool> stopping_{false};
+    EventMetrics& metrics_;
+    std::thread thread_; // last: started once the members above exist
+};
+
+} // namespace com
+} // namespace ara
@@ -0,0 +1,216 @@
+// EventShaper.h
+#pragma once
+#include "AraCom_Skeleton.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace ara {
+namespace com {
+
+// Applies per-subscriber EventPolicy to notifications (one slot per event).
+// While no subscriber of a slot has a policy, Shaped() is false and the
+// binding keeps notifying everyone at once; otherwise Publish() picks the
+// subscribers each notification goes to. One timer thread, started with the
+// first latest-only policy, sends values held back by a rate limit.
+class EventShaper {
+public:
+    using Clock = std::chrono::steady_clock;
+    using ClientId = uint16_t;
+    // Send one notification to n subscribers of slot; shaped tells whether they
+    // have a policy (and so may miss notifications the others get)
+    using SendFn = std::function<void(size_t slot, const ClientId* clients, size_t n, bool shaped,
+                                      const uint8_t* data, size_t size)>;
+
+    EventShaper(size_t slots, SendFn send) : send_(std::move(send)) {
+        for (size_t i = 0; i < slots; ++i) slots_.emplace_back(new Slot);
+    }
+
+    ~EventShaper() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (timer_.joinable()) timer_.join();
+    }
+
+    // Policy of client for slot; kept across unsubscribe/resubscribe
+    void SetPolicy(size_t slot, ClientId client, const EventPolicy& policy) {
+        Slot& s = *slots_[slot];
+        std::lock_guard<std::mutex> lk(s.mu);
+        Sub& u = s.subs[client];
+        const EventPolicy& old = u.policy;
+        if (old.minInterval == policy.minInterval && old.everyNth == policy.everyNth &&
+            old.latestOnly == policy.latestOnly) {
+            return; // repeated when the proxy sees the service again
+        }
+        u.policy = policy;
+        u.seen = 0;
+        u.hasPending = false;
+        UpdateShaped(s);
+    }
+
+    void Subscribe(size_t slot, ClientId client, bool subscribed) {
+        Slot& s = *slots_[slot];
+        std::lock_guard<std::mutex> lk(s.mu);
+        if (subscribed) {
+            s.subs[client].subscribed = true;
+        } else {
+            auto it = s.subs.find(client);
+            if (it == s.subs.end()) return;
+            if (it->second.policy.Unshaped()) {
+                s.subs.erase(it);
+            } else {
+                it->second.subscribed = false; // policy kept for a resubscribe
+                it->second.hasPending = false;
+            }
+        }
+        UpdateShaped(s);
+    }
+
+    // Some subscribed client of slot has a policy: notifications must go through Publish
+    bool Shaped(size_t slot) const { return slots_[slot]->shaped.load(std::memory_order_acquire); }
+
+    // Send one notification to every subscriber of slot whose policy admits it
+    void Publish(size_t slot, const uint8_t* data, size_t size) {
+        Slot& s = *slots_[slot];
+        std::lock_guard<std::mutex> lk(s.mu);
+        const auto now = Clock::now();
+        s.targets.clear();
+        s.shapedTargets.clear();
+        for (auto& kv : s.subs) {
+            Sub& u = kv.second;
+            if (!u.subscribed) continue;
+            const EventPolicy& p = u.policy;
+            if (p.everyNth > 1 && u.seen++ % p.everyNth != 0) {
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (p.minInterval.count() > 0 && now - u.last < p.minInterval) {
+                suppressed_.fetch_add(1, std::memory_order_relaxed);
+                if (p.latestOnly) Hold(slot, kv.first, u, data, size);
+                continue;
+            }
+            u.last = now;
+            u.hasPending = false;
+            (p.Unshaped() ? s.targets : s.shapedTargets).push_back(kv.first);
+        }
+        if (!s.targets.empty()) send_(slot, s.targets.data(), s.targets.size(), false, data, size);
+        if (!s.shapedTargets.empty()) send_(slot, s.shapedTargets.data(), s.shapedTargets.size(), true, data, size);
+        delivered_.fetch_add(s.targets.size() + s.shapedTargets.size(), std::memory_order_relaxed);
+    }
+
+    // Per-subscriber notifications sent / withheld by a policy
+    uint64_t Delivered() const { return delivered_.load(std::memory_order_relaxed); }
+    uint64_t Suppressed() const { return suppressed_.load(std::memory_order_relaxed); }
+
+private:
+    struct Sub {
+        EventPolicy policy;
+        bool subscribed{false};
+        uint64_t seen{0};                 // notifications offered (decimation counter)
+        Clock::time_point last{};         // last notification sent
+        std::vector<uint8_t> pending;     // newest value held back (latestOnly)
+        bool hasPending{false};
+        bool armed{false};                // a timer is queued for pending
+    };
+
+    struct Slot {
+        std::mutex mu;
+        std::map<ClientId, Sub> subs;
+        std::vector<ClientId> targets;       // scratch of Publish: subscribers without a policy...
+        std::vector<ClientId> shapedTargets; // ...and with one
+        std::atomic<bool> shaped{false};
+    };
+
+    // Caller holds s.mu. Only subscribed clients count: a policy kept after
+    // its client unsubscribed does not shape the slot.
+    static void UpdateShaped(Slot& s) {
+        bool shaped = false;
+        for (const auto& kv : s.subs) shaped |= kv.second.subscribed && !kv.second.policy.Unshaped();
+        s.shaped.store(shaped, std::memory_order_release);
+    }
+
+    // Caller holds the slot lock: keep the newest value, send it when the interval ends
+    void Hold(size_t slot, ClientId client, Sub& u, const uint8_t* data, size_t size) {
+        u.pending.assign(data, data + size);
+        u.hasPending = true;
+        if (u.armed) return;
+        u.armed = true;
+        const auto at = u.last + u.policy.minInterval;
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!timer_.joinable()) timer_ = std::thread([this] { TimerLoop(); });
+        const bool earliest = timers_.empty() || at < std::get<0>(timers_.top());
+        timers_.emplace(at, slot, client);
+        if (earliest) cv_.notify_one();
+    }
+
+    // Send held values whose interval ended
+    void Fire(size_t slot, ClientId client) {
+        Slot& s = *slots_[slot];
+        std::lock_guard<std::mutex> lk(s.mu);
+        auto it = s.subs.find(client);
+        if (it == s.subs.end()) return;
+        Sub& u = it->second;
+        u.armed = false;
+        if (!u.subscribed || !u.hasPending) return;
+        const auto now = Clock::now();
+        if (now - u.last < u.policy.minInterval) {
+            // A newer value was sent meanwhile and restarted the interval
+            u.armed = true;
+            std::lock_guard<std::mutex> tl(mu_);
+            timers_.emplace(u.last + u.policy.minInterval, slot, client);
+            return;
+        }
+        u.last = now;
+        u.hasPending = false;
+        send_(slot, &client, 1, true, u.pending.data(), u.pending.size());
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void TimerLoop() {
+        std::unique_lock<std::mutex> lk(mu_);
+        while (!stopping_) {
+            if (timers_.empty()) {
+                cv_.wait(lk);
+                continue;
+            }
+            const auto next = std::get<0>(timers_.top());
+            if (cv_.wait_until(lk, next) != std::cv_status::timeout && Clock::now() < next) continue;
+            const auto now = Clock::now();
+            std::vector<std::pair<size_t, ClientId>> due;
+            while (!timers_.empty() && std::get<0>(timers_.top()) <= now) {
+                due.emplace_back(std::get<1>(timers_.top()), std::get<2>(timers_.top()));
+                timers_.pop();
+            }
+            lk.unlock();
+            for (const auto& d : due) Fire(d.first, d.second);
+            lk.lock();
+        }
+    }
+
+    using Timer = std::tuple<Clock::time_point, size_t, ClientId>;
+
+    SendFn send_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::mutex mu_; // timers_/stopping_/timer_ (taken after a slot lock, never before)
+    std::condition_variable cv_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    bool stopping_{false};
+    std::thread timer_;
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+} // namespace com
+} // namespace ara
@@ -5,8 +5,15 @@
 #include <unordered_map>
 #include <functional>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <chrono>
 #include <iostream>
 #include <algorithm>
+#include "Executor.h"
+#include "AraLog.h"
 
 namespace ara {
 namespace execm { // avoid name clash with ara::exec (ApplicationClient)
@@ -23,8 +30,15 @@ struct AppConfig {
     int maxRestarts{-1};                // -1 = unlimited
     std::string defaultMode{"NormalMode"};
     std::vector<std::string> modes{"NormalMode","DiagnosticMode"};
+    std::vector<std::string> dependsOn; // apps that must be Running before this one starts
 };
 
+inline bool operator==(const AppConfig& a, const AppConfig& b) {
+    return a.appId == b.appId && a.policy == b.policy && a.maxRestarts == b.maxRestarts &&
+           a.defaultMode == b.defaultMode && a.modes == b.modes && a.dependsOn == b.dependsOn;
+}
+inline bool operator!=(const AppConfig& a, const AppConfig& b) { return !(a == b); }
+
 // Application runtime state
 struct AppRuntime {
     AppState state{AppState::kStopped};
@@ -40,8 +54,103 @@ struct AppRegistration {
 };
 
 using StateListener = std::function<void(const std::string& appId, AppState)>;
+using ModeListener  = std::function<void(const std::string& appId, const std::string& mode)>;
+
+// What ExecManager::Reconfigure changed
+struct ConfigDiff {
+    std::vector<std::string> added;   // not registered yet: the caller registers and starts them
+    std::vector<std::string> removed; // no longer configured: stopped and retired
+    std::vector<std::string> updated; // policy/limit/modes/dependencies replaced in place
+    bool Empty() const { return added.empty() && removed.empty() && updated.empty(); }
+};
+
+// One app of a dependency-ordered startup; times are relative to the start of the boot
+struct StartupEntry {
+    std::string appId;
+    std::chrono::microseconds ready{0};   // all dependencies Running, queued for a worker
+    std::chrono::microseconds begin{0};   // startFn called
+    std::chrono::microseconds end{0};     // startFn returned
+    bool started{false};
+    std::string note;                     // why the app was not started
+};
+
+struct StartupTimeline {
+    std::vector<StartupEntry> entries;    // in the order the apps finished
+    std::chrono::microseconds total{0};   // until the last app finished
+};
+
+inline void PrintTimeline(const StartupTimeline& t, std::ostream& os) {
+    auto ms = [](std::chrono::microseconds us) { return us.count() / 1000.0; };
+    for (const auto& e : t.entries) {
+        os << "[ExecMgr][Boot] " << e.appId;
+        if (e.started) {
+            os << " ready=+" << ms(e.ready) << "ms start=+" << ms(e.begin)
+               << "ms running=+" << ms(e.end) << "ms (" << ms(e.end - e.begin) << "ms)\n";
+        } else {
+            os << " not started: " << e.note << "\n";
+        }
+    }
+    os << "[ExecMgr][Boot] total " << ms(t.total) << "ms\n";
+}
+
+// Same report through the asynchronous logger
+inline void LogTimeline(const StartupTimeline& t) {
+    auto ms = [](std::chrono::microseconds us) { return us.count() / 1000.0; };
+    for (const auto& e : t.entries) {
+        if (e.started) {
+            ARA_LOG_INFO("[ExecMgr][Boot] {} ready=+{}ms start=+{}ms running=+{}ms ({}ms)", e.appId,
+                         ms(e.ready), ms(e.begin), ms(e.end), ms(e.end - e.begin));
+        } else {
+            ARA_LOG_WARN("[ExecMgr][Boot] {} not started: {}", e.appId, e.note);
+        }
+    }
+    ARA_LOG_INFO("[ExecMgr][Boot] total {}ms", ms(t.total));
+}
+
+// Unbounded multi-producer / single-consumer queue (Vyukov): a producer links
+// its node in with one atomic exchange, so publishers never wait for each other
+template <typename T>
+class MpscQueue {
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+    std::atomic<Node*> tail_; // last node, swapped by producers
+    Node* head_;              // consumed stub, owned by the consumer
+
+public:
+    MpscQueue() : tail_(new Node), head_(tail_.load()) {}
+    ~MpscQueue() {
+        T v;
+        while (TryPop(v)) {}
+        delete head_;
+    }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
 
-// Main Execution Manager class
+    void Push(T v) {
+        Node* n = new Node;
+        n->value = std::move(v);
+        Node* prev = tail_.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    // Consumer only
+    bool TryPop(T& out) {
+        Node* next = head_->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        out = std::move(next->value);
+        delete head_;
+        head_ = next;
+        return true;
+    }
+};
+
+// Main Execution Manager class.
+// The registry lock mu_ only guards bookkeeping and is never held while app
+// callbacks or listeners run. Lifecycle operations on one app are serialized by
+// that app's own lock, and state changes are delivered to listeners by a
+// dispatcher thread, so a slow app or listener does not stall the others.
 class ExecManager {
 public:
     static ExecManager& Instance() {
@@ -49,41 +158,144 @@ public:
         return inst;
     }
 
+    ~ExecManager() {
+        {
+            std::lock_guard<std::mutex> lk(dmu_);
+            stopping_ = true;
+        }
+        dcv_.notify_all();
+        if (dispatcher_.joinable()) dispatcher_.join();
+    }
+
     // Register app with policy, mode & start/stop callbacks
     bool Register(const AppConfig& cfg,
                   std::function<void()> startFn,
                   std::function<void()> stopFn) {
+        AppEntry* e;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            auto it = apps_.find(cfg.appId);
+            if (it == apps_.end()) {
+                std::unique_ptr<AppEntry> fresh(new AppEntry);
+                fresh->reg.cfg = cfg;
+                fresh->reg.rt.startFn = std::move(startFn);
+                fresh->reg.rt.stopFn  = std::move(stopFn);
+                fresh->reg.rt.activeMode = cfg.defaultMode;
+                fresh->reg.rt.state = AppState::kRegistered;
+                apps_.emplace(cfg.appId, std::move(fresh));
+                Notify(cfg.appId, AppState::kRegistered);
+                return true;
+            }
+            e = it->second.get();
+        }
+        // An app removed by Reconfigure comes back: its entry is reused (entries
+        // are never erased), callbacks are swapped under its lifecycle lock
+        std::lock_guard<std::mutex> op(e->opMu);
         std::lock_guard<std::mutex> lk(mu_);
-        auto it = apps_.find(cfg.appId);
-        if (it != apps_.end()) {
-            std::cerr << "[ExecMgr][WARN] App already registered: " << cfg.appId << "\n";
+        if (!e->retired) {
+            ARA_LOG_WARN("[ExecMgr][WARN] App already registered: {}", cfg.appId);
             return false;
         }
-        AppRegistration reg;
-        reg.cfg = cfg;
-        reg.rt.startFn = std::move(startFn);
-        reg.rt.stopFn  = std::move(stopFn);
-        reg.rt.activeMode = cfg.defaultMode;
-        reg.rt.state = AppState::kRegistered;
-        apps_.emplace(cfg.appId, std::move(reg));
+        e->retired = false;
+        e->reg.cfg = cfg;
+        e->reg.rt = AppRuntime{};
+        e->reg.rt.startFn = std::move(startFn);
+        e->reg.rt.stopFn  = std::move(stopFn);
+        e->reg.rt.activeMode = cfg.defaultMode;
+        e->reg.rt.state = AppState::kRegistered;
         Notify(cfg.appId, AppState::kRegistered);
         return true;
     }
 
-    // Set/validate App Mode; fallback to default if invalid
+    // Bring the registry to the configuration in desired, touching only what
+    // differs: changed configs are replaced in one critical section (a
+    // concurrent OnCrash/SetMode sees either the old or the new config, never a
+    // mix) without stopping or restarting the app; an active mode that is no
+    // longer declared falls back to the new default. New apps are reported in
+    // added for the caller to register and start. With retireMissing, apps
+    // absent from desired are stopped and retired.
+    ConfigDiff Reconfigure(const std::vector<AppConfig>& desired, bool retireMissing = false) {
+        ConfigDiff diff;
+        std::vector<std::pair<std::string, std::string>> modeFallbacks; // appId, new mode
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            for (const auto& cfg : desired) {
+                auto it = apps_.find(cfg.appId);
+                if (it == apps_.end() || it->second->retired) {
+                    diff.added.push_back(cfg.appId);
+                    continue;
+                }
+                AppRegistration& reg = it->second->reg;
+                if (reg.cfg == cfg) continue;
+                reg.cfg = cfg;
+                if (!cfg.modes.empty() &&
+                    std::find(cfg.modes.begin(), cfg.modes.end(), reg.rt.activeMode) == cfg.modes.end()) {
+                    ARA_LOG_WARN("[ExecMgr][WARN] Mode {} of {} is no longer declared, fallback to {}",
+                                 reg.rt.activeMode, cfg.appId, cfg.defaultMode);
+                    reg.rt.activeMode = cfg.defaultMode;
+                    modeFallbacks.emplace_back(cfg.appId, cfg.defaultMode);
+                }
+                diff.updated.push_back(cfg.appId);
+            }
+            if (retireMissing) {
+                for (auto& kv : apps_) {
+                    if (kv.second->retired) continue;
+                    const bool keep = std::any_of(desired.begin(), desired.end(),
+                        [&](const AppConfig& c) { return c.appId == kv.first; });
+                    if (keep) continue;
+                    kv.second->retired = true;
+                    diff.removed.push_back(kv.first);
+                }
+            }
+        }
+        for (const auto& id : diff.updated) {
+            ARA_LOG_INFO("[ExecMgr] Reconfigured {} in place", id);
+        }
+        for (const auto& m : modeFallbacks) NotifyMode(m.first, m.second);
+        for (const auto& id : diff.removed) {
+            ARA_LOG_INFO("[ExecMgr] {} removed from the manifest, stopping it", id);
+            Stop(id);
+        }
+        return diff;
+    }
+
+    // Set/validate App Mode; fallback to default if invalid. Mode listeners run
+    // on the calling thread before SetMode returns, so the app has switched
+    // (e.g. published its handler table) when it does.
     void SetMode(const std::string& appId, const std::string& requested) {
-        std::lock_guard<std::mutex> lk(mu_);
-        auto* reg = Find(appId);
-        if (!reg) return;
-        if (reg->cfg.modes.empty() ||
-            std::find(reg->cfg.modes.begin(), reg->cfg.modes.end(), requested) != reg->cfg.modes.end()) {
-            reg->rt.activeMode = requested;
-            return;
+        std::string mode;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            auto* reg = Find(appId);
+            if (!reg) return;
+            if (reg->cfg.modes.empty() ||
+                std::find(reg->cfg.modes.begin(), reg->cfg.modes.end(), requested) != reg->cfg.modes.end()) {
+                reg->rt.activeMode = requested;
+            } else {
+                ARA_LOG_WARN("[ExecMgr][WARN] APP_MODE=\"{}\" is invalid for {}. Fallback to \"{}\"",
+                             requested, appId, reg->cfg.defaultMode);
+                reg->rt.activeMode = reg->cfg.defaultMode;
+            }
+            mode = reg->rt.activeMode;
         }
-        std::cerr << "[ExecMgr][WARN] APP_MODE=\"" << requested
-                  << "\" is invalid for " << appId
-                  << ". Fallback to \"" << reg->cfg.defaultMode << "\"\n";
-        reg->rt.activeMode = reg->cfg.defaultMode;
+        NotifyMode(appId, mode);
+    }
+
+    // Runtime mode transition: unlike SetMode an undeclared mode is refused
+    // (false, nothing changes). Mode listeners have run when it returns true.
+    bool SwitchMode(const std::string& appId, const std::string& mode) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            auto* reg = Find(appId);
+            if (!reg) return false;
+            if (!reg->cfg.modes.empty() &&
+                std::find(reg->cfg.modes.begin(), reg->cfg.modes.end(), mode) == reg->cfg.modes.end()) {
+                return false;
+            }
+            reg->rt.activeMode = mode;
+        }
+        NotifyMode(appId, mode);
+        return true;
     }
 
     std::string GetMode(const std::string& appId) {
@@ -92,54 +304,236 @@ public:
         return reg->rt.activeMode;
     }
 
-    // Start/Stop controlled by ExecManager, calls app callbacks
+    // Start/Stop controlled by ExecManager, calls app callbacks.
+    // Must not be called from the same app's own start/stop callbacks.
     void Start(const std::string& appId) {
-        std::lock_guard<std::mutex> lk(mu_);
-        auto* reg = Find(appId); if (!reg) return;
-        if (reg->rt.state == AppState::kRunning) return;
-        if (reg->rt.startFn) reg->rt.startFn();
-        reg->rt.state = AppState::kRunning;
-        Notify(appId, AppState::kRunning);
+        AppEntry* e = Lookup(appId); if (!e) return;
+        std::lock_guard<std::mutex> op(e->opMu);
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (e->retired || e->reg.rt.state == AppState::kRunning) return;
+        }
+        if (e->reg.rt.startFn) e->reg.rt.startFn();
+        SetState(*e, AppState::kRunning);
     }
 
     void Stop(const std::string& appId) {
-        std::lock_guard<std::mutex> lk(mu_);
-        auto* reg = Find(appId); if (!reg) return;
-        if (reg->rt.stopFn) reg->rt.stopFn();
-        reg->rt.state = AppState::kStopped;
-        Notify(appId, AppState::kStopped);
+        AppEntry* e = Lookup(appId); if (!e) return;
+        std::lock_guard<std::mutex> op(e->opMu);
+        if (e->reg.rt.stopFn) e->reg.rt.stopFn();
+        SetState(*e, AppState::kStopped);
     }
 
     // App reports crash → ExecManager decides restart based on policy/maxRestarts
     void OnCrash(const std::string& appId) {
-        std::lock_guard<std::mutex> lk(mu_);
-        auto* reg = Find(appId); if (!reg) return;
-        reg->rt.state = AppState::kCrashed;
-        Notify(appId, AppState::kCrashed);
-
-        const bool allow = (reg->cfg.policy == RestartPolicy::kAlways) ||
-                           (reg->cfg.policy == RestartPolicy::kOnFailure);
-        const bool below_limit = (reg->cfg.maxRestarts < 0) ||
-                                 (reg->rt.restartCount < reg->cfg.maxRestarts);
+        AppEntry* e = Lookup(appId); if (!e) return;
+        std::lock_guard<std::mutex> op(e->opMu);
+        bool restart;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            auto& reg = e->reg;
+            const bool allow = (reg.cfg.policy == RestartPolicy::kAlways) ||
+                               (reg.cfg.policy == RestartPolicy::kOnFailure);
+            const bool below_limit = (reg.cfg.maxRestarts < 0) ||
+                                     (reg.rt.restartCount < reg.cfg.maxRestarts);
+            restart = allow && below_limit && !e->retired;
+            if (restart) reg.rt.restartCount++;
+            reg.rt.state = AppState::kCrashed;
+            Notify(appId, AppState::kCrashed);
+        }
 
-        if (allow && below_limit) {
-            reg->rt.restartCount++;
+        if (restart) {
             // restart = stop + start
-            if (reg->rt.stopFn) reg->rt.stopFn();
-            if (reg->rt.startFn) reg->rt.startFn();
-            reg->rt.state = AppState::kRunning;
-            Notify(appId, AppState::kRunning);
+            if (e->reg.rt.stopFn) e->reg.rt.stopFn();
+            if (e->reg.rt.startFn) e->reg.rt.startFn();
+            SetState(*e, AppState::kRunning);
         } else {
-            reg->rt.state = AppState::kTerminated;
-            Notify(appId, AppState::kTerminated);
-            std::cerr << "[ExecMgr] App " << appId << " terminated (policy/limit)\n";
+            SetState(*e, AppState::kTerminated);
+            ARA_LOG_ERROR("[ExecMgr] App {} terminated (policy/limit)", appId);
+        }
+    }
+
+    // State observed outside the app's callbacks (e.g. by ProcessSupervisor
+    // when a supervised process exits or is respawned)
+    void ReportState(const std::string& appId, AppState st) {
+        AppEntry* e = Lookup(appId); if (!e) return;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (st == AppState::kRunning && e->reg.rt.state != AppState::kRunning) e->reg.rt.restartCount++;
+        }
+        SetState(*e, st);
+    }
+
+    // Start every registered app that is not running, in dependency order:
+    // apps whose dependencies are all Running start in parallel on a pool of
+    // `threads` workers (0 = one per CPU). Blocks until all are done.
+    StartupTimeline StartAll(size_t threads = 0) {
+        std::vector<std::string> ids;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            for (const auto& kv : apps_) {
+                if (!kv.second->retired && kv.second->reg.rt.state != AppState::kRunning) ids.push_back(kv.first);
+            }
         }
+        std::sort(ids.begin(), ids.end());
+        return StartGroup(ids, threads);
     }
 
-    // Subscribe to state change events
+    // Same for a subset; dependencies outside the group must already be Running.
+    // Apps in a cycle, with a missing dependency or whose dependency failed are skipped.
+    StartupTimeline StartGroup(const std::vector<std::string>& group, size_t threads = 0) {
+        using Clock = std::chrono::steady_clock;
+        struct Node {
+            size_t waiting{0};                // dependencies not Running yet
+            std::vector<std::string> dependents;
+            Clock::time_point ready;
+        };
+        struct Boot {
+            std::mutex mu;
+            std::condition_variable done;
+            std::unordered_map<std::string, Node> nodes;
+            StartupTimeline timeline;
+            size_t remaining{0};
+            Clock::time_point t0;
+        };
+        auto boot = std::make_shared<Boot>();
+        boot->t0 = Clock::now();
+        auto since = [boot](Clock::time_point t) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(t - boot->t0);
+        };
+
+        std::unordered_map<std::string, std::string> notes; // apps that cannot start, with the reason
+        for (const auto& id : group) boot->nodes[id];
+        for (const auto& id : group) {
+            AppEntry* e = Lookup(id);
+            std::vector<std::string> deps;
+            bool retired = false;
+            if (e) {
+                std::lock_guard<std::mutex> lk(mu_); // Reconfigure may replace cfg
+                deps = e->reg.cfg.dependsOn;
+                retired = e->retired;
+            }
+            if (!e || retired) {
+                notes[id] = "not registered";
+                continue;
+            }
+            for (const auto& dep : deps) {
+                if (boot->nodes.count(dep)) {
+                    boot->nodes[dep].dependents.push_back(id);
+                    boot->nodes[id].waiting++;
+                } else if (GetState(dep) != AppState::kRunning) {
+                    notes[id] = "dependency " + dep + " is not running";
+                }
+            }
+        }
+
+        // Kahn's algorithm on a copy: whatever never becomes ready is part of a cycle
+        {
+            std::unordered_map<std::string, size_t> indeg;
+            std::vector<std::string> ready;
+            for (const auto& kv : boot->nodes) {
+                indeg[kv.first] = kv.second.waiting;
+                if (kv.second.waiting == 0) ready.push_back(kv.first);
+            }
+            while (!ready.empty()) {
+                const std::string id = ready.back();
+                ready.pop_back();
+                for (const auto& d : boot->nodes[id].dependents) {
+                    if (--indeg[d] == 0) ready.push_back(d);
+                }
+            }
+            for (const auto& kv : indeg) {
+                if (kv.second != 0 && !notes.count(kv.first)) notes[kv.first] = "dependency cycle";
+            }
+        }
+
+        com::Executor pool(threads);
+        std::function<void(const std::string&)> launch;
+        // Caller holds boot->mu: record id (and everything depending on it) as not started
+        std::function<void(const std::string&, const std::string&)> skip =
+            [&, boot](const std::string& id, const std::string& why) {
+                auto it = boot->nodes.find(id);
+                if (it == boot->nodes.end()) return;
+                StartupEntry en;
+                en.appId = id;
+                en.note = why;
+                boot->timeline.entries.push_back(en);
+                auto dependents = std::move(it->second.dependents);
+                boot->nodes.erase(it);
+                --boot->remaining;
+                for (const auto& d : dependents) skip(d, "dependency " + id + " did not start");
+            };
+        // Caller holds boot->mu
+        launch = [&, boot](const std::string& id) {
+            boot->nodes[id].ready = Clock::now();
+            pool.Submit([&, boot, id] {
+                StartupEntry en;
+                en.appId = id;
+                const auto begin = Clock::now();
+                try {
+                    Start(id);
+                    en.started = GetState(id) == AppState::kRunning;
+                    if (!en.started) en.note = "start did not reach Running";
+                } catch (const std::exception& ex) {
+                    en.note = std::string("start failed: ") + ex.what();
+                } catch (...) {
+                    en.note = "start failed";
+                }
+                const auto end = Clock::now();
+
+                std::lock_guard<std::mutex> lk(boot->mu);
+                Node& n = boot->nodes[id];
+                en.ready = since(n.ready);
+                en.begin = since(begin);
+                en.end = since(end);
+                boot->timeline.entries.push_back(en);
+                auto dependents = std::move(n.dependents);
+                boot->nodes.erase(id);
+                --boot->remaining;
+                for (const auto& d : dependents) {
+                    if (!en.started) skip(d, "dependency " + id + " did not start");
+                    else if (--boot->nodes[d].waiting == 0) launch(d);
+                }
+                if (boot->remaining == 0) boot->done.notify_all();
+            });
+        };
+
+        std::unique_lock<std::mutex> lk(boot->mu);
+        boot->remaining = boot->nodes.size();
+        for (const auto& kv : notes) skip(kv.first, kv.second);
+        std::vector<std::string> roots;
+        for (const auto& kv : boot->nodes) {
+            if (kv.second.waiting == 0) roots.push_back(kv.first);
+        }
+        for (const auto& id : roots) launch(id);
+        boot->done.wait(lk, [&] { return boot->remaining == 0; });
+        boot->timeline.total = since(Clock::now());
+        return boot->timeline;
+    }
+
+    // Subscribe to state change events; listeners run on the dispatcher thread
+    // (one event at a time, in publication order) and may call back into ExecManager
     void Subscribe(StateListener cb) {
-        std::lock_guard<std::mutex> lk(mu_);
-        listeners_.push_back(std::move(cb));
+        std::lock_guard<std::mutex> lk(listenersMu_);
+        auto next = std::make_shared<std::vector<StateListener>>(*std::atomic_load(&listeners_));
+        next->push_back(std::move(cb));
+        std::atomic_store(&listeners_, std::shared_ptr<const std::vector<StateListener>>(std::move(next)));
+    }
+
+    // Subscribe to mode changes (SetMode, or a fallback after Reconfigure);
+    // listeners run synchronously on the thread that changed the mode
+    void SubscribeMode(ModeListener cb) {
+        std::lock_guard<std::mutex> lk(listenersMu_);
+        auto next = std::make_shared<std::vector<ModeListener>>(*std::atomic_load(&modeListeners_));
+        next->push_back(std::move(cb));
+        std::atomic_store(&modeListeners_, std::shared_ptr<const std::vector<ModeListener>>(std::move(next)));
+    }
+
+    // Block until every state change published so far has reached the listeners
+    void Flush() {
+        const uint64_t target = published_.load();
+        std::unique_lock<std::mutex> lk(dmu_);
+        flushCv_.wait(lk, [&] { return delivered_ >= target; });
     }
 
     AppState GetState(const std::string& appId) {
@@ -149,23 +543,105 @@ public:
     }
 
 private:
-    ExecManager() = default;
+    // Registry entry; opMu serializes lifecycle operations of this app and is
+    // held across its callbacks (mu_ never is)
+    struct AppEntry {
+        std::mutex opMu;
+        AppRegistration reg;
+        bool retired{false}; // removed by Reconfigure; guarded by mu_
+    };
+
+    struct StateEvent {
+        std::string appId;
+        AppState state{AppState::kStopped};
+    };
 
+    ExecManager()
+        : listeners_(std::make_shared<const std::vector<StateListener>>()),
+          modeListeners_(std::make_shared<const std::vector<ModeListener>>()),
+          dispatcher_([this] { DispatchLoop(); }) {}
+
+    // Caller holds mu_
     AppRegistration* Find(const std::string& appId) {
         auto it = apps_.find(appId);
-        return (it == apps_.end()) ? nullptr : &it->second;
+        return (it == apps_.end()) ? nullptr : &it->second->reg;
+    }
+
+    // Entries are never removed, so the pointer stays valid without mu_
+    AppEntry* Lookup(const std::string& appId) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = apps_.find(appId);
+        return (it == apps_.end()) ? nullptr : it->second.get();
     }
 
-    // Notify all listeners of state change
+    void SetState(AppEntry& e, AppState st) {
+        std::lock_guard<std::mutex> lk(mu_);
+        e.reg.rt.state = st;
+        Notify(e.reg.cfg.appId, st);
+    }
+
+    // Queue a state change for the dispatcher; called under mu_ so events of
+    // the whole registry are queued in the order the states were set
     void Notify(const std::string& appId, AppState st) {
-        for (auto& f : listeners_) {
-            try { f(appId, st); } catch (...) {}
+        StateEvent ev;
+        ev.appId = appId;
+        ev.state = st;
+        events_.Push(std::move(ev));
+        published_.fetch_add(1);
+        if (dispatcherSleeping_.load()) {
+            std::lock_guard<std::mutex> lk(dmu_);
+            dcv_.notify_one();
+        }
+    }
+
+    // Called without mu_
+    void NotifyMode(const std::string& appId, const std::string& mode) {
+        auto listeners = std::atomic_load(&modeListeners_);
+        for (auto& f : *listeners) {
+            try { f(appId, mode); } catch (...) {}
+        }
+    }
+
+    // Deliver queued state changes to a snapshot of the listeners
+    void DispatchLoop() {
+        for (;;) {
+            StateEvent ev;
+            uint64_t n = 0;
+            while (events_.TryPop(ev)) {
+                auto listeners = std::atomic_load(&listeners_);
+                for (auto& f : *listeners) {
+                    try { f(ev.appId, ev.state); } catch (...) {}
+                }
+                ++n;
+            }
+            std::unique_lock<std::mutex> lk(dmu_);
+            if (n) {
+                delivered_ += n;
+                flushCv_.notify_all();
+            }
+            dispatcherSleeping_.store(true);
+            dcv_.wait(lk, [&] { return stopping_ || published_.load() != delivered_; });
+            dispatcherSleeping_.store(false);
+            if (stopping_ && published_.load() == delivered_) return;
         }
     }
 
     std::mutex mu_;
-    std::unordered_map<std::string, AppRegistration> apps_;
-    std::vector<StateListener> listeners_;
+    std::unordered_map<std::string, std::unique_ptr<AppEntry>> apps_;
+
+    std::mutex listenersMu_; // serializes Subscribe*; readers take an atomic snapshot
+    std::shared_ptr<const std::vector<StateListener>> listeners_;
+    std::shared_ptr<const std::vector<ModeListener>> modeListeners_;
+
+    MpscQueue<StateEvent> events_;
+    std::atomic<uint64_t> published_{0};
+    std::atomic<bool> dispatcherSleeping_{false};
+    std::mutex dmu_;                  // guards delivered_/stopping_
+    std::condition_variable dcv_;     // dispatcher sleeps here
+    std::condition_variable flushCv_; // Flush() waits here
+    uint64_t delivered_{0};
+    bool stopping_{false};
+    std::thread dispatcher_; // last: started once the members above exist
 };
 
 // Convert AppState to string
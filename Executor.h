@@ -0,0 +1,242 @@
+// Executor.h - Work-stealing thread pool and per-method concurrency limits
+#pragma once
+#include "AraCom_Skeleton.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ara {
+namespace com {
+
+// Thread pool with one deque per worker. A worker pops its own newest task
+// (cache-warm) and steals the oldest task of a busy sibling when it runs dry;
+// tasks submitted from outside are spread round-robin.
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+    // threads == 0: one worker per hardware thread
+    explicit Executor(size_t threads = 0) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < threads; ++i) workers_.emplace_back(new Worker);
+        for (size_t i = 0; i < threads; ++i) threads_.emplace_back([this, i] { Run(i); });
+    }
+
+    // Runs every task still queued, then joins the workers
+    ~Executor() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    // Process-wide pool shared by skeletons that are not given their own
+    static std::shared_ptr<Executor> Shared() {
+        static std::shared_ptr<Executor> inst = std::make_shared<Executor>();
+        return inst;
+    }
+
+    void Submit(Task t) {
+        const Current& cur = Self();
+        const size_t i = cur.pool == this ? cur.index : next_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+        {
+            std::lock_guard<std::mutex> lk(workers_[i]->mu);
+            workers_[i]->q.push_back(std::move(t));
+        }
+        queued_.fetch_add(1);
+        if (sleepers_.load() > 0) {
+            std::lock_guard<std::mutex> lk(mu_);
+            cv_.notify_one();
+        }
+    }
+
+    size_t Threads() const { return workers_.size(); }
+    uint64_t Steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::mutex mu;
+        std::deque<Task> q;
+    };
+
+    struct Current {
+        Executor* pool{nullptr};
+        size_t index{0};
+    };
+
+    static Current& Self() {
+        static thread_local Current cur;
+        return cur;
+    }
+
+    bool PopLocal(size_t i, Task& t) {
+        Worker& w = *workers_[i];
+        std::lock_guard<std::mutex> lk(w.mu);
+        if (w.q.empty()) return false;
+        t = std::move(w.q.back());
+        w.q.pop_back();
+        return true;
+    }
+
+    bool Steal(size_t i, Task& t) {
+        for (size_t k = 1; k < workers_.size(); ++k) {
+            Worker& w = *workers_[(i + k) % workers_.size()];
+            std::lock_guard<std::mutex> lk(w.mu);
+            if (w.q.empty()) continue;
+            t = std::move(w.q.front());
+            w.q.pop_front();
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void Run(size_t i) {
+        Self().pool = this;
+        Self().index = i;
+        for (;;) {
+            Task t;
+            if (PopLocal(i, t) || Steal(i, t)) {
+                queued_.fetch_sub(1);
+                t();
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(mu_);
+            sleepers_.fetch_add(1);
+            cv_.wait(lk, [&] { return queued_.load() > 0 || stopping_; });
+            sleepers_.fetch_sub(1);
+            if (stopping_ && queued_.load() == 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::mutex mu_;              // idle workers sleep on cv_
+    std::condition_variable cv_;
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> sleepers_{0};
+    std::atomic<size_t> next_{0};
+    std::atomic<uint64_t> steals_{0};
+    bool stopping_{false};
+};
+
+// Runs posted tasks on an Executor with at most `parallel` of them in flight,
+// in posting order when parallel == 1. Post fails once maxQueue tasks wait.
+class Strand {
+public:
+    using Task = Executor::Task;
+
+    Strand(std::shared_ptr<Executor> exec, size_t parallel, size_t maxQueue)
+        : exec_(std::move(exec)), parallel_(std::max<size_t>(parallel, 1)), maxQueue_(maxQueue) {}
+
+    // Waits for running tasks; tasks still queued are dropped
+    ~Strand() {
+        std::unique_lock<std::mutex> lk(mu_);
+        queue_.clear();
+        idle_.wait(lk, [&] { return running_ == 0; });
+    }
+
+    bool Post(Task t) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (queue_.size() >= maxQueue_) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            queue_.push_back(std::move(t));
+            if (running_ >= parallel_) return true;
+            ++running_;
+        }
+        exec_->Submit([this] { Drain(); });
+        return true;
+    }
+
+    size_t Queued() const {
+        std::lock_guard<std::mutex> lk(mu_);
+        return queue_.size();
+    }
+
+    uint64_t Rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t kDrainBatch = 16; // then yield the worker to other work
+
+    void Drain() {
+        for (size_t n = 0;; ++n) {
+            Task t;
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                if (queue_.empty()) {
+                    if (--running_ == 0) idle_.notify_all();
+                    return;
+                }
+                if (n == kDrainBatch) break;
+                t = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            t();
+        }
+        exec_->Submit([this] { Drain(); });
+    }
+
+    std::shared_ptr<Executor> exec_;
+    const size_t parallel_;
+    const size_t maxQueue_;
+    mutable std::mutex mu_;
+    std::condition_variable idle_;
+    std::deque<Task> queue_;
+    size_t running_{0};
+    std::atomic<uint64_t> rejected_{0};
+};
+
+// Runs the handlers of a skeleton's N methods according to their
+// MethodConcurrency. Configure before OfferService; methods default to inline.
+template <size_t N>
+class MethodDispatcher {
+public:
+    void SetExecutor(std::shared_ptr<Executor> exec) { exec_ = std::move(exec); }
+
+    void Configure(size_t idx, MethodConcurrency c) {
+        if (c.mode == MethodConcurrency::kInline) {
+            strands_[idx].reset();
+            return;
+        }
+        if (!exec_) exec_ = Executor::Shared();
+        const size_t parallel = c.mode == MethodConcurrency::kSerialized ? 1 : c.parallel;
+        strands_[idx].reset(new Strand(exec_, parallel, c.maxQueue));
+    }
+
+    // Run fn for method idx; false if the method's queue is full (the caller
+    // should reject the request so the client backs off)
+    template <typename F>
+    bool Dispatch(size_t idx, F&& fn) {
+        if (!strands_[idx]) {
+            fn();
+            return true;
+        }
+        return strands_[idx]->Post(Executor::Task(std::forward<F>(fn)));
+    }
+
+    uint64_t Rejected(size_t idx) const { return strands_[idx] ? strands_[idx]->Rejected() : 0; }
+
+private:
+    std::shared_ptr<Executor> exec_;
+    std::array<std::unique_ptr<Strand>, N> strands_;
+};
+
+} // namespace com
+} // namespace ara
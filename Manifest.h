@@ -0,0 +1,285 @@
+// Manifest.h - Compiled manifest image: flat binary layout and zero-copy view
+#pragma once
+#include "AraLog.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * manifest.json is compiled by manifest-compiler (see ManifestCompiler.h) into
+ * one flat, versioned image that is mmap'ed and read in place: the loader
+ * checks bounds once and then hands out pointers into the mapping, so it
+ * neither parses nor allocates. Layout (native endianness, 4-byte aligned):
+ *
+ *   Header | u32 string offsets / records ... | NUL-terminated strings
+ *
+ * Every string field is the offset of a NUL-terminated string inside the
+ * image; every list is a Range {offset, count} of u32 string offsets or of
+ * fixed-size records. A header checksum (FNV-1a of everything after the
+ * header) rejects truncated or damaged images.
+ */
+namespace ara {
+namespace manifest {
+
+constexpr char kImageMagic[8] = {'A', 'R', 'A', 'M', 'F', 'S', 'T', '\0'};
+constexpr uint32_t kImageVersion = 1;
+
+struct Range {
+    uint32_t off;
+    uint32_t count;
+};
+
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;          // whole image
+    uint32_t checksum;      // FNV-1a of bytes [sizeof(ImageHeader), size)
+    uint32_t appName;
+    uint32_t defaultMode;
+    uint32_t restartPolicy; // "always" | "on-failure" | "no"
+    int32_t maxRestarts;    // -1 = unlimited
+    Range modes;            // string offsets
+    Range executables;      // ExecutableRecord
+    Range bindings;         // BindingRecord
+};
+
+struct ExecutableRecord {
+    uint32_t name;
+    uint32_t path;          // "" = not launched by exec_manager
+    uint32_t processType;
+    uint32_t restartPolicy; // "" = application default
+    int32_t maxRestarts;
+    uint32_t hasMaxRestarts;
+    Range args;             // string offsets
+    Range dependsOn;        // string offsets (executable names)
+};
+
+struct BindingRecord {
+    uint16_t service;
+    uint16_t instance;
+    uint32_t transport;     // "someip" | "shm"
+};
+
+inline uint32_t Fnv1a(const uint8_t* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+class Manifest;
+
+// One executable of the image
+class Executable {
+public:
+    const char* Name() const { return Str(r_->name); }
+    const char* Path() const { return Str(r_->path); }
+    const char* ProcessType() const { return Str(r_->processType); }
+    // Per-executable override, else the application's policy/limit
+    const char* RestartPolicy() const;
+    int MaxRestarts() const;
+    uint32_t NumArgs() const { return r_->args.count; }
+    const char* Arg(uint32_t i) const { return Str(List(r_->args)[i]); }
+    uint32_t NumDependsOn() const { return r_->dependsOn.count; }
+    const char* DependsOn(uint32_t i) const { return Str(List(r_->dependsOn)[i]); }
+
+private:
+    friend class Manifest;
+    Executable(const Manifest* m, const ExecutableRecord* r) : m_(m), r_(r) {}
+    const char* Str(uint32_t off) const;
+    const uint32_t* List(Range r) const;
+
+    const Manifest* m_;
+    const ExecutableRecord* r_;
+};
+
+struct Binding {
+    uint16_t service;
+    uint16_t instance;
+    const char* transport;
+};
+
+// Read-only view of a manifest image, either mmap'ed from a file or owned in
+// memory (JSON fallback). Move-only; the pointers it returns stay valid for
+// its lifetime.
+class Manifest {
+public:
+    Manifest() = default;
+    ~Manifest() { Reset(); }
+    Manifest(Manifest&& o) noexcept { *this = std::move(o); }
+    Manifest& operator=(Manifest&& o) noexcept {
+        if (this != &o) {
+            Reset();
+            base_ = o.base_;
+            mapped_ = o.mapped_;
+            owned_ = std::move(o.owned_);
+            source_ = o.source_;
+            if (!owned_.empty()) base_ = owned_.data();
+            o.base_ = nullptr;
+            o.mapped_ = 0;
+        }
+        return *this;
+    }
+    Manifest(const Manifest&) = delete;
+    Manifest& operator=(const Manifest&) = delete;
+
+    // mmap a compiled image; invalid Manifest (and *err set) if it cannot be used
+    static Manifest Map(const std::string& path, std::string* err = nullptr) {
+        Manifest m;
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return Fail(err, "cannot open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(ImageHeader))) {
+            close(fd);
+            return Fail(err, path + " is too small for a manifest image");
+        }
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return Fail(err, "cannot mmap " + path);
+        m.base_ = static_cast<const uint8_t*>(p);
+        m.mapped_ = static_cast<size_t>(st.st_size);
+        m.source_ = "image";
+        std::string why;
+        if (!Check(m.base_, m.mapped_, why)) return Fail(err, path + ": " + why);
+        return m;
+    }
+
+    // Take ownership of an image built in memory
+    static Manifest FromImage(std::vector<uint8_t> image, const char* source, std::string* err = nullptr) {
+        Manifest m;
+        m.owned_ = std::move(image);
+        m.base_ = m.owned_.data();
+        m.source_ = source;
+        std::string why;
+        if (!Check(m.base_, m.owned_.size(), why)) return Fail(err, why);
+        return m;
+    }
+
+    // Validate layout, version, bounds and checksum of an image
+    static bool Check(const uint8_t* p, size_t n, std::string& why) {
+        if (n < sizeof(ImageHeader)) { why = "truncated header"; return false; }
+        const ImageHeader& h = *reinterpret_cast<const ImageHeader*>(p);
+        if (std::memcmp(h.magic, kImageMagic, sizeof(kImageMagic)) != 0) { why = "not a manifest image"; return false; }
+        if (h.version != kImageVersion) {
+            why = "image version " + std::to_string(h.version) + ", expected " + std::to_string(kImageVersion);
+            return false;
+        }
+        if (h.size != n) { why = "size mismatch (truncated image?)"; return false; }
+        if (Fnv1a(p + sizeof(ImageHeader), n - sizeof(ImageHeader)) != h.checksum) { why = "checksum mismatch"; return false; }
+
+        auto str = [&](uint32_t off) { return off < n && std::memchr(p + off, 0, n - off) != nullptr; };
+        auto range = [&](Range r, size_t elem) {
+            return r.off % 4 == 0 && r.off <= n && r.count <= (n - r.off) / elem;
+        };
+        auto strList = [&](Range r) {
+            if (!range(r, sizeof(uint32_t))) return false;
+            const uint32_t* l = reinterpret_cast<const uint32_t*>(p + r.off);
+            for (uint32_t i = 0; i < r.count; ++i) {
+                if (!str(l[i])) return false;
+            }
+            return true;
+        };
+        if (!str(h.appName) || !str(h.defaultMode) || !str(h.restartPolicy) || !strList(h.modes) ||
+            !range(h.executables, sizeof(ExecutableRecord)) || !range(h.bindings, sizeof(BindingRecord))) {
+            why = "corrupt header";
+            return false;
+        }
+        const ExecutableRecord* e = reinterpret_cast<const ExecutableRecord*>(p + h.executables.off);
+        for (uint32_t i = 0; i < h.executables.count; ++i) {
+            if (!str(e[i].name) || !str(e[i].path) || !str(e[i].processType) || !str(e[i].restartPolicy) ||
+                !strList(e[i].args) || !strList(e[i].dependsOn)) {
+                why = "corrupt executable record " + std::to_string(i);
+                return false;
+            }
+        }
+        const BindingRecord* b = reinterpret_cast<const BindingRecord*>(p + h.bindings.off);
+        for (uint32_t i = 0; i < h.bindings.count; ++i) {
+            if (!str(b[i].transport)) {
+                why = "corrupt binding record " + std::to_string(i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Valid() const { return base_ != nullptr; }
+    const char* Source() const { return source_; } // "image" | "json"
+
+    const char* AppName() const { return Str(Header().appName); }
+    const char* DefaultMode() const { return Str(Header().defaultMode); }
+    const char* RestartPolicy() const { return Str(Header().restartPolicy); }
+    int MaxRestarts() const { return Header().maxRestarts; }
+
+    uint32_t NumModes() const { return Header().modes.count; }
+    const char* Mode(uint32_t i) const { return Str(List(Header().modes)[i]); }
+
+    uint32_t NumExecutables() const { return Header().executables.count; }
+    Executable Exe(uint32_t i) const {
+        return Executable(this, reinterpret_cast<const ExecutableRecord*>(base_ + Header().executables.off) + i);
+    }
+    // Index of the executable called name, -1 if there is none
+    int FindExecutable(const char* name) const {
+        for (uint32_t i = 0; i < NumExecutables(); ++i) {
+            if (std::strcmp(Exe(i).Name(), name) == 0) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    uint32_t NumBindings() const { return Header().bindings.count; }
+    Binding BindingAt(uint32_t i) const {
+        const BindingRecord& r = reinterpret_cast<const BindingRecord*>(base_ + Header().bindings.off)[i];
+        return Binding{r.service, r.instance, Str(r.transport)};
+    }
+
+private:
+    friend class Executable;
+
+    static Manifest Fail(std::string* err, const std::string& why) {
+        if (err) *err = why;
+        return Manifest();
+    }
+
+    void Reset() {
+        if (mapped_) munmap(const_cast<uint8_t*>(base_), mapped_);
+        base_ = nullptr;
+        mapped_ = 0;
+        owned_.clear();
+    }
+
+    const ImageHeader& Header() const { return *reinterpret_cast<const ImageHeader*>(base_); }
+    const char* Str(uint32_t off) const { return reinterpret_cast<const char*>(base_ + off); }
+    const uint32_t* List(Range r) const { return reinterpret_cast<const uint32_t*>(base_ + r.off); }
+
+    const uint8_t* base_{nullptr};
+    size_t mapped_{0};              // length of the mapping, 0 if owned_
+    std::vector<uint8_t> owned_;
+    const char* source_{""};
+};
+
+inline const char* Executable::Str(uint32_t off) const { return m_->Str(off); }
+inline const uint32_t* Executable::List(Range r) const { return m_->List(r); }
+
+inline const char* Executable::RestartPolicy() const {
+    const char* p = Str(r_->restartPolicy);
+    return *p ? p : m_->RestartPolicy();
+}
+
+inline int Executable::MaxRestarts() const {
+    return r_->hasMaxRestarts ? r_->maxRestarts : m_->MaxRestarts();
+}
+
+// Image path that belongs to a JSON manifest: manifest.json -> manifest.bin
+inline std::string ImagePathFor(const std::string& jsonPath) {
+    const size_t dot = jsonPath.rfind('.');
+    const size_t slash = jsonPath.rfind('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return jsonPath + ".bin";
+    return jsonPath.substr(0, dot) + ".bin";
+}
+
+} // namespace manifest
+} // namespace ara
@@ -0,0 +1,378 @@
+// ManifestCompiler.h - Validate manifest.json and compile it into a manifest image
+#pragma once
+#include "Manifest.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+
+#include <nlohmann/json.hpp>
+
+namespace ara {
+namespace manifest {
+
+// Lays out an image: header, then sections appended as they are added, then
+// the deduplicated string table
+class ImageBuilder {
+public:
+    ImageBuilder() : body_(sizeof(ImageHeader), 0) {}
+
+    // Offset placeholder for a string; resolved by Finish()
+    uint32_t String(const std::string& s) {
+        auto it = ids_.find(s);
+        if (it != ids_.end()) return it->second;
+        const uint32_t id = static_cast<uint32_t>(strings_.size());
+        strings_.push_back(s);
+        ids_.emplace(s, id);
+        return id;
+    }
+
+    // Reserve count elements of T; returns their range (offset into the image)
+    template <typename T>
+    Range Reserve(size_t count) {
+        Align();
+        Range r{static_cast<uint32_t>(body_.size()), static_cast<uint32_t>(count)};
+        body_.resize(body_.size() + count * sizeof(T), 0);
+        return r;
+    }
+
+    template <typename T>
+    T* At(Range r, size_t i = 0) { return reinterpret_cast<T*>(&body_[r.off]) + i; }
+    ImageHeader& Header() { return *reinterpret_cast<ImageHeader*>(&body_[0]); }
+
+    // Append the string table, patch every string reference (fields recorded
+    // with Ref()) and seal the header
+    std::vector<uint8_t> Finish() {
+        std::vector<uint32_t> offsets(strings_.size());
+        for (size_t i = 0; i < strings_.size(); ++i) {
+            offsets[i] = static_cast<uint32_t>(body_.size());
+            body_.insert(body_.end(), strings_[i].begin(), strings_[i].end());
+            body_.push_back(0);
+        }
+        Align();
+        for (size_t at : refs_) {
+            uint32_t id;
+            std::memcpy(&id, &body_[at], 4);
+            std::memcpy(&body_[at], &offsets[id], 4);
+        }
+        ImageHeader& h = Header();
+        std::memcpy(h.magic, kImageMagic, sizeof(kImageMagic));
+        h.version = kImageVersion;
+        h.size = static_cast<uint32_t>(body_.size());
+        h.checksum = Fnv1a(body_.data() + sizeof(ImageHeader), body_.size() - sizeof(ImageHeader));
+        return std::move(body_);
+    }
+
+    // Mark a u32 field holding a String() id so Finish() turns it into an offset
+    void Ref(const uint32_t& field) {
+        refs_.push_back(reinterpret_cast<const uint8_t*>(&field) - body_.data());
+    }
+
+private:
+    void Align() { body_.resize((body_.size() + 3) & ~size_t(3), 0); }
+
+    std::vector<uint8_t> body_;
+    std::vector<std::string> strings_;
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::vector<size_t> refs_; // byte offsets of string fields
+};
+
+namespace detail {
+
+inline bool IsPolicy(const std::string& p) { return p == "always" || p == "on-failure" || p == "no"; }
+inline bool IsTransport(const std::string& t) { return t == "someip" || t == "shm"; }
+
+// "0x1234", "4660" or 4660
+inline bool ParseId(const nlohmann::json& v, uint16_t& out) {
+    try {
+        const unsigned long n = v.is_string() ? std::stoul(v.get<std::string>(), nullptr, 0)
+                                              : v.get<unsigned long>();
+        if (n > 0xFFFF) return false;
+        out = static_cast<uint16_t>(n);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+inline std::vector<std::string> StringList(const nlohmann::json& obj, const char* key, const std::string& where,
+                                           std::vector<std::string>& errors) {
+    std::vector<std::string> out;
+    if (!obj.contains(key)) return out;
+    if (!obj[key].is_array()) {
+        errors.push_back(where + "." + key + " must be an array of strings");
+        return out;
+    }
+    for (const auto& v : obj[key]) {
+        if (!v.is_string()) {
+            errors.push_back(where + "." + key + " must be an array of strings");
+            continue;
+        }
+        out.push_back(v.get<std::string>());
+    }
+    return out;
+}
+
+} // namespace detail
+
+// Validate the whole manifest (all executables, modes, policies, dependencies
+// and service bindings) and build its image. Returns false with one message
+// per problem in errors.
+inline bool CompileManifest(const nlohmann::json& doc, std::vector<uint8_t>& image, std::vector<std::string>& errors) {
+    using detail::StringList;
+    if (!doc.is_object() || !doc.contains("applicationManifest") || !doc["applicationManifest"].is_object()) {
+        errors.push_back("missing object \"applicationManifest\"");
+        return false;
+    }
+    const nlohmann::json& m = doc["applicationManifest"];
+    auto str = [&](const nlohmann::json& o, const char* key, const std::string& def, const std::string& where) {
+        if (!o.contains(key)) return def;
+        if (!o[key].is_string()) {
+            errors.push_back(where + "." + key + " must be a string");
+            return def;
+        }
+        return o[key].get<std::string>();
+    };
+    auto integer = [&](const nlohmann::json& o, const char* key, int def, const std::string& where) {
+        if (!o.contains(key)) return def;
+        if (!o[key].is_number_integer() || o[key].get<int>() < -1) {
+            errors.push_back(where + "." + key + " must be an integer >= -1");
+            return def;
+        }
+        return o[key].get<int>();
+    };
+
+    const std::string appName = str(m, "name", "", "applicationManifest");
+    if (appName.empty()) errors.push_back("applicationManifest.name is required");
+    const std::string policy = str(m, "restartPolicy", "on-failure", "applicationManifest");
+    if (!detail::IsPolicy(policy)) errors.push_back("applicationManifest.restartPolicy \"" + policy + "\" is not always|on-failure|no");
+    const int maxRestarts = integer(m, "maxRestarts", -1, "applicationManifest");
+
+    // Modes
+    std::vector<std::string> modes;
+    if (m.contains("applicationModeDeclarations")) {
+        if (!m["applicationModeDeclarations"].is_array()) {
+            errors.push_back("applicationModeDeclarations must be an array");
+        } else {
+            for (const auto& d : m["applicationModeDeclarations"]) {
+                const std::string name = d.is_object() ? str(d, "name", "", "applicationModeDeclarations[]") : "";
+                if (name.empty()) {
+                    errors.push_back("applicationModeDeclarations: every entry needs a name");
+                } else if (std::find(modes.begin(), modes.end(), name) != modes.end()) {
+                    errors.push_back("applicationModeDeclarations: duplicate mode \"" + name + "\"");
+                } else {
+                    modes.push_back(name);
+                }
+            }
+        }
+    }
+    const std::string defaultMode = str(m, "defaultMode", modes.empty() ? "NormalMode" : modes[0], "applicationManifest");
+    if (!modes.empty() && std::find(modes.begin(), modes.end(), defaultMode) == modes.end()) {
+        errors.push_back("defaultMode \"" + defaultMode + "\" is not declared in applicationModeDeclarations");
+    }
+
+    // Executables
+    struct Exe {
+        std::string name, path, processType, policy;
+        int maxRestarts;
+        bool hasMaxRestarts;
+        std::vector<std::string> args, dependsOn;
+    };
+    std::vector<Exe> exes;
+    if (m.contains("executables") && !m["executables"].is_array()) errors.push_back("executables must be an array");
+    if (m.contains("executables") && m["executables"].is_array()) {
+        for (size_t i = 0; i < m["executables"].size(); ++i) {
+            const auto& e = m["executables"][i];
+            const std::string where = "executables[" + std::to_string(i) + "]";
+            if (!e.is_object()) {
+                errors.push_back(where + " must be an object");
+                continue;
+            }
+            Exe x;
+            x.name = str(e, "name", "", where);
+            x.path = str(e, "path", "", where);
+            x.processType = str(e, "processType", "APPLICATION", where);
+            x.policy = str(e, "restartPolicy", "", where);
+            x.hasMaxRestarts = e.contains("maxRestarts");
+            x.maxRestarts = integer(e, "maxRestarts", -1, where);
+            x.args = StringList(e, "args", where, errors);
+            x.dependsOn = StringList(e, "dependsOn", where, errors);
+            if (x.name.empty()) errors.push_back(where + ".name is required");
+            if (!x.policy.empty() && !detail::IsPolicy(x.policy)) {
+                errors.push_back(where + ".restartPolicy \"" + x.policy + "\" is not always|on-failure|no");
+            }
+            for (const auto& other : exes) {
+                if (other.name == x.name) errors.push_back(where + ": duplicate executable \"" + x.name + "\"");
+            }
+            exes.push_back(std::move(x));
+        }
+    }
+    std::map<std::string, size_t> byName;
+    for (size_t i = 0; i < exes.size(); ++i) byName.emplace(exes[i].name, i);
+    for (const auto& x : exes) {
+        for (const auto& d : x.dependsOn) {
+            if (d == x.name) errors.push_back("executable \"" + x.name + "\" depends on itself");
+            else if (!byName.count(d)) errors.push_back("executable \"" + x.name + "\" depends on unknown \"" + d + "\"");
+        }
+    }
+    // Dependency cycles (DFS; 1 = on the stack, 2 = done)
+    std::vector<int> mark(exes.size(), 0);
+    std::function<bool(size_t)> cyclic = [&](size_t i) {
+        if (mark[i] == 1) return true;
+        if (mark[i] == 2) return false;
+        mark[i] = 1;
+        for (const auto& d : exes[i].dependsOn) {
+            auto it = byName.find(d);
+            if (it != byName.end() && it->second != i && cyclic(it->second)) return true;
+        }
+        mark[i] = 2;
+        return false;
+    };
+    for (size_t i = 0; i < exes.size(); ++i) {
+        if (!mark[i] && cyclic(i)) {
+            errors.push_back("dependency cycle through executable \"" + exes[i].name + "\"");
+            break;
+        }
+    }
+
+    // Service bindings
+    std::vector<BindingRecord> bindings;
+    std::vector<std::string> transports;
+    if (m.contains("serviceBindings") && !m["serviceBindings"].is_array()) errors.push_back("serviceBindings must be an array");
+    if (m.contains("serviceBindings") && m["serviceBindings"].is_array()) {
+        std::set<uint32_t> seen;
+        for (size_t i = 0; i < m["serviceBindings"].size(); ++i) {
+            const auto& b = m["serviceBindings"][i];
+            const std::string where = "serviceBindings[" + std::to_string(i) + "]";
+            BindingRecord r{};
+            if (!b.is_object() || !b.contains("service") || !detail::ParseId(b["service"], r.service)) {
+                errors.push_back(where + ".service must be a 16-bit ID");
+                continue;
+            }
+            if (!b.contains("instance") || !detail::ParseId(b["instance"], r.instance)) {
+                errors.push_back(where + ".instance must be a 16-bit ID");
+                continue;
+            }
+            const std::string t = str(b, "transport", "someip", where);
+            if (!detail::IsTransport(t)) errors.push_back(where + ".transport \"" + t + "\" is not someip|shm");
+            if (!seen.insert((uint32_t(r.service) << 16) | r.instance).second) {
+                errors.push_back(where + ": service/instance bound twice");
+            }
+            bindings.push_back(r);
+            transports.push_back(t);
+        }
+    }
+    if (!errors.empty()) return false;
+
+    // Layout
+    ImageBuilder b;
+    const Range modeRange = b.Reserve<uint32_t>(modes.size());
+    const Range exeRange = b.Reserve<ExecutableRecord>(exes.size());
+    const Range bindingRange = b.Reserve<BindingRecord>(bindings.size());
+    auto strList = [&](const std::vector<std::string>& v) {
+        const Range r = b.Reserve<uint32_t>(v.size());
+        for (size_t i = 0; i < v.size(); ++i) {
+            uint32_t& f = *b.At<uint32_t>(r, i);
+            f = b.String(v[i]);
+            b.Ref(f);
+        }
+        return r;
+    };
+    auto setStr = [&](uint32_t& field, const std::string& s) {
+        field = b.String(s);
+        b.Ref(field);
+    };
+    for (size_t i = 0; i < modes.size(); ++i) setStr(*b.At<uint32_t>(modeRange, i), modes[i]);
+    for (size_t i = 0; i < exes.size(); ++i) {
+        const Range args = strList(exes[i].args);
+        const Range deps = strList(exes[i].dependsOn);
+        ExecutableRecord& r = *b.At<ExecutableRecord>(exeRange, i); // after the Reserves above
+        setStr(r.name, exes[i].name);
+        setStr(r.path, exes[i].path);
+        setStr(r.processType, exes[i].processType);
+        setStr(r.restartPolicy, exes[i].policy);
+        r.maxRestarts = exes[i].maxRestarts;
+        r.hasMaxRestarts = exes[i].hasMaxRestarts ? 1 : 0;
+        r.args = args;
+        r.dependsOn = deps;
+    }
+    for (size_t i = 0; i < bindings.size(); ++i) {
+        BindingRecord& r = *b.At<BindingRecord>(bindingRange, i);
+        r = bindings[i];
+        setStr(r.transport, transports[i]);
+    }
+    ImageHeader& h = b.Header();
+    setStr(h.appName, appName);
+    setStr(h.defaultMode, defaultMode);
+    setStr(h.restartPolicy, policy);
+    h.maxRestarts = maxRestarts;
+    h.modes = modeRange;
+    h.executables = exeRange;
+    h.bindings = bindingRange;
+    image = b.Finish();
+    return true;
+}
+
+inline bool CompileManifestFile(const std::string& jsonPath, std::vector<uint8_t>& image,
+                                std::vector<std::string>& errors) {
+    std::ifstream f(jsonPath);
+    if (!f) {
+        errors.push_back("cannot open " + jsonPath);
+        return false;
+    }
+    nlohmann::json doc;
+    try {
+        f >> doc;
+    } catch (const std::exception& e) {
+        errors.push_back(std::string("JSON parse error: ") + e.what());
+        return false;
+    }
+    return CompileManifest(doc, image, errors);
+}
+
+// True if a was modified strictly after b (nanosecond timestamps: an edit in
+// the same second as the last compile must not be missed)
+inline bool NewerThan(const struct stat& a, const struct stat& b) {
+    if (a.st_mtim.tv_sec != b.st_mtim.tv_sec) return a.st_mtim.tv_sec > b.st_mtim.tv_sec;
+    return a.st_mtim.tv_nsec > b.st_mtim.tv_nsec;
+}
+
+// Load the manifest of jsonPath: its compiled image (manifest.json ->
+// manifest.bin) is mmap'ed when it exists and is newer than the JSON (equal
+// timestamps count as stale, for file systems with coarse ones); otherwise
+// the JSON is validated and compiled in memory. A path ending in ".bin" is
+// only ever mapped. Invalid Manifest if neither works.
+inline Manifest LoadManifest(const std::string& jsonPath) {
+    const bool imageOnly = jsonPath.size() > 4 && jsonPath.compare(jsonPath.size() - 4, 4, ".bin") == 0;
+    const std::string imagePath = imageOnly ? jsonPath : ImagePathFor(jsonPath);
+    struct stat js, is;
+    const bool haveJson = !imageOnly && stat(jsonPath.c_str(), &js) == 0;
+    if (stat(imagePath.c_str(), &is) == 0) {
+        if (haveJson && !NewerThan(is, js)) {
+            ARA_LOG_WARN("[Manifest] {} is not newer than {}, using the JSON", imagePath, jsonPath);
+        } else {
+            std::string err;
+            Manifest m = Manifest::Map(imagePath, &err);
+            if (m.Valid()) return m;
+            ARA_LOG_WARN("[Manifest] Cannot use image {}", err);
+        }
+    }
+    if (imageOnly) return Manifest();
+
+    std::vector<uint8_t> image;
+    std::vector<std::string> errors;
+    if (!CompileManifestFile(jsonPath, image, errors)) {
+        for (const auto& e : errors) ARA_LOG_ERROR("[Manifest] {}: {}", jsonPath, e);
+        return Manifest();
+    }
+    return Manifest::FromImage(std::move(image), "json");
+}
+
+} // namespace manifest
+} // namespace ara
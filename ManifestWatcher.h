@@ -0,0 +1,131 @@
+// ManifestWatcher.h - Reload the manifest when it changes on disk (inotify)
+#pragma once
+#include "ManifestCompiler.h"
+#include "AraLog.h"
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace ara {
+namespace manifest {
+
+// Watches the directory of a manifest for writes to the JSON or its compiled
+// image (manifest-compiler renames a finished image into place, editors often
+// do the same, so the directory is watched rather than the file). Changes are
+// settled for a short quiet period, then the manifest is loaded with
+// LoadManifest() and handed to the callback on the watcher thread. A manifest
+// that fails to load or validate is reported and ignored: the running
+// configuration stays as it is.
+class ManifestWatcher {
+public:
+    using Callback = std::function<void(const Manifest&)>;
+
+    ManifestWatcher(const std::string& jsonPath, Callback cb,
+                    std::chrono::milliseconds settle = std::chrono::milliseconds(200))
+        : path_(jsonPath), cb_(std::move(cb)), settle_(settle) {
+        const size_t slash = path_.rfind('/');
+        const std::string dir = slash == std::string::npos ? "." : path_.substr(0, slash == 0 ? 1 : slash);
+        json_ = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+        const std::string image = ImagePathFor(path_);
+        image_ = image.substr(image.rfind('/') == std::string::npos ? 0 : image.rfind('/') + 1);
+
+        in_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (in_ < 0 || inotify_add_watch(in_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            ARA_LOG_ERROR("[Manifest] Cannot watch {}: {} (hot reload disabled)", dir, std::strerror(errno));
+            return;
+        }
+        wake_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        thread_ = std::thread([this] { Loop(); });
+        ARA_LOG_INFO("[Manifest] Watching {} for changes", path_);
+    }
+
+    ~ManifestWatcher() {
+        stop_.store(true);
+        if (wake_ >= 0) {
+            const uint64_t one = 1;
+            if (write(wake_, &one, sizeof(one)) < 0) { /* counter saturated: already awake */ }
+        }
+        if (thread_.joinable()) thread_.join();
+        if (wake_ >= 0) close(wake_);
+        if (in_ >= 0) close(in_);
+    }
+
+    ManifestWatcher(const ManifestWatcher&) = delete;
+    ManifestWatcher& operator=(const ManifestWatcher&) = delete;
+
+    bool Watching() const { return thread_.joinable(); }
+    uint64_t Reloads() const { return reloads_.load(); }
+
+private:
+    void Loop() {
+        pollfd fds[2] = {{in_, POLLIN, 0}, {wake_, POLLIN, 0}};
+        bool pending = false;
+        while (!stop_.load()) {
+            // Idle: block; a change seen: wait for the quiet period to pass
+            const int n = poll(fds, 2, pending ? static_cast<int>(settle_.count()) : -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                ARA_LOG_ERROR("[Manifest] poll failed: {} (hot reload stopped)", std::strerror(errno));
+                return;
+            }
+            if (n == 0) {
+                pending = false;
+                Reload();
+                continue;
+            }
+            if (fds[0].revents & POLLIN) pending |= Drain();
+        }
+    }
+
+    // Consume queued inotify events; true if one concerns the manifest
+    bool Drain() {
+        alignas(inotify_event) char buf[4096];
+        bool hit = false;
+        ssize_t len;
+        while ((len = read(in_, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + len;) {
+                const inotify_event* ev = reinterpret_cast<const inotify_event*>(p);
+                if (ev->len && (json_ == ev->name || image_ == ev->name)) hit = true;
+                p += sizeof(inotify_event) + ev->len;
+            }
+        }
+        return hit;
+    }
+
+    void Reload() {
+        const Manifest m = LoadManifest(path_);
+        if (!m.Valid()) {
+            ARA_LOG_ERROR("[Manifest] Reload of {} rejected, keeping the current configuration", path_);
+            return;
+        }
+        reloads_.fetch_add(1);
+        ARA_LOG_INFO("[Manifest] Reloaded {} ({})", path_, m.Source());
+        try {
+            cb_(m);
+        } catch (const std::exception& e) {
+            ARA_LOG_ERROR("[Manifest] Applying {} failed: {}", path_, e.what());
+        }
+    }
+
+    std::string path_;
+    std::string json_;  // file names inside the watched directory
+    std::string image_;
+    Callback cb_;
+    std::chrono::milliseconds settle_;
+    int in_{-1};
+    int wake_{-1};
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> reloads_{0};
+    std::thread thread_; // last: started once the members above exist
+};
+
+} // namespace manifest
+} // namespace ara
@@ -0,0 +1,219 @@
+// Metrics.h - Lock-free latency/size histograms for binding instrumentation
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace ara {
+namespace com {
+
+// Log-linear histogram in the style of HdrHistogram: values are grouped by
+// power of two and each group is split into kSub linear sub-buckets, so any
+// value is reported within 1/kSub (6.25%) of its true magnitude across the
+// full 64-bit range. Record is a handful of relaxed atomic ops and never
+// blocks, so it can stay enabled on hot paths.
+class Histogram {
+public:
+    static constexpr unsigned kSubBits = 4;
+    static constexpr uint64_t kSub = 1u << kSubBits;
+    static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSub;
+
+    void Record(uint64_t v) {
+        counts_[Index(v)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(v, std::memory_order_relaxed);
+        uint64_t m = max_.load(std::memory_order_relaxed);
+        while (v > m && !max_.compare_exchange_weak(m, v, std::memory_order_relaxed)) {}
+    }
+
+    void RecordSince(std::chrono::steady_clock::time_point t0) {
+        Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count()));
+    }
+
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+
+    // Consistent enough for diagnostics: counters recorded concurrently with
+    // the copy may be in or out of it
+    struct Snapshot {
+        uint64_t count{0};
+        uint64_t sum{0};
+        uint64_t max{0};
+        std::array<uint64_t, kBuckets> counts{};
+
+        double Mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+
+        // Upper bound of the bucket holding quantile q (0..1), capped at max
+        uint64_t Percentile(double q) const {
+            uint64_t total = 0;
+            for (uint64_t c : counts) total += c;
+            if (total == 0) return 0;
+            uint64_t rank = static_cast<uint64_t>(q * total + 0.5);
+            if (rank < 1) rank = 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBuckets; ++i) {
+                seen += counts[i];
+                if (seen >= rank) return UpperBound(i) < max ? UpperBound(i) : max;
+            }
+            return max;
+        }
+    };
+
+    Snapshot Take() const {
+        Snapshot s;
+        s.count = count_.load(std::memory_order_relaxed);
+        s.sum = sum_.load(std::memory_order_relaxed);
+        s.max = max_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < kBuckets; ++i) s.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        return s;
+    }
+
+    static size_t Index(uint64_t v) {
+        if (v < kSub) return static_cast<size_t>(v);
+        const unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(v));
+        const unsigned group = msb - kSubBits + 1;
+        return (group << kSubBits) + static_cast<size_t>((v >> (msb - kSubBits)) & (kSub - 1));
+    }
+
+    static uint64_t UpperBound(size_t idx) {
+        if (idx < kSub) return idx;
+        const unsigned group = static_cast<unsigned>(idx >> kSubBits);
+        const uint64_t sub = idx & (kSub - 1);
+        return ((kSub + sub + 1) << (group - 1)) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+inline std::string JsonNum(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", v);
+    return buf;
+}
+
+// count/mean/p50/p90/p99/max of a histogram of nanoseconds, in us
+inline std::string JsonTimeUs(const Histogram::Snapshot& s) {
+    auto us = [](uint64_t ns) { return JsonNum(ns / 1000.0); };
+    return "{\"count\":" + std::to_string(s.count) + ",\"mean\":" + JsonNum(s.Mean() / 1000.0) +
+           ",\"p50\":" + us(s.Percentile(0.5)) + ",\"p90\":" + us(s.Percentile(0.9)) +
+           ",\"p99\":" + us(s.Percentile(0.99)) + ",\"max\":" + us(s.max) + "}";
+}
+
+// Per-method instrumentation. On a skeleton: handler run time, receive to
+// SendResponse latency (includes queueing), request/response sizes. On a
+// proxy: round trip of asynchronous calls and response sizes.
+struct MethodMetrics {
+    Histogram handlerNs;
+    Histogram latencyNs;
+    Histogram requestBytes;
+    Histogram responseBytes;
+    std::atomic<uint64_t> cacheHits{0};   // answered from the response cache (idempotent methods)
+    std::atomic<uint64_t> cacheMisses{0};
+};
+
+// Per-event instrumentation: payload sizes (one count per notification) and,
+// on a proxy, the time spent in the subscriber's callback and, for queued
+// delivery, the queue depth seen by each notification and the drops
+struct EventMetrics {
+    Histogram bytes;
+    Histogram handlerNs;
+    Histogram queueDepth;
+    std::atomic<uint64_t> dropped{0};
+};
+
+// Service availability as seen by a proxy: time from FindService until the
+// service was first offered and until the first response arrived, outages
+// (service gone until offered again) and the calls held back meanwhile
+struct AvailabilityMetrics {
+    std::atomic<int64_t> timeToAvailableNs{-1};     // -1 until it happens
+    std::atomic<int64_t> timeToFirstResponseNs{-1};
+    Histogram reofferNs;                            // one sample per outage
+    Histogram queueWaitNs;                          // per call sent from the queue
+    std::atomic<uint64_t> queued{0};                // calls made while unavailable
+    std::atomic<uint64_t> rejected{0};              // ... and refused: queue full
+    std::atomic<uint64_t> failedInFlight{0};        // calls lost with an outage
+
+    std::string Json() const {
+        auto once = [](const std::atomic<int64_t>& ns) {
+            const int64_t v = ns.load(std::memory_order_relaxed);
+            return v < 0 ? std::string("null") : JsonNum(v / 1000.0);
+        };
+        return "{\"timeToAvailableUs\":" + once(timeToAvailableNs) +
+               ",\"timeToFirstResponseUs\":" + once(timeToFirstResponseNs) +
+               ",\"reofferUs\":" + JsonTimeUs(reofferNs.Take()) + ",\"queueWaitUs\":" + JsonTimeUs(queueWaitNs.Take()) +
+               ",\"queued\":" + std::to_string(queued.load(std::memory_order_relaxed)) +
+               ",\"rejected\":" + std::to_string(rejected.load(std::memory_order_relaxed)) +
+               ",\"failedInFlight\":" + std::to_string(failedInFlight.load(std::memory_order_relaxed)) + "}";
+    }
+};
+
+// Metrics of one service binding, indexed like the ServiceDesc tables
+template <size_t NumMethods, size_t NumEvents>
+class BindingMetrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    MethodMetrics& Method(size_t idx) { return methods_[idx]; }
+    EventMetrics& Event(size_t idx) { return events_[idx]; }
+
+    // JSON snapshot: per method/event counts, average rate since the binding
+    // was created, and p50/p90/p99/max of every histogram (times in us);
+    // extra ("\"name\":value") is added as a last member
+    std::string Json(const uint16_t* methodIds, const uint16_t* eventIds, const std::string& extra = "") const {
+        const double secs = std::chrono::duration<double>(Clock::now() - start_).count();
+        std::string out = "{\"uptimeSec\":" + Num(secs) + ",\"methods\":[";
+        for (size_t i = 0; i < NumMethods; ++i) {
+            const MethodMetrics& m = methods_[i];
+            const uint64_t n = std::max(m.requestBytes.Count(), m.latencyNs.Count());
+            out += (i ? ",{" : "{");
+            out += "\"id\":" + std::to_string(methodIds[i]) + ",\"count\":" + std::to_string(n) +
+                   ",\"ratePerSec\":" + Num(secs > 0 ? n / secs : 0.0);
+            out += ",\"handlerUs\":" + Time(m.handlerNs.Take());
+            out += ",\"latencyUs\":" + Time(m.latencyNs.Take());
+            out += ",\"requestBytes\":" + Size(m.requestBytes.Take());
+            out += ",\"responseBytes\":" + Size(m.responseBytes.Take());
+            out += ",\"cacheHits\":" + std::to_string(m.cacheHits.load(std::memory_order_relaxed)) +
+                   ",\"cacheMisses\":" + std::to_string(m.cacheMisses.load(std::memory_order_relaxed)) + "}";
+        }
+        out += "],\"events\":[";
+        for (size_t i = 0; i < NumEvents; ++i) {
+            const EventMetrics& e = events_[i];
+            const auto bytes = e.bytes.Take();
+            out += (i ? ",{" : "{");
+            out += "\"id\":" + std::to_string(eventIds[i]) + ",\"count\":" + std::to_string(bytes.count) +
+                   ",\"ratePerSec\":" + Num(secs > 0 ? bytes.count / secs : 0.0);
+            out += ",\"handlerUs\":" + Time(e.handlerNs.Take());
+            out += ",\"bytes\":" + Size(bytes);
+            out += ",\"queueDepth\":" + Size(e.queueDepth.Take()) +
+                   ",\"dropped\":" + std::to_string(e.dropped.load(std::memory_order_relaxed)) + "}";
+        }
+        out += "]";
+        if (!extra.empty()) out += "," + extra;
+        return out + "}";
+    }
+
+private:
+    static std::string Num(double v) { return JsonNum(v); }
+    static std::string Time(const Histogram::Snapshot& s) { return JsonTimeUs(s); }
+
+    static std::string Size(const Histogram::Snapshot& s) {
+        return "{\"count\":" + std::to_string(s.count) + ",\"mean\":" + Num(s.Mean()) +
+               ",\"p50\":" + std::to_string(s.Percentile(0.5)) + ",\"p99\":" +
+               std::to_string(s.Percentile(0.99)) + ",\"max\":" + std::to_string(s.max) + "}";
+    }
+
+    std::array<MethodMetrics, NumMethods> methods_;
+    std::array<EventMetrics, NumEvents> events_;
+    const Clock::time_point start_{Clock::now()};
+};
+
+} // namespace com
+} // namespace ara
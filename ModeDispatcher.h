@@ -0,0 +1,181 @@
+// ModeDispatcher.h - Per-mode method handler tables, switched at runtime without reader locks
+#pragma once
+#include "AraCom_Skeleton.h"
+#include "Metrics.h"
+#include "AraLog.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ara {
+namespace com {
+
+using MethodHandler = std::function<void(const Message&)>;
+
+// Method handlers of one application mode. Built during setup and immutable
+// once added to a ModeDispatcher.
+class HandlerTable {
+public:
+    HandlerTable& On(MethodId id, MethodHandler h) {
+        handlers_[id] = std::move(h);
+        return *this;
+    }
+    // Methods without an entry of their own
+    HandlerTable& Otherwise(MethodHandler h) {
+        fallback_ = std::move(h);
+        return *this;
+    }
+    const MethodHandler* Find(MethodId id) const {
+        auto it = handlers_.find(id);
+        if (it != handlers_.end()) return &it->second;
+        return fallback_ ? &fallback_ : nullptr;
+    }
+
+private:
+    std::unordered_map<MethodId, MethodHandler> handlers_;
+    MethodHandler fallback_;
+};
+
+struct ModeSwitchResult {
+    bool ok{false};                      // mode has a table (otherwise nothing changed)
+    bool drained{true};                  // no dispatch still runs on the previous table
+    std::chrono::nanoseconds publish{0}; // until new requests saw the new table
+    std::chrono::nanoseconds total{0};   // until the previous table was drained (or the deadline)
+};
+
+// Routes requests to the handler table of the active mode. The active table
+// is an atomic pointer (RCU style): Dispatch loads it with no lock and Switch
+// publishes another one with a single store, then waits for a grace period,
+// i.e. until every dispatch that may still be running on the previous table
+// has returned. Readers announce themselves on per-thread striped counters
+// split by epoch parity; Switch flips the epoch twice and waits for each
+// parity to drain, which covers a reader that sampled the epoch before an
+// earlier switch. Tables are never freed, so the grace period bounds how
+// long old-mode behaviour can be observed, not memory lifetime; it is capped
+// by a deadline so a slow handler cannot stall a switch.
+class ModeDispatcher {
+public:
+    static constexpr size_t kStripes = 16;
+
+    // Setup, before the dispatcher is shared: the first mode added is active
+    void AddMode(const std::string& mode, HandlerTable table) {
+        std::unique_ptr<Mode> m(new Mode{mode, std::move(table)});
+        if (!current_.load()) current_.store(m.get());
+        modes_.push_back(std::move(m));
+    }
+
+    bool HasMode(const std::string& mode) const { return FindMode(mode) != nullptr; }
+
+    // Read side: may run on any thread, concurrently with Switch
+    void Dispatch(const Message& msg) const {
+        std::atomic<int64_t>& readers = stripes_[StripeOfThread()].readers[epoch_.load() & 1];
+        readers.fetch_add(1);
+        struct Exit {
+            std::atomic<int64_t>& c;
+            ~Exit() { c.fetch_sub(1, std::memory_order_release); }
+        } exit{readers};
+        const Mode* m = current_.load();
+        if (const MethodHandler* h = m->table.Find(msg.method)) {
+            (*h)(msg);
+        } else {
+            ARA_LOG_WARN("[Com] No handler for method 0x{:x} in mode {}", msg.method, m->name);
+        }
+    }
+
+    // Mode new requests are dispatched to (tables and their names are never freed)
+    const std::string& ActiveMode() const { return current_.load()->name; }
+
+    // Publish mode's table and wait (at most drainTimeout) until nothing runs on
+    // the previous one. Must not be called from a handler of this dispatcher:
+    // it would wait for itself until the deadline.
+    ModeSwitchResult Switch(const std::string& mode,
+                            std::chrono::milliseconds drainTimeout = std::chrono::milliseconds(100)) {
+        using Clock = std::chrono::steady_clock;
+        ModeSwitchResult r;
+        const Mode* next = FindMode(mode);
+        if (!next) {
+            ARA_LOG_ERROR("[Com] No handler table for mode {}, staying in {}", mode, ActiveMode());
+            return r;
+        }
+        std::lock_guard<std::mutex> lk(switchMu_);
+        const auto t0 = Clock::now();
+        const Mode* prev = current_.exchange(next);
+        r.ok = true;
+        r.publish = Clock::now() - t0;
+        if (prev != next) {
+            const auto deadline = t0 + drainTimeout;
+            for (int flip = 0; flip < 2 && r.drained; ++flip) {
+                r.drained = WaitForReaders(epoch_.fetch_add(1) & 1, deadline);
+            }
+        }
+        r.total = Clock::now() - t0;
+        publishNs_.Record(static_cast<uint64_t>(r.publish.count()));
+        switchNs_.Record(static_cast<uint64_t>(r.total.count()));
+        if (!r.drained) {
+            ARA_LOG_WARN("[Com] Mode {} -> {}: requests still running on {} after {}ms",
+                         prev->name, next->name, prev->name, drainTimeout.count());
+        }
+        return r;
+    }
+
+    // {"count":..,"publishUs":{..},"switchUs":{..}}
+    std::string SwitchJson() const {
+        return "{\"count\":" + std::to_string(switchNs_.Count()) + ",\"publishUs\":" +
+               JsonTimeUs(publishNs_.Take()) + ",\"switchUs\":" + JsonTimeUs(switchNs_.Take()) + "}";
+    }
+
+private:
+    struct Mode {
+        std::string name;
+        HandlerTable table;
+    };
+
+    // Dispatches in flight per epoch parity; one cache line per stripe
+    struct alignas(64) Stripe {
+        std::atomic<int64_t> readers[2];
+        Stripe() { readers[0] = 0; readers[1] = 0; }
+    };
+
+    static size_t StripeOfThread() {
+        static std::atomic<size_t> next{0};
+        static thread_local const size_t stripe = next.fetch_add(1, std::memory_order_relaxed) % kStripes;
+        return stripe;
+    }
+
+    const Mode* FindMode(const std::string& mode) const {
+        for (const auto& m : modes_) {
+            if (m->name == mode) return m.get();
+        }
+        return nullptr;
+    }
+
+    bool WaitForReaders(unsigned parity, std::chrono::steady_clock::time_point deadline) const {
+        for (unsigned spins = 0;; ++spins) {
+            int64_t n = 0;
+            for (const auto& s : stripes_) n += s.readers[parity].load(std::memory_order_acquire);
+            if (n == 0) return true;
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            if (spins < 64) continue;
+            if (spins < 1024) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    std::vector<std::unique_ptr<Mode>> modes_;
+    std::atomic<const Mode*> current_{nullptr};
+    std::atomic<unsigned> epoch_{0};
+    mutable std::array<Stripe, kStripes> stripes_;
+    std::mutex switchMu_; // serializes writers only
+    Histogram publishNs_;
+    Histogram switchNs_;
+};
+
+} // namespace com
+} // namespace ara
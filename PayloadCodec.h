@@ -0,0 +1,379 @@
+// PayloadCodec.h
+#pragma once
+#include "AraCom_Skeleton.h"
+#include "SomeipSerializer.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * Codec for event streams whose consecutive payloads are mostly identical
+ * (events declared Coded<> in the service description):
+ * - delta: a frame is XORed with the previous one, so unchanged bytes become 0
+ * - compression: the result is packed with a small LZ77 coder (LZ4 style
+ *   block: token, literals, 16-bit offset, match length)
+ * - keyframes: every n-th frame is coded without delta, so a subscriber that
+ *   joined late or lost a notification resynchronizes
+ *
+ * Frame layout (big endian):
+ *   [uint8 flags][uint32 sequence][uint32 decoded size][body]
+ *   flags: 0x10 format version | 0x01 delta to frame sequence-1 | 0x02 LZ body
+ *
+ * XOR and match search run on SSE2/AVX2 when the CPU has it.
+ */
+
+namespace ara {
+namespace com {
+
+struct CodecConfig {
+    bool delta{true};              // XOR with the previous frame
+    bool compress{true};           // LZ-compress (kept only if smaller)
+    uint32_t keyframeInterval{32}; // frames per keyframe, 0 = only the first one
+};
+
+namespace codec {
+
+constexpr uint8_t kVersion = 0x10;
+constexpr uint8_t kDelta = 0x01;
+constexpr uint8_t kLz = 0x02;
+constexpr size_t kHeaderSize = 9;
+constexpr size_t kMaxFrame = size_t(1) << 30; // decoded size accepted from the wire
+
+namespace detail {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5; // a block always ends with literals...
+constexpr size_t kMatchFree = 12;   // ...and no match starts this close to its end
+constexpr size_t kMaxOffset = 65535;
+constexpr unsigned kHashBits = 12;
+
+inline uint32_t Load32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+inline uint64_t Load64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+inline void Store64(uint8_t* p, uint64_t v) { std::memcpy(p, &v, 8); }
+
+inline void XorScalar(uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) Store64(dst + i, Load64(a + i) ^ Load64(b + i));
+    for (; i < n; ++i) dst[i] = a[i] ^ b[i];
+}
+
+// Bytes a and b have in common from the start, at most limit
+inline size_t MatchLengthScalar(const uint8_t* a, const uint8_t* b, size_t limit) {
+    size_t n = 0;
+    for (; n + 8 <= limit; n += 8) {
+        const uint64_t diff = Load64(a + n) ^ Load64(b + n);
+        if (diff) {
+            return n + (ser::detail::kLittleEndianHost ? __builtin_ctzll(diff) : __builtin_clzll(diff)) / 8;
+        }
+    }
+    while (n < limit && a[n] == b[n]) ++n;
+    return n;
+}
+
+#if defined(ARACOM_SER_X86)
+__attribute__((target("sse2")))
+inline void XorSse2(uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(x, y));
+    }
+    XorScalar(dst + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline void XorAvx2(uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(x, y));
+    }
+    XorScalar(dst + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2")))
+inline size_t MatchLengthSse2(const uint8_t* a, const uint8_t* b, size_t limit) {
+    size_t n = 0;
+    for (; n + 16 <= limit; n += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + n));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + n));
+        const unsigned equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+        if (equal != 0xFFFF) return n + __builtin_ctz(~equal);
+    }
+    return n + MatchLengthScalar(a + n, b + n, limit - n);
+}
+#endif
+
+// dst = a ^ b over n bytes (dst may be a or b)
+inline void Xor(uint8_t* dst, const uint8_t* a, const uint8_t* b, size_t n) {
+#if defined(ARACOM_SER_X86)
+    if (n >= 64) {
+        const int level = ser::detail::SimdLevel();
+        if (level == 2) { XorAvx2(dst, a, b, n); return; }
+        if (level == 1) { XorSse2(dst, a, b, n); return; }
+    }
+#endif
+    XorScalar(dst, a, b, n);
+}
+
+inline size_t MatchLength(const uint8_t* a, const uint8_t* b, size_t limit) {
+#if defined(ARACOM_SER_X86)
+    if (ser::detail::SimdLevel() >= 1) return MatchLengthSse2(a, b, limit);
+#endif
+    return MatchLengthScalar(a, b, limit);
+}
+
+inline uint8_t* PutLength(uint8_t* op, size_t len) {
+    for (; len >= 255; len -= 255) *op++ = 255;
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+}
+
+inline bool GetLength(const uint8_t*& ip, const uint8_t* end, size_t& len) {
+    uint8_t b;
+    do {
+        if (ip == end || len > kMaxFrame) return false;
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+// One sequence: literals, then (unless last) a match of len bytes at offset back
+inline uint8_t* PutSequence(uint8_t* op, const uint8_t* lit, size_t litLen, size_t offset, size_t len) {
+    const size_t ml = len ? len - kMinMatch : 0;
+    *op++ = static_cast<uint8_t>((litLen < 15 ? litLen : 15) << 4 | (ml < 15 ? ml : 15));
+    if (litLen >= 15) op = PutLength(op, litLen - 15);
+    if (litLen) std::memcpy(op, lit, litLen);
+    op += litLen;
+    if (!len) return op;
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    if (ml >= 15) op = PutLength(op, ml - 15);
+    return op;
+}
+
+// Copy len bytes from offset bytes back; source and destination may overlap
+inline void CopyMatch(uint8_t* op, size_t offset, size_t len) {
+    const uint8_t* src = op - offset;
+    if (offset >= 16) {
+        size_t i = 0;
+        for (; i + 16 <= len; i += 16) std::memcpy(op + i, src + i, 16);
+        std::memcpy(op + i, src + i, len - i);
+    } else if (offset == 1) {
+        std::memset(op, *src, len); // run of one byte: the common case after XOR
+    } else {
+        for (size_t i = 0; i < len; ++i) op[i] = src[i];
+    }
+}
+
+} // namespace detail
+
+// Worst case size of Compress() output for n input bytes
+inline size_t LzBound(size_t n) { return n + n / 255 + 16; }
+
+// Greedy LZ77 compressor; keeps its hash table between calls (stale entries
+// are rejected by the match check, so it never needs clearing)
+class LzCompressor {
+public:
+    // Compress n bytes into out (LzBound(n) bytes); returns the compressed size
+    size_t Compress(const uint8_t* in, size_t n, uint8_t* out) {
+        using namespace detail;
+        uint8_t* op = out;
+        size_t anchor = 0;
+        if (n > kMatchFree) {
+            const size_t mflimit = n - kMatchFree;
+            const size_t matchlimit = n - kLastLiterals;
+            size_t ip = 0;
+            while (ip < mflimit) {
+                const uint32_t seq = Load32(in + ip);
+                uint32_t& slot = table_[Hash(seq)];
+                size_t ref = slot;
+                slot = static_cast<uint32_t>(ip);
+                if (ref >= ip || ip - ref > kMaxOffset || Load32(in + ref) != seq) {
+                    ip += 1 + ((ip - anchor) >> 6); // skip faster through incompressible data
+                    continue;
+                }
+                while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) { --ip; --ref; }
+                const size_t len = kMinMatch + MatchLength(in + ip + kMinMatch, in + ref + kMinMatch,
+                                                           matchlimit - ip - kMinMatch);
+                op = PutSequence(op, in + anchor, ip - anchor, ip - ref, len);
+                ip += len;
+                anchor = ip;
+                if (ip < mflimit) table_[Hash(Load32(in + ip - 2))] = static_cast<uint32_t>(ip - 2);
+            }
+        }
+        op = PutSequence(op, in + anchor, n - anchor, 0, 0);
+        return static_cast<size_t>(op - out);
+    }
+
+private:
+    static uint32_t Hash(uint32_t v) { return (v * 2654435761u) >> (32 - detail::kHashBits); }
+
+    uint32_t table_[1u << detail::kHashBits] = {};
+};
+
+// Decompress into exactly outSize bytes; false if in is not such a block
+inline bool LzDecompress(const uint8_t* in, size_t n, uint8_t* out, size_t outSize) {
+    using namespace detail;
+    const uint8_t* ip = in;
+    const uint8_t* const iend = in + n;
+    uint8_t* op = out;
+    uint8_t* const oend = out + outSize;
+    for (;;) {
+        if (ip == iend) return false;
+        const unsigned token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !GetLength(ip, iend, lit)) return false;
+        if (size_t(iend - ip) < lit || size_t(oend - op) < lit) return false;
+        if (lit) std::memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == iend) return op == oend;
+        if (iend - ip < 2) return false;
+        const size_t offset = size_t(ip[0]) | size_t(ip[1]) << 8;
+        ip += 2;
+        if (offset == 0 || offset > size_t(op - out)) return false;
+        size_t len = token & 15;
+        if (len == 15 && !GetLength(ip, iend, len)) return false;
+        len += kMinMatch;
+        if (size_t(oend - op) < len) return false;
+        CopyMatch(op, offset, len);
+        op += len;
+    }
+}
+
+} // namespace codec
+
+// Encoding side of one coded event (not thread safe: one encoder per event,
+// frames must leave in the order they were encoded)
+class FrameEncoder {
+public:
+    explicit FrameEncoder(CodecConfig cfg = CodecConfig()) : cfg_(cfg) {}
+
+    void Configure(const CodecConfig& cfg) {
+        cfg_ = cfg;
+        Reset();
+    }
+
+    // Code the next frame without delta (e.g. a subscriber joined)
+    void Reset() { havePrev_ = false; }
+
+    // Frame for size bytes of data; valid until the next call
+    const std::vector<uint8_t>& Encode(const uint8_t* data, size_t size) {
+        using namespace codec;
+        const bool key = !cfg_.delta || !havePrev_ ||
+                         (cfg_.keyframeInterval && sinceKey_ >= cfg_.keyframeInterval);
+        const uint8_t* body = data;
+        if (!key) {
+            const size_t common = std::min(size, prev_.size());
+            delta_.resize(size);
+            codec::detail::Xor(delta_.data(), data, prev_.data(), common);
+            std::memcpy(delta_.data() + common, data + common, size - common);
+            body = delta_.data();
+        }
+
+        out_.resize(kHeaderSize + LzBound(size));
+        uint8_t flags = kVersion | (key ? 0 : kDelta);
+        size_t bodySize = size;
+        if (cfg_.compress) {
+            const size_t n = lz_.Compress(body, size, out_.data() + kHeaderSize);
+            if (n < size) {
+                flags |= kLz;
+                bodySize = n;
+            }
+        }
+        if (!(flags & kLz)) std::memcpy(out_.data() + kHeaderSize, body, size);
+        const uint32_t raw = static_cast<uint32_t>(size);
+        const uint8_t hdr[kHeaderSize] = {flags, uint8_t(seq_ >> 24), uint8_t(seq_ >> 16), uint8_t(seq_ >> 8),
+                                          uint8_t(seq_), uint8_t(raw >> 24), uint8_t(raw >> 16), uint8_t(raw >> 8),
+                                          uint8_t(raw)};
+        std::memcpy(out_.data(), hdr, kHeaderSize);
+        out_.resize(kHeaderSize + bodySize);
+
+        prev_.assign(data, data + size);
+        havePrev_ = true;
+        ++seq_;
+        sinceKey_ = key ? 1 : sinceKey_ + 1;
+        rawBytes_ += size;
+        wireBytes_ += out_.size();
+        return out_;
+    }
+
+    uint64_t RawBytes() const { return rawBytes_; }
+    uint64_t WireBytes() const { return wireBytes_; }
+
+private:
+    CodecConfig cfg_;
+    codec::LzCompressor lz_;
+    std::vector<uint8_t> prev_;  // last frame as given to Encode
+    std::vector<uint8_t> delta_; // scratch: frame XOR prev_
+    std::vector<uint8_t> out_;
+    bool havePrev_{false};
+    uint32_t seq_{0};
+    uint32_t sinceKey_{0};
+    uint64_t rawBytes_{0};
+    uint64_t wireBytes_{0};
+};
+
+// Decoding side of one coded event. Decoded frames are handed out as views of
+// a buffer the decoder only reuses once the caller has dropped them.
+class FrameDecoder {
+public:
+    // False if the frame is malformed or is a delta to a frame this decoder
+    // does not have (lost or sent before it subscribed); deltas are then
+    // dropped until the next keyframe
+    bool Decode(const uint8_t* data, size_t size, Payload& out) {
+        using namespace codec;
+        if (size < kHeaderSize || (data[0] & 0xF0) != kVersion) return Drop();
+        const uint8_t flags = data[0];
+        const uint32_t seq = uint32_t(data[1]) << 24 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 8 | data[4];
+        const size_t raw = size_t(data[5]) << 24 | size_t(data[6]) << 16 | size_t(data[7]) << 8 | data[8];
+        const bool delta = flags & kDelta;
+        if (raw > kMaxFrame) return Drop();
+        if (delta && (!prev_ || seq != lastSeq_ + 1)) {
+            prev_.reset();
+            return Drop();
+        }
+
+        if (!next_ || next_.use_count() > 1) next_ = std::make_shared<std::vector<uint8_t>>();
+        next_->resize(raw);
+        const uint8_t* body = data + kHeaderSize;
+        const size_t bodySize = size - kHeaderSize;
+        if (flags & kLz) {
+            if (!LzDecompress(body, bodySize, next_->data(), raw)) return Drop();
+        } else {
+            if (bodySize != raw) return Drop();
+            std::memcpy(next_->data(), body, raw);
+        }
+        if (delta) codec::detail::Xor(next_->data(), next_->data(), prev_->data(), std::min(raw, prev_->size()));
+
+        std::swap(prev_, next_);
+        lastSeq_ = seq;
+        out = Payload(prev_, prev_->data(), prev_->size());
+        return true;
+    }
+
+    // A reference frame is held, so the next delta can be decoded
+    bool Synced() const { return prev_ != nullptr; }
+    uint64_t Dropped() const { return dropped_; }
+
+private:
+    bool Drop() {
+        ++dropped_;
+        return false;
+    }
+
+    std::shared_ptr<std::vector<uint8_t>> prev_; // last decoded frame (delta reference)
+    std::shared_ptr<std::vector<uint8_t>> next_; // buffer for the next one
+    uint32_t lastSeq_{0};
+    uint64_t dropped_{0};
+};
+
+} // namespace com
+} // namespace ara
@@ -0,0 +1,176 @@
+// PayloadPool.h
+#pragma once
+#include <vsomeip/vsomeip.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ara {
+namespace com {
+
+// Counters of PayloadPool activity (monotonic since process start)
+struct PoolStats {
+    uint64_t hits{0};      // Acquire served by a recycled payload
+    uint64_t misses{0};    // Acquire had to create a new payload
+    uint64_t oversize{0};  // Size above the largest class, not pooled
+    uint64_t dropped{0};   // Payload still referenced elsewhere on release, not recycled
+};
+
+// Process-wide pool of preallocated vsomeip payloads in fixed size classes.
+// Each thread keeps a small cache per class and exchanges batches with a
+// shared depot, so steady-state SendEvent neither allocates nor takes a lock.
+class PayloadPool {
+public:
+    static constexpr size_t kNumClasses = 5;
+    static constexpr size_t kCacheMax   = 32; // per thread and class
+    static constexpr size_t kBatch      = 16; // payloads moved between cache and depot
+
+    // Capacity of size class i: 256 B, 1 KiB, 4 KiB, 16 KiB, 64 KiB
+    static uint32_t ClassSize(size_t i) { return 256u << (2 * i); }
+
+    // Smallest class holding size bytes, or -1 if it does not fit any
+    static int ClassFor(size_t size) {
+        for (size_t i = 0; i < kNumClasses; ++i) {
+            if (size <= ClassSize(i)) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // RAII handle: returns the payload to the pool when destroyed
+    class Lease {
+        std::shared_ptr<vsomeip::payload> pl_;
+        int cls_{-1};
+        friend class PayloadPool;
+        Lease(std::shared_ptr<vsomeip::payload> pl, int cls) : pl_(std::move(pl)), cls_(cls) {}
+    public:
+        Lease() = default;
+        Lease(Lease&& o) noexcept : pl_(std::move(o.pl_)), cls_(o.cls_) { o.cls_ = -1; }
+        Lease& operator=(Lease&& o) noexcept {
+            if (this != &o) { Reset(); pl_ = std::move(o.pl_); cls_ = o.cls_; o.cls_ = -1; }
+            return *this;
+        }
+        ~Lease() { Reset(); }
+
+        explicit operator bool() const { return pl_ != nullptr; }
+        const std::shared_ptr<vsomeip::payload>& Get() const { return pl_; }
+
+        void Reset() {
+            if (pl_ && cls_ >= 0) PayloadPool::Instance().Release(std::move(pl_), cls_);
+            pl_.reset();
+            cls_ = -1;
+        }
+    };
+
+    static PayloadPool& Instance() {
+        static PayloadPool inst;
+        return inst;
+    }
+
+    // Get a payload with capacity for size bytes; empty Lease if size is above the largest class
+    Lease Acquire(size_t size) {
+        const int cls = ClassFor(size);
+        if (cls < 0) {
+            oversize_.fetch_add(1, std::memory_order_relaxed);
+            return Lease();
+        }
+        auto& free = Cache().free[cls];
+        if (free.empty()) Refill(free, cls);
+        if (!free.empty()) {
+            auto pl = std::move(free.back());
+            free.pop_back();
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return Lease(std::move(pl), cls);
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return Lease(Create(cls), cls);
+    }
+
+    // Preallocate n payloads per class into the depot (call once at startup)
+    void Prefill(size_t n) {
+        for (size_t c = 0; c < kNumClasses; ++c) {
+            std::vector<std::shared_ptr<vsomeip::payload>> fresh;
+            fresh.reserve(n);
+            for (size_t i = 0; i < n; ++i) fresh.push_back(Create(static_cast<int>(c)));
+            std::lock_guard<std::mutex> lk(mu_);
+            for (auto& p : fresh) depot_[c].push_back(std::move(p));
+        }
+    }
+
+    PoolStats Stats() const {
+        PoolStats s;
+        s.hits     = hits_.load(std::memory_order_relaxed);
+        s.misses   = misses_.load(std::memory_order_relaxed);
+        s.oversize = oversize_.load(std::memory_order_relaxed);
+        s.dropped  = dropped_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    using FreeList = std::vector<std::shared_ptr<vsomeip::payload>>;
+
+    // Per-thread free lists; handed back to the depot when the thread exits
+    struct ThreadCache {
+        std::array<FreeList, kNumClasses> free;
+        ThreadCache() { for (auto& f : free) f.reserve(kCacheMax); }
+        ~ThreadCache() {
+            auto& pool = PayloadPool::Instance();
+            std::lock_guard<std::mutex> lk(pool.mu_);
+            for (size_t c = 0; c < kNumClasses; ++c) {
+                for (auto& p : free[c]) pool.depot_[c].push_back(std::move(p));
+            }
+        }
+    };
+
+    PayloadPool() = default;
+
+    static ThreadCache& Cache() {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+
+    static std::shared_ptr<vsomeip::payload> Create(int cls) {
+        auto pl = vsomeip::runtime::get()->create_payload();
+        pl->set_capacity(ClassSize(cls));
+        return pl;
+    }
+
+    void Refill(FreeList& free, int cls) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto& d = depot_[cls];
+        for (size_t i = 0; i < kBatch && !d.empty(); ++i) {
+            free.push_back(std::move(d.back()));
+            d.pop_back();
+        }
+    }
+
+    void Release(std::shared_ptr<vsomeip::payload>&& pl, int cls) {
+        // The transport may still hold it (e.g. queued for sending): let it go
+        if (pl.use_count() != 1) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            pl.reset();
+            return;
+        }
+        auto& free = Cache().free[cls];
+        if (free.size() >= kCacheMax) {
+            std::lock_guard<std::mutex> lk(mu_);
+            for (size_t i = 0; i < kBatch; ++i) {
+                depot_[cls].push_back(std::move(free.back()));
+                free.pop_back();
+            }
+        }
+        free.push_back(std::move(pl));
+    }
+
+    std::mutex mu_;
+    std::array<FreeList, kNumClasses> depot_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> oversize_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace com
+} // namespace ara
@@ -0,0 +1,206 @@
+// PendingRequests.h
+#pragma once
+#include "AraCom_Skeleton.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ara {
+namespace com {
+
+// Build the RequestToken of a request: (client ID << 16) | session ID
+inline RequestToken MakeRequestToken(uint16_t client, uint16_t session) {
+    return (static_cast<RequestToken>(client) << 16) | session;
+}
+
+// Thread-safe table of requests that are still waiting for an answer.
+// Entries are keyed by RequestToken, carry a deadline and are split across
+// shards so that handlers completing on different threads rarely contend.
+template <typename T>
+class PendingTable {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit PendingTable(std::chrono::milliseconds timeout = std::chrono::seconds(5))
+        : timeout_(timeout) {}
+
+    // Save a value with the default timeout (an existing entry for token is replaced)
+    void Insert(RequestToken token, T value) {
+        Insert(token, std::move(value), Clock::now() + timeout_);
+    }
+
+    // Save a value that expires at an explicit deadline
+    void Insert(RequestToken token, T value, Clock::time_point deadline) {
+        auto& s = ShardFor(token);
+        std::lock_guard<std::mutex> lk(s.mu);
+        auto it = s.map.find(token);
+        if (it != s.map.end()) {
+            it->second = Entry{std::move(value), deadline};
+            return;
+        }
+        s.map.emplace(token, Entry{std::move(value), deadline});
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Remove the entry for token; returns false if it is unknown or already evicted
+    bool Take(RequestToken token, T& out) {
+        auto& s = ShardFor(token);
+        std::lock_guard<std::mutex> lk(s.mu);
+        auto it = s.map.find(token);
+        if (it == s.map.end()) return false;
+        out = std::move(it->second.value);
+        s.map.erase(it);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Drop every entry whose deadline has passed; onEvict(token, value) is called
+    // for each one outside the shard lock. Returns number of evicted entries.
+    template <typename F>
+    size_t EvictExpired(Clock::time_point now, F&& onEvict) {
+        size_t n = 0;
+        for (auto& s : shards_) {
+            std::vector<std::pair<RequestToken, T>> expired;
+            {
+                std::lock_guard<std::mutex> lk(s.mu);
+                for (auto it = s.map.begin(); it != s.map.end();) {
+                    if (it->second.deadline <= now) {
+                        expired.emplace_back(it->first, std::move(it->second.value));
+                        it = s.map.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+            size_.fetch_sub(expired.size(), std::memory_order_relaxed);
+            for (auto& e : expired) onEvict(e.first, std::move(e.second));
+            n += expired.size();
+        }
+        evicted_.fetch_add(n, std::memory_order_relaxed);
+        return n;
+    }
+
+    size_t EvictExpired(Clock::time_point now = Clock::now()) {
+        return EvictExpired(now, [](RequestToken, T&&) {});
+    }
+
+    // Sweep at most once per timeout period; cheap enough to call on every insert
+    size_t MaybeEvict(Clock::time_point now = Clock::now()) {
+        auto next = next_sweep_.load(std::memory_order_relaxed);
+        const auto stamp = now.time_since_epoch().count();
+        if (stamp < next) return 0;
+        const auto period = std::chrono::duration_cast<Clock::duration>(timeout_).count();
+        if (!next_sweep_.compare_exchange_strong(next, stamp + period)) return 0;
+        return EvictExpired(now);
+    }
+
+    size_t Size() const { return size_.load(std::memory_order_relaxed); }
+    uint64_t Evicted() const { return evicted_.load(std::memory_order_relaxed); }
+    std::chrono::milliseconds Timeout() const { return timeout_; }
+
+private:
+    struct Entry {
+        T value;
+        Clock::time_point deadline;
+    };
+    struct Shard {
+        std::mutex mu;
+        std::unordered_map<RequestToken, Entry> map;
+    };
+    static constexpr size_t kShards = 16;
+
+    // Sessions increase monotonically, so the low bits spread entries evenly
+    Shard& ShardFor(RequestToken token) { return shards_[token % kShards]; }
+
+    std::chrono::milliseconds timeout_;
+    std::array<Shard, kShards> shards_;
+    std::atomic<size_t> size_{0};
+    std::atomic<uint64_t> evicted_{0};
+    std::atomic<Clock::rep> next_sweep_{0};
+};
+
+// Tracks the asynchronous calls of a proxy: a PendingTable of CallStates plus
+// a reaper thread that sleeps until the earliest deadline and fails expired calls
+class CallTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CallTracker() : reaper_([this] { ReapLoop(); }) {}
+
+    ~CallTracker() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (reaper_.joinable()) reaper_.join();
+    }
+
+    // Register a call under token; it fails with CallStatus::kTimeout at deadline
+    CallHandle Track(RequestToken token, std::shared_ptr<CallState> st, Clock::time_point deadline) {
+        Watch(token, st, deadline);
+        return CallHandle(std::move(st), token);
+    }
+
+    // Same for a call whose handle was handed out already (e.g. under another token)
+    void Watch(RequestToken token, std::shared_ptr<CallState> st, Clock::time_point deadline) {
+        calls_.Insert(token, std::move(st), deadline);
+        std::lock_guard<std::mutex> lk(mu_);
+        const bool earliest = deadlines_.empty() || deadline < deadlines_.top();
+        deadlines_.push(deadline);
+        if (earliest) cv_.notify_one();
+    }
+
+    // Remove the call registered under token; false if unknown or already expired
+    bool Take(RequestToken token, std::shared_ptr<CallState>& st) { return calls_.Take(token, st); }
+
+    // Fail every registered call now; returns how many there were
+    size_t FailAll(CallStatus status, const std::string& what) {
+        return calls_.EvictExpired(Clock::time_point::max(), [&](RequestToken, std::shared_ptr<CallState>&& st) {
+            st->Fail(status, what);
+        });
+    }
+
+    size_t Size() const { return calls_.Size(); }
+
+private:
+    void ReapLoop() {
+        std::unique_lock<std::mutex> lk(mu_);
+        while (!stopping_) {
+            if (deadlines_.empty()) {
+                cv_.wait(lk);
+                continue;
+            }
+            const auto next = deadlines_.top();
+            if (cv_.wait_until(lk, next) != std::cv_status::timeout && Clock::now() < next) continue;
+            const auto now = Clock::now();
+            while (!deadlines_.empty() && deadlines_.top() <= now) deadlines_.pop();
+            lk.unlock();
+            calls_.EvictExpired(now, [](RequestToken, std::shared_ptr<CallState>&& st) {
+                st->Fail(CallStatus::kTimeout, "method call timed out");
+            });
+            lk.lock();
+        }
+    }
+
+    PendingTable<std::shared_ptr<CallState>> calls_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::priority_queue<Clock::time_point, std::vector<Clock::time_point>,
+                        std::greater<Clock::time_point>> deadlines_;
+    bool stopping_{false};
+    std::thread reaper_; // last: started once the members above exist
+};
+
+} // namespace com
+} // namespace ara
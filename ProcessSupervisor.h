@@ -0,0 +1,403 @@
+// ProcessSupervisor.h - Launch executables and supervise them from one epoll loop
+#pragma once
+#include "ExecManager.h"
+#include "AraLog.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+extern char** environ;
+
+namespace ara {
+namespace execm {
+
+// Set in the environment of every supervised child (see ApplicationClient::Supervised)
+constexpr const char* kSupervisedEnv = "ARA_EXEC_SUPERVISED";
+// Manifest executable the child was launched as (see server.cpp LoadManifest)
+constexpr const char* kAppIdEnv = "ARA_APP_ID";
+
+// How to launch and restart one executable
+struct ProcessSpec {
+    std::string path;                                // executable
+    std::vector<std::string> args;                   // argv[1..]
+    RestartPolicy policy{RestartPolicy::kOnFailure};
+    int maxRestarts{-1};                             // -1 = unlimited
+    std::chrono::milliseconds backoffInitial{100};   // delay before the first restart
+    std::chrono::milliseconds backoffMax{30000};     // doubled per consecutive crash up to this
+    std::chrono::milliseconds stableAfter{10000};    // uptime that resets the backoff
+    int crashLoopCount{5};                           // this many crashes within...
+    std::chrono::milliseconds crashLoopWindow{60000};// ...this window: give up
+    std::chrono::milliseconds stopGrace{3000};       // SIGTERM, then SIGKILL after this
+};
+
+// Spawns supervised apps with posix_spawn and watches all of them through
+// pidfds in a single epoll loop: exits are events, restart backoffs and kill
+// deadlines are the epoll timeout, so one thread serves any number of
+// processes without polling. State changes are reported to ExecManager.
+class ProcessSupervisor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static ProcessSupervisor& Instance() {
+        static ProcessSupervisor inst;
+        return inst;
+    }
+
+    ~ProcessSupervisor() {
+        std::vector<std::string> ids;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            for (const auto& kv : procs_) ids.push_back(kv.first);
+        }
+        for (const auto& id : ids) Terminate(id);
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stopping_ = true;
+        }
+        Wake();
+        if (loop_.joinable()) loop_.join();
+        close(wake_);
+        close(ep_);
+    }
+
+    // Register cfg with ExecManager as a supervised process: starting the app
+    // spawns spec.path, stopping it terminates the process. Policy and restart
+    // limit come from cfg. An app stopped after being removed from the
+    // manifest may be supervised again.
+    bool Supervise(const AppConfig& cfg, ProcessSpec spec) {
+        spec.policy = cfg.policy;
+        spec.maxRestarts = cfg.maxRestarts;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            Proc* p = Find(cfg.appId);
+            if (p && p->pid > 0) return false;
+            if (p) {
+                p->spec = std::move(spec);
+                p->restarts = 0;
+            } else {
+                std::unique_ptr<Proc> fresh(new Proc);
+                fresh->appId = cfg.appId;
+                fresh->spec = std::move(spec);
+                procs_.emplace(cfg.appId, std::move(fresh));
+            }
+        }
+        const std::string id = cfg.appId;
+        return ExecManager::Instance().Register(cfg,
+            [this, id] {
+                if (!Launch(id)) throw std::runtime_error("cannot spawn " + id);
+            },
+            [this, id] { Terminate(id); });
+    }
+
+    // Replace the spec of a supervised app (manifest reload). The running
+    // process is left alone: policy and limits apply to its next exit, path and
+    // arguments to its next spawn. False if appId is not supervised.
+    bool Update(const AppConfig& cfg, ProcessSpec spec) {
+        spec.policy = cfg.policy;
+        spec.maxRestarts = cfg.maxRestarts;
+        std::lock_guard<std::mutex> lk(mu_);
+        Proc* p = Find(cfg.appId);
+        if (!p) return false;
+        p->spec = std::move(spec);
+        return true;
+    }
+
+    // Spawn the app now (ExecManager::Start); false if it cannot be spawned
+    bool Launch(const std::string& appId) {
+        std::lock_guard<std::mutex> lk(mu_);
+        Proc* p = Find(appId);
+        if (!p) return false;
+        if (p->pid > 0) return true;
+        p->stopping = false;
+        p->gen++; // cancels a pending restart
+        p->consecutive = 0;
+        p->crashes.clear();
+        return Spawn(*p);
+    }
+
+    // Stop the app and wait until it exited: SIGTERM, SIGKILL after stopGrace.
+    // An expected exit is never restarted.
+    void Terminate(const std::string& appId) {
+        std::unique_lock<std::mutex> lk(mu_);
+        Proc* p = Find(appId);
+        if (!p) return;
+        p->stopping = true;
+        p->gen++;
+        if (p->pid <= 0) return;
+        kill(-p->pid, SIGTERM);
+        AddTimer(Clock::now() + p->spec.stopGrace, Timer::kKill, p);
+        exited_.wait(lk, [&] { return p->pid <= 0; });
+    }
+
+    pid_t Pid(const std::string& appId) {
+        std::lock_guard<std::mutex> lk(mu_);
+        Proc* p = Find(appId);
+        return p ? p->pid : -1;
+    }
+
+    int Restarts(const std::string& appId) {
+        std::lock_guard<std::mutex> lk(mu_);
+        Proc* p = Find(appId);
+        return p ? p->restarts : 0;
+    }
+
+private:
+    struct Proc {
+        std::string appId;
+        ProcessSpec spec;
+        pid_t pid{-1};
+        int pidfd{-1};
+        bool stopping{false};         // the next exit is expected
+        int restarts{0};
+        int consecutive{0};           // crashes since the last stable run
+        std::deque<Clock::time_point> crashes; // within crashLoopWindow
+        Clock::time_point startedAt;
+        uint64_t gen{0};              // bumped to invalidate queued timers
+    };
+
+    struct Timer {
+        enum Kind { kRestart, kKill };
+        Clock::time_point at;
+        Kind kind;
+        Proc* proc;
+        uint64_t gen;
+        bool operator>(const Timer& o) const { return at > o.at; }
+    };
+
+    struct Report {
+        std::string appId;
+        AppState state;
+    };
+
+    ProcessSupervisor() {
+        ep_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr; // the wake eventfd
+        epoll_ctl(ep_, EPOLL_CTL_ADD, wake_, &ev);
+        loop_ = std::thread([this] { Loop(); });
+    }
+
+    Proc* Find(const std::string& appId) {
+        auto it = procs_.find(appId);
+        return it == procs_.end() ? nullptr : it->second.get();
+    }
+
+    void Wake() {
+        const uint64_t one = 1;
+        if (write(wake_, &one, sizeof(one)) < 0) { /* counter saturated: already awake */ }
+    }
+
+    // Caller holds mu_
+    void AddTimer(Clock::time_point at, Timer::Kind kind, Proc* p) {
+        const bool earliest = timers_.empty() || at < timers_.top().at;
+        timers_.push(Timer{at, kind, p, p->gen});
+        if (earliest) Wake();
+    }
+
+    // Caller holds mu_
+    bool Spawn(Proc& p) {
+        std::vector<std::string> env;
+        const std::string appIdVar = std::string(kAppIdEnv) + "=";
+        for (char** e = environ; *e; ++e) {
+            if (std::strncmp(*e, appIdVar.c_str(), appIdVar.size()) != 0) env.emplace_back(*e);
+        }
+        env.push_back(std::string(kSupervisedEnv) + "=1");
+        env.push_back(appIdVar + p.appId);
+        std::vector<char*> envp;
+        for (auto& e : env) envp.push_back(&e[0]);
+        envp.push_back(nullptr);
+
+        std::vector<std::string> args{p.spec.path};
+        args.insert(args.end(), p.spec.args.begin(), p.spec.args.end());
+        std::vector<char*> argv;
+        for (auto& a : args) argv.push_back(&a[0]);
+        argv.push_back(nullptr);
+
+        // The child starts with default signal handling and nothing blocked,
+        // whatever this process does with its own signals, and leads its own
+        // process group so stopping it also stops what it forked
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+        sigset_t none, all;
+        sigemptyset(&none);
+        sigfillset(&all);
+        posix_spawnattr_setsigmask(&attr, &none);
+        posix_spawnattr_setsigdefault(&attr, &all);
+        posix_spawnattr_setpgroup(&attr, 0);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETPGROUP);
+        pid_t pid;
+        const int rc = posix_spawn(&pid, p.spec.path.c_str(), nullptr, &attr, argv.data(), envp.data());
+        posix_spawnattr_destroy(&attr);
+        if (rc != 0) {
+            ARA_LOG_ERROR("[ExecMgr] Cannot spawn {} ({}): {}", p.appId, p.spec.path, std::strerror(rc));
+            return false;
+        }
+
+        const int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+        if (fd < 0) {
+            ARA_LOG_ERROR("[ExecMgr] pidfd_open failed for {}: {} (kernel >= 5.3 required), killing it",
+                          p.appId, std::strerror(errno));
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+            return false;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &p;
+        epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev);
+        p.pid = pid;
+        p.pidfd = fd;
+        p.startedAt = Clock::now();
+        ARA_LOG_INFO("[ExecMgr] Spawned {} pid={}", p.appId, pid);
+        return true;
+    }
+
+    void Loop() {
+        epoll_event events[64];
+        for (;;) {
+            int timeout = -1;
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                if (stopping_) return;
+                if (!timers_.empty()) {
+                    const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        timers_.top().at - Clock::now()).count();
+                    timeout = static_cast<int>(std::max<long long>(0, wait + 1));
+                }
+            }
+            const int n = epoll_wait(ep_, events, 64, timeout);
+            if (n < 0 && errno != EINTR) {
+                ARA_LOG_ERROR("[ExecMgr] epoll_wait failed: {}", std::strerror(errno));
+                return;
+            }
+
+            std::vector<Report> reports;
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                for (int i = 0; i < n; ++i) {
+                    if (events[i].data.ptr == nullptr) {
+                        uint64_t v;
+                        while (read(wake_, &v, sizeof(v)) > 0) {}
+                        continue;
+                    }
+                    OnExit(*static_cast<Proc*>(events[i].data.ptr), reports);
+                }
+                RunTimers(reports);
+            }
+            // ExecManager runs its own bookkeeping; never call it under mu_
+            for (const auto& r : reports) ExecManager::Instance().ReportState(r.appId, r.state);
+        }
+    }
+
+    // Caller holds mu_: the pidfd of p became readable, the process exited
+    void OnExit(Proc& p, std::vector<Report>& reports) {
+        int status = 0;
+        if (waitpid(p.pid, &status, WNOHANG) <= 0) return;
+        epoll_ctl(ep_, EPOLL_CTL_DEL, p.pidfd, nullptr);
+        close(p.pidfd);
+        p.pidfd = -1;
+        p.pid = -1;
+        exited_.notify_all();
+        if (p.stopping) return; // Terminate() reports Stopped through ExecManager::Stop
+
+        const auto now = Clock::now();
+        const bool clean = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        if (WIFSIGNALED(status)) {
+            ARA_LOG_WARN("[ExecMgr] {} killed by signal {}", p.appId, WTERMSIG(status));
+        } else {
+            ARA_LOG_WARN("[ExecMgr] {} exited with status {}", p.appId, WEXITSTATUS(status));
+        }
+        if (clean && p.spec.policy != RestartPolicy::kAlways) {
+            reports.push_back(Report{p.appId, AppState::kStopped});
+            return;
+        }
+        if (!clean) reports.push_back(Report{p.appId, AppState::kCrashed});
+
+        if (now - p.startedAt >= p.spec.stableAfter) p.consecutive = 0;
+        p.crashes.push_back(now);
+        while (!p.crashes.empty() && now - p.crashes.front() > p.spec.crashLoopWindow) p.crashes.pop_front();
+
+        const bool allow = p.spec.policy == RestartPolicy::kAlways ||
+                           (p.spec.policy == RestartPolicy::kOnFailure && !clean);
+        const bool below_limit = p.spec.maxRestarts < 0 || p.restarts < p.spec.maxRestarts;
+        if (!allow || !below_limit) {
+            ARA_LOG_ERROR("[ExecMgr] App {} terminated (policy/limit)", p.appId);
+            reports.push_back(Report{p.appId, AppState::kTerminated});
+            return;
+        }
+        if (static_cast<int>(p.crashes.size()) >= p.spec.crashLoopCount) {
+            ARA_LOG_ERROR("[ExecMgr] App {} terminated: crash loop ({} exits within {}ms)", p.appId,
+                          p.crashes.size(), p.spec.crashLoopWindow.count());
+            reports.push_back(Report{p.appId, AppState::kTerminated});
+            return;
+        }
+        auto delay = p.spec.backoffInitial;
+        for (int i = 0; i < p.consecutive && delay < p.spec.backoffMax; ++i) delay *= 2;
+        delay = std::min(delay, p.spec.backoffMax);
+        p.consecutive++;
+        ARA_LOG_WARN("[ExecMgr] Restarting {} in {}ms", p.appId, delay.count());
+        AddTimer(now + delay, Timer::kRestart, &p);
+    }
+
+    // Caller holds mu_
+    void RunTimers(std::vector<Report>& reports) {
+        const auto now = Clock::now();
+        while (!timers_.empty() && timers_.top().at <= now) {
+            const Timer t = timers_.top();
+            timers_.pop();
+            Proc& p = *t.proc;
+            // Launch/Terminate since the timer was set: it belongs to an earlier process
+            if (t.gen != p.gen) continue;
+            if (t.kind == Timer::kKill) {
+                if (p.pid > 0 && p.stopping) kill(-p.pid, SIGKILL);
+                continue;
+            }
+            if (p.stopping || p.pid > 0) continue;
+            if (Spawn(p)) {
+                p.restarts++;
+                reports.push_back(Report{p.appId, AppState::kRunning});
+            } else {
+                reports.push_back(Report{p.appId, AppState::kTerminated});
+            }
+        }
+    }
+
+    std::mutex mu_;
+    std::condition_variable exited_; // Terminate() waits here
+    std::unordered_map<std::string, std::unique_ptr<Proc>> procs_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    int ep_{-1};
+    int wake_{-1};
+    bool stopping_{false};
+    std::thread loop_; // last: started once the members above exist
+};
+
+} // namespace execm
+} // namespace ara
@@ -0,0 +1,52 @@
+// RadarService.h - Service interface of the radar demo (shared by server and client)
+#pragma once
+#include "ServiceInterface.h"
+#include "SomeipSerializer.h"
+
+namespace radar {
+
+// One radar detection (polar coordinates + doppler)
+struct Detection {
+    float range{0};     // m
+    float azimuth{0};   // rad
+    float elevation{0}; // rad
+    float velocity{0};  // m/s, radial
+    float snr{0};       // dB
+    SOMEIP_FIELDS(range, azimuth, elevation, velocity, snr)
+};
+
+// All detections of one radar frame
+struct DetectionList {
+    uint32_t frameId{0};
+    uint64_t timestampNs{0};
+    std::vector<Detection> detections;
+    SOMEIP_FIELDS(frameId, timestampNs, detections)
+};
+
+// Point cloud of one frame: xyz triplets + per-point intensity
+struct PointCloud {
+    uint32_t frameId{0};
+    uint64_t timestampNs{0};
+    std::vector<float> xyz;
+    std::vector<uint16_t> intensity;
+    SOMEIP_FIELDS(frameId, timestampNs, xyz, intensity)
+};
+
+// Calibrate(config string) -> result string
+using Calibrate = ara::com::MethodDesc<0x42>;
+// GetMetrics() -> JSON snapshot of the server binding's histograms (DiagnosticMode only)
+using GetMetrics = ara::com::MethodDesc<0x43>;
+// SwitchMode(mode name) -> result string with the switch latency; answered in every mode
+using SwitchMode = ara::com::MethodDesc<0x44>;
+
+// Events (eventgroup = event ID); detections are small and frequent, so they are batched;
+// point clouds are large and change little between frames, so they are delta coded
+using DetectionsEvent = ara::com::Batched<ara::com::EventDesc<0x8001, DetectionList>>;
+using PointCloudEvent = ara::com::Coded<ara::com::EventDesc<0x8002, PointCloud>>;
+
+// Service 0x1234, instance 0x5678
+using RadarService = ara::com::ServiceDesc<0x1234, 0x5678,
+    ara::com::MethodList<Calibrate, GetMetrics, SwitchMode>,
+    ara::com::EventList<DetectionsEvent, PointCloudEvent>>;
+
+} // namespace radar
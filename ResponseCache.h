@@ -0,0 +1,136 @@
+// ResponseCache.h
+#pragma once
+#include "AraCom_Skeleton.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ara {
+namespace com {
+
+// 64-bit hash of a request payload: 8 bytes per multiply-xorshift round
+inline uint64_t HashBytes(const uint8_t* p, size_t n) {
+    constexpr uint64_t kMul = 0x9E3779B97F4A7C15ull;
+    auto mix = [](uint64_t h) {
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ull;
+        return h ^ (h >> 32);
+    };
+    uint64_t h = n * kMul;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v;
+        std::memcpy(&v, p + i, 8);
+        h = mix(h ^ (v * kMul));
+    }
+    uint64_t tail = 0;
+    if (n > i) std::memcpy(&tail, p + i, n - i);
+    return mix(h ^ (tail * kMul) ^ (n - i));
+}
+
+// Responses of one idempotent method keyed by request payload. Entries are
+// spread over shards by hash, each an LRU list with its own lock, so
+// concurrent lookups rarely contend; an entry older than the TTL counts as a
+// miss. The request bytes are kept and compared, so a hash collision is a
+// miss rather than a wrong answer.
+//
+// Clear() starts a new generation: a response computed for a request seen
+// before it (e.g. under the previous application mode) is not stored.
+class ResponseCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ResponseCache(const ResponseCacheConfig& cfg)
+        : perShard_(std::max<size_t>(1, (cfg.capacity + kShards - 1) / kShards)), ttl_(cfg.ttl) {}
+
+    // Copy of the response stored for request; false if there is none or it expired
+    bool Lookup(uint64_t hash, const Payload& request, std::vector<uint8_t>& response) {
+        Shard& s = shards_[hash % kShards];
+        std::lock_guard<std::mutex> lk(s.mu);
+        auto it = s.index.find(hash);
+        if (it == s.index.end()) return false;
+        Entry& e = *it->second;
+        if (Clock::now() >= e.expires) {
+            s.lru.erase(it->second);
+            s.index.erase(it);
+            return false;
+        }
+        if (e.request.size() != request.size() ||
+            (request.size() && std::memcmp(e.request.data(), request.data(), request.size()) != 0)) {
+            return false;
+        }
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        response = e.response;
+        return true;
+    }
+
+    // Remember response for request, unless the cache was cleared since generation
+    void Store(uint64_t hash, uint64_t generation, const Payload& request, const Payload& response) {
+        Shard& s = shards_[hash % kShards];
+        std::lock_guard<std::mutex> lk(s.mu);
+        if (generation != generation_.load()) return;
+        auto it = s.index.find(hash);
+        if (it != s.index.end()) {
+            s.lru.erase(it->second);
+            s.index.erase(it);
+        } else if (s.lru.size() >= perShard_) {
+            s.index.erase(s.lru.back().hash);
+            s.lru.pop_back();
+        }
+        s.lru.push_front(Entry{hash, std::vector<uint8_t>(request.begin(), request.end()),
+                               std::vector<uint8_t>(response.begin(), response.end()), Clock::now() + ttl_});
+        s.index[hash] = s.lru.begin();
+    }
+
+    // Generation a request is handled under; pass it to Store with the response
+    uint64_t Generation() const { return generation_.load(); }
+
+    // Drop every entry and every response still being computed
+    void Clear() {
+        generation_.fetch_add(1);
+        for (Shard& s : shards_) {
+            std::lock_guard<std::mutex> lk(s.mu);
+            s.lru.clear();
+            s.index.clear();
+        }
+    }
+
+    size_t Size() {
+        size_t n = 0;
+        for (Shard& s : shards_) {
+            std::lock_guard<std::mutex> lk(s.mu);
+            n += s.lru.size();
+        }
+        return n;
+    }
+
+private:
+    static constexpr size_t kShards = 8;
+
+    struct Entry {
+        uint64_t hash;
+        std::vector<uint8_t> request;
+        std::vector<uint8_t> response;
+        Clock::time_point expires;
+    };
+    struct Shard {
+        std::mutex mu;
+        std::list<Entry> lru; // most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    };
+
+    const size_t perShard_;
+    const std::chrono::milliseconds ttl_;
+    std::array<Shard, kShards> shards_;
+    std::atomic<uint64_t> generation_{0};
+};
+
+} // namespace com
+} // namespace ara
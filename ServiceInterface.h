@@ -0,0 +1,158 @@
+// ServiceInterface.h
+#pragma once
+#include "AraCom_Skeleton.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace ara {
+namespace com {
+
+// Identifier for a service interface
+using ServiceId = uint16_t;
+
+// A method of a service interface: ID plus request/response types
+template <MethodId Id, typename Req = Payload, typename Resp = Payload>
+struct MethodDesc {
+    static constexpr MethodId kId = Id;
+    using Request  = Req;
+    using Response = Resp;
+};
+template <MethodId Id, typename Req, typename Resp>
+constexpr MethodId MethodDesc<Id, Req, Resp>::kId;
+
+// An event of a service interface: ID, data type and the eventgroup it is offered in
+template <EventId Id, typename T = Payload, uint16_t Group = Id>
+struct EventDesc {
+    static constexpr EventId kId = Id;
+    static constexpr uint16_t kGroup = Group;
+    static constexpr bool kBatched = false;
+    static constexpr bool kCoded = false;
+    using Type = T;
+};
+template <EventId Id, typename T, uint16_t Group>
+constexpr EventId EventDesc<Id, T, Group>::kId;
+template <EventId Id, typename T, uint16_t Group>
+constexpr uint16_t EventDesc<Id, T, Group>::kGroup;
+template <EventId Id, typename T, uint16_t Group>
+constexpr bool EventDesc<Id, T, Group>::kBatched;
+template <EventId Id, typename T, uint16_t Group>
+constexpr bool EventDesc<Id, T, Group>::kCoded;
+
+// Marks an event as batched: the skeleton packs several notifications into one
+// framed payload and the proxy unpacks them again (see EventBatcher.h)
+template <typename E>
+struct Batched : E {
+    static constexpr bool kBatched = true;
+};
+template <typename E>
+constexpr bool Batched<E>::kBatched;
+
+// Marks an event as coded: the skeleton sends each notification as a delta to
+// the previous one, compressed, and the proxy restores it (see PayloadCodec.h)
+template <typename E>
+struct Coded : E {
+    static constexpr bool kCoded = true;
+};
+template <typename E>
+constexpr bool Coded<E>::kCoded;
+
+template <typename... Ms> struct MethodList {};
+template <typename... Es> struct EventList {};
+
+namespace detail {
+
+// Position of id in ids[0..n), or -1
+constexpr int FindId(const uint16_t* ids, size_t n, uint16_t id) {
+    for (size_t i = 0; i < n; ++i) {
+        if (ids[i] == id) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+constexpr bool UniqueIds(const uint16_t* ids, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i + 1; j < n; ++j) {
+            if (ids[i] == ids[j]) return false;
+        }
+    }
+    return true;
+}
+
+constexpr bool AnyTrue(const bool* v, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (v[i]) return true;
+    }
+    return false;
+}
+
+} // namespace detail
+
+// Compile-time description of a service interface, declared once and shared
+// by its skeleton and proxy:
+//
+//   using Calibrate = MethodDesc<0x42>;
+//   using RadarService = ServiceDesc<0x1234, 0x5678, MethodList<Calibrate>>;
+//
+// Methods and events are numbered by their position in the lists; bindings
+// use these indexes for flat handler tables instead of maps keyed by ID.
+template <ServiceId S, InstanceIdentifier I, typename Methods, typename Events = EventList<>>
+struct ServiceDesc;
+
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+struct ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>> {
+    static constexpr ServiceId kServiceId = S;
+    static constexpr InstanceIdentifier kInstanceId = I;
+    static constexpr size_t kNumMethods = sizeof...(Ms);
+    static constexpr size_t kNumEvents  = sizeof...(Es);
+
+    // IDs in declaration order (trailing 0 keeps the arrays non-empty)
+    static constexpr MethodId kMethodIds[] = {Ms::kId..., 0};
+    static constexpr EventId  kEventIds[]  = {Es::kId..., 0};
+    static constexpr uint16_t kEventGroups[] = {Es::kGroup..., 0};
+    static constexpr bool     kEventBatched[] = {Es::kBatched..., false};
+    static constexpr bool     kAnyBatched = detail::AnyTrue(kEventBatched, kNumEvents);
+    static constexpr bool     kEventCoded[] = {Es::kCoded..., false};
+
+    static_assert(detail::UniqueIds(kMethodIds, kNumMethods), "duplicate method ID in service description");
+    static_assert(detail::UniqueIds(kEventIds, kNumEvents), "duplicate event ID in service description");
+
+    // Table index of a method/event ID, -1 if the service does not declare it
+    static constexpr int MethodIndex(MethodId id) { return detail::FindId(kMethodIds, kNumMethods, id); }
+    static constexpr int EventIndex(EventId id) { return detail::FindId(kEventIds, kNumEvents, id); }
+
+    // Table index of a declared method/event type (compile error if not declared)
+    template <typename M>
+    static constexpr size_t IndexOfMethod() {
+        static_assert(MethodIndex(M::kId) >= 0, "method is not part of this service");
+        return static_cast<size_t>(MethodIndex(M::kId));
+    }
+    template <typename E>
+    static constexpr size_t IndexOfEvent() {
+        static_assert(EventIndex(E::kId) >= 0, "event is not part of this service");
+        return static_cast<size_t>(EventIndex(E::kId));
+    }
+};
+
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr ServiceId ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kServiceId;
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr InstanceIdentifier ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kInstanceId;
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr size_t ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kNumMethods;
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr size_t ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kNumEvents;
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr MethodId ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kMethodIds[];
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr EventId ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kEventIds[];
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr uint16_t ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kEventGroups[];
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr bool ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kEventBatched[];
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr bool ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kAnyBatched;
+template <ServiceId S, InstanceIdentifier I, typename... Ms, typename... Es>
+constexpr bool ServiceDesc<S, I, MethodList<Ms...>, EventList<Es...>>::kEventCoded[];
+
+} // namespace com
+} // namespace ara
@@ -0,0 +1,699 @@
+// ShmBinding.h - Shared memory transport for co-located skeleton and proxy processes
+#pragma once
+#include "AraCom_Skeleton.h"
+#include "ServiceInterface.h"
+#include "PendingRequests.h"
+#include "SomeipSerializer.h"
+#include "ShmRing.h"
+#include "Executor.h"
+#include "AraLog.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ara {
+namespace com {
+namespace shm {
+
+constexpr uint32_t kMagic   = 0x41524153; // "ARAS"
+constexpr uint32_t kVersion = 1;
+
+constexpr size_t kMaxClients    = 16;    // proxies attached to one service instance
+constexpr size_t kMsgBytes      = 4096;  // largest request/response payload
+constexpr size_t kRequestSlots  = 256;
+constexpr size_t kResponseSlots = 64;    // per client
+constexpr size_t kEventBytes    = 16384; // largest event payload
+constexpr size_t kEventSlots    = 256;
+
+constexpr std::chrono::microseconds kIdleWait{100000}; // liveness checks while idle
+constexpr std::chrono::microseconds kFullWait{1000};   // how long a publisher waits for a slow subscriber
+
+enum ClientState : uint32_t { kFree = 0, kClaiming = 1, kActive = 2 };
+
+// Per-proxy state in the segment
+struct ClientEntry {
+    std::atomic<uint32_t> state;          // ClientState
+    std::atomic<int32_t>  pid;
+    std::atomic<uint32_t> gen;            // bumped on every claim; stale responses are dropped
+    std::atomic<uint64_t> subscriptions;  // bit i = event index i
+    std::atomic<uint64_t> eventCursor;    // next event position this client reads
+    Doorbell bell;                        // rung for responses and subscribed events
+    MpscQueue<kResponseSlots, kMsgBytes> responses;
+};
+
+// Layout of the segment of one service instance
+struct Layout {
+    std::atomic<uint32_t> magic; // written last by the creator
+    uint32_t version;
+    uint16_t service;
+    uint16_t instance;
+    std::atomic<int32_t>  serverPid;
+    std::atomic<uint32_t> ready; // cleared when the skeleton stops offering
+    Doorbell serverBell;
+    MpscQueue<kRequestSlots, kMsgBytes> requests;
+    BroadcastRing<kEventSlots, kEventBytes> events;
+    ClientEntry clients[kMaxClients];
+};
+
+inline std::string SegmentName(ServiceId service, InstanceIdentifier instance) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "/aracom.%04x.%04x", unsigned(service), unsigned(instance));
+    return buf;
+}
+
+inline bool ProcessAlive(int32_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+// Polls before a consumer sleeps on its doorbell; on a single CPU spinning
+// only delays the producer it is waiting for
+inline int SpinBudget() {
+    static const int budget = std::thread::hardware_concurrency() > 1 ? 2000 : 0;
+    return budget;
+}
+
+// Spin briefly, then sleep on bell until it rings or the idle period passes
+template <typename F>
+void WaitForWork(Doorbell& bell, F&& hasWork) {
+    for (int i = 0; i < SpinBudget(); ++i) {
+        if (hasWork()) return;
+        CpuRelax();
+    }
+    const uint32_t armed = bell.Arm();
+    if (hasWork()) return;
+    bell.Wait(armed, kIdleWait);
+}
+
+} // namespace shm
+
+// Implementation of Skeleton over shared memory for clients on the same host.
+// Requests arrive in one lock-free queue, responses go to a queue per client and
+// events are written once into a ring that every subscriber reads from.
+template <typename Service>
+class ShmSkeleton : public Skeleton {
+    static_assert(Service::kNumEvents <= 64, "shared memory binding supports up to 64 events");
+
+public:
+    using Handler = std::function<void(const Message&)>;
+
+private:
+    std::string name_;
+    Handler handler_; // Callback for methods without a dedicated handler
+    std::array<Handler, Service::kNumMethods> method_handlers_; // Indexed by method position in Service
+
+    // Outstanding requests keyed by client/session; the value is the client generation
+    PendingTable<uint32_t> pending_;
+
+    std::shared_ptr<shm::Segment> seg_; // accessed with std::atomic_load/store
+    std::mutex publish_mu_; // SendEvent callers share the single producer side of the ring
+    std::atomic<bool> running_{false};
+    std::thread dispatcher_;
+    std::atomic<uint64_t> dropped_events_{0};
+
+    // Runs handlers per their MethodConcurrency; declared last so running
+    // handlers finish while everything they may touch still exists
+    MethodDispatcher<Service::kNumMethods> dispatch_;
+
+public:
+    ShmSkeleton(const std::string& name, Handler cb = nullptr,
+                std::chrono::milliseconds requestTimeout = std::chrono::seconds(5))
+        : name_(name), handler_(cb), pending_(requestTimeout) {}
+
+    ~ShmSkeleton() override { StopOfferService(); }
+
+    // Dedicated handler for method M (M must be a method of Service)
+    template <typename M>
+    void SetMethodHandler(Handler cb) {
+        method_handlers_[Service::template IndexOfMethod<M>()] = std::move(cb);
+    }
+
+    void SetConcurrency(MethodId method, MethodConcurrency c) override {
+        const int idx = Service::MethodIndex(method);
+        if (idx < 0) {
+            ARA_LOG_ERROR("[Server] Method 0x{:x} is not declared by the service", method);
+            return;
+        }
+        dispatch_.Configure(idx, c);
+    }
+
+    template <typename M>
+    void SetConcurrency(MethodConcurrency c) {
+        dispatch_.Configure(Service::template IndexOfMethod<M>(), c);
+    }
+
+    // Run non-inline handlers on exec instead of Executor::Shared() (call before SetConcurrency)
+    void SetExecutor(std::shared_ptr<Executor> exec) { dispatch_.SetExecutor(std::move(exec)); }
+
+    // Requests of method M rejected because its queue was full
+    template <typename M>
+    uint64_t RejectedRequests() const { return dispatch_.Rejected(Service::template IndexOfMethod<M>()); }
+
+    // Create the service segment and start dispatching requests
+    void OfferService() override {
+        if (running_) return;
+        auto seg = shm::Segment::Create(shm::SegmentName(Service::kServiceId, Service::kInstanceId),
+                                        sizeof(shm::Layout));
+        if (!seg) return;
+        auto* lay = new (seg->Data()) shm::Layout;
+        lay->version = shm::kVersion;
+        lay->service = Service::kServiceId;
+        lay->instance = Service::kInstanceId;
+        lay->serverPid.store(getpid());
+        lay->serverBell.Init();
+        lay->requests.Init();
+        lay->events.Init();
+        for (auto& c : lay->clients) c.state.store(shm::kFree);
+        lay->ready.store(1);
+        lay->magic.store(shm::kMagic, std::memory_order_release);
+        std::atomic_store(&seg_, seg);
+
+        running_ = true;
+        dispatcher_ = std::thread([this, seg] { DispatchLoop(Lay(seg)); });
+        ARA_LOG_INFO("[{}] Offering service 0x{:x} in {}", name_, Service::kServiceId, seg->Name());
+    }
+
+    // Stop offering: attached proxies see ready == 0 and detach
+    void StopOfferService() override {
+        if (!running_.exchange(false)) return;
+        auto seg = std::atomic_load(&seg_);
+        shm::Layout* lay = Lay(seg);
+        lay->ready.store(0);
+        lay->serverBell.Ring();
+        if (dispatcher_.joinable()) dispatcher_.join();
+        for (auto& c : lay->clients) c.bell.Ring();
+        std::atomic_store(&seg_, std::shared_ptr<shm::Segment>());
+    }
+
+    // Queue the response for the client that sent request msg.request
+    void SendResponse(Message msg) override {
+        uint32_t gen;
+        if (!pending_.Take(msg.request, gen)) {
+            ARA_LOG_WARN("[Server] No pending request 0x{:x} for method 0x{:x} (answered or timed out)",
+                         msg.request, msg.method);
+            return;
+        }
+        if (msg.payload.size() > shm::kMsgBytes) {
+            ARA_LOG_ERROR("[Server] Response of {} bytes exceeds the {} byte slot", msg.payload.size(),
+                          shm::kMsgBytes);
+            Reply(msg.request, gen, msg.method, 1, nullptr, 0);
+            return;
+        }
+        Reply(msg.request, gen, msg.method, 0, msg.payload.data(), msg.payload.size());
+    }
+
+    // Number of requests still waiting for SendResponse
+    size_t PendingRequests() const { return pending_.Size(); }
+
+    // Write the event once into the shared ring. If the slowest subscriber stays
+    // a full ring behind for kFullWait, the notification is dropped rather than
+    // blocking the publisher any longer.
+    void SendEvent(EventId event, Payload data) override {
+        const int idx = Service::EventIndex(event);
+        if (idx < 0) {
+            ARA_LOG_ERROR("[Server] Event 0x{:x} is not declared by the service", event);
+            return;
+        }
+        Publish(static_cast<size_t>(idx), data.size(), [&](uint8_t* dst) {
+            std::memcpy(dst, data.data(), data.size());
+        });
+    }
+
+    // Typed variant: the value is serialized straight into the ring slot
+    template <typename E>
+    void SendEvent(const typename E::Type& value) {
+        const size_t idx = Service::template IndexOfEvent<E>();
+        Publish(idx, ser::WireSize(value), [&](uint8_t* dst) {
+            ser::Writer w(dst);
+            ser::Codec<typename E::Type>::Write(w, value);
+        });
+    }
+
+    // Typed response to the request identified by token (M must be a method of Service)
+    template <typename M>
+    void SendResponse(RequestToken request, const typename M::Response& value) {
+        Service::template IndexOfMethod<M>();
+        SendResponse(Message{M::kId, ser::Encode(value), request});
+    }
+
+    // Notifications dropped because a subscriber fell a full ring behind
+    uint64_t DroppedEvents() const { return dropped_events_.load(std::memory_order_relaxed); }
+
+private:
+    static shm::Layout* Lay(const std::shared_ptr<shm::Segment>& seg) {
+        return static_cast<shm::Layout*>(seg->Data());
+    }
+
+    void Reply(RequestToken token, uint32_t gen, MethodId method, uint8_t status,
+               const uint8_t* data, size_t size) {
+        const auto seg = std::atomic_load(&seg_);
+        if (!seg) return;
+        shm::ClientEntry& c = Lay(seg)->clients[(token >> 16) % shm::kMaxClients];
+        if (c.state.load() != shm::kActive || c.gen.load() != gen) return; // requester went away
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+        while (!c.responses.TryPush([&](shm::Slot<shm::kMsgBytes>& s) {
+                   s.size = static_cast<uint32_t>(size);
+                   s.client = static_cast<uint16_t>(token >> 16);
+                   s.session = static_cast<uint16_t>(token);
+                   s.id = method;
+                   s.status = status;
+                   s.gen = static_cast<uint8_t>(gen);
+                   if (size) std::memcpy(s.data, data, size);
+               })) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                ARA_LOG_WARN("[Server] Response queue of client {} is full, dropping response 0x{:x}",
+                             token >> 16, token);
+                return;
+            }
+            std::this_thread::yield();
+        }
+        c.bell.Ring();
+    }
+
+    template <typename F>
+    void Publish(size_t idx, size_t size, F&& write) {
+        if (size > shm::kEventBytes) {
+            ARA_LOG_ERROR("[Server] Event 0x{:x} of {} bytes exceeds the {} byte slot", Service::kEventIds[idx],
+                          size, shm::kEventBytes);
+            return;
+        }
+        const auto seg = std::atomic_load(&seg_);
+        if (!seg) return;
+        shm::Layout* lay = Lay(seg);
+        std::lock_guard<std::mutex> lk(publish_mu_);
+        auto& ring = lay->events;
+        const uint64_t head = ring.Head();
+        if (head - SlowestCursor(lay, head) >= shm::kEventSlots) {
+            const auto deadline = std::chrono::steady_clock::now() + shm::kFullWait;
+            do {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    dropped_events_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+            } while (head - SlowestCursor(lay, head) >= shm::kEventSlots);
+        }
+        ring.Publish([&](shm::Slot<shm::kEventBytes>& s) {
+            s.size = static_cast<uint32_t>(size);
+            s.id = Service::kEventIds[idx];
+            write(s.data);
+        });
+        const uint64_t bit = uint64_t(1) << idx;
+        for (auto& c : lay->clients) {
+            if (c.state.load() == shm::kActive && (c.subscriptions.load() & bit)) c.bell.Ring();
+        }
+    }
+
+    // Lowest read cursor of the subscribed clients (head if there are none)
+    static uint64_t SlowestCursor(const shm::Layout* lay, uint64_t head) {
+        uint64_t slowest = head;
+        for (auto& c : lay->clients) {
+            if (c.state.load() != shm::kActive || c.subscriptions.load() == 0) continue;
+            const uint64_t cur = c.eventCursor.load(std::memory_order_acquire);
+            if (cur < slowest) slowest = cur;
+        }
+        return slowest;
+    }
+
+    void DispatchLoop(shm::Layout* lay) {
+        auto& q = lay->requests;
+        auto lastSweep = std::chrono::steady_clock::now();
+        while (running_) {
+            bool any = false;
+            while (q.TryPop([this](shm::Slot<shm::kMsgBytes>& s) { OnRequest(s); })) any = true;
+            if (!any) shm::WaitForWork(lay->serverBell, [&] { return !q.Empty() || !running_; });
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastSweep >= shm::kIdleWait) {
+                lastSweep = now;
+                pending_.MaybeEvict();
+                ReleaseDeadClients(lay);
+            }
+        }
+    }
+
+    // Free the entries of proxies whose process exited without detaching
+    static void ReleaseDeadClients(shm::Layout* lay) {
+        for (size_t i = 0; i < shm::kMaxClients; ++i) {
+            auto& c = lay->clients[i];
+            if (c.state.load() == shm::kActive && !shm::ProcessAlive(c.pid.load())) {
+                c.subscriptions.store(0);
+                c.state.store(shm::kFree);
+                ARA_LOG_WARN("[Server] Client {} (pid {}) is gone, releasing its slot", i, c.pid.load());
+            }
+        }
+    }
+
+    void OnRequest(const shm::Slot<shm::kMsgBytes>& s) {
+        const int idx = Service::MethodIndex(s.id);
+        if (idx < 0 || s.size > shm::kMsgBytes) return;
+        const RequestToken token = MakeRequestToken(s.client, s.session);
+        pending_.Insert(token, s.gen);
+
+        // The slot is reused as soon as this returns: the handler gets its own copy
+        Message m;
+        m.method = s.id;
+        m.request = token;
+        m.payload = Payload(std::vector<uint8_t>(s.data, s.data + s.size));
+        const Handler* h = method_handlers_[idx] ? &method_handlers_[idx] : &handler_;
+        if (!*h) return;
+        if (!dispatch_.Dispatch(idx, [h, m = std::move(m)]() { (*h)(m); })) {
+            // Method queue full: fail the call right away so the caller backs off
+            uint32_t gen;
+            if (pending_.Take(token, gen)) Reply(token, gen, s.id, 1, nullptr, 0);
+        }
+    }
+};
+
+// Implementation of Proxy over shared memory. Attaches to the segment of the
+// instance (retrying until the skeleton offers it) and serves responses and
+// events from one receive thread.
+//
+// Events are delivered as borrowed views of their ring slot (Payload::Borrowed):
+// the cursor moves past a slot only after the callback returns, so reading the
+// event in place is zero-copy, and a copy of the view that is kept (an
+// EventQueue, an EventStream, the application) takes its own bytes.
+template <typename Service>
+class ShmProxy : public Proxy {
+    static_assert(Service::kNumEvents <= 64, "shared memory binding supports up to 64 events");
+
+    std::string name_;
+    InstanceIdentifier instance_{Service::kInstanceId};
+    // Callback per event position. A table is immutable once published:
+    // SubscribeEvent stores a changed copy with one atomic store, so the
+    // receive thread reads it without a lock. Replaced tables are kept until
+    // the proxy goes away, since the receive thread may still use one.
+    using EventTable = std::array<std::function<void(const Payload&)>, Service::kNumEvents>;
+    std::atomic<const EventTable*> events_{nullptr};
+    std::mutex events_mu_; // serializes writers only
+    std::vector<std::unique_ptr<const EventTable>> tables_;
+    // Callbacks indexed by method position in Service
+    std::array<std::function<void(const Payload&)>, Service::kNumMethods> response_callbacks_;
+    std::atomic<uint64_t> subscribed_{0}; // events with a callback installed
+
+    CallTracker calls_;
+    std::atomic<uint16_t> session_{0};
+
+    // Attachment, owned by the receive thread; attached_ publishes it to callers
+    std::shared_ptr<shm::Segment> seg_;
+    shm::Layout* lay_{nullptr};
+    size_t client_{0};
+    uint32_t gen_{0};
+    std::atomic<bool> attached_{false};
+    std::mutex attach_mu_; // keeps the mapping alive while a caller writes a request
+
+    std::atomic<bool> running_{false};
+    std::thread receiver_;
+
+public:
+    ShmProxy(const std::string& name) : name_(name) {
+        tables_.emplace_back(new EventTable);
+        events_.store(tables_.back().get());
+    }
+
+    ~ShmProxy() override { StopFindService(instance_); }
+
+    // Start looking for the instance; requests fail until it is found
+    void FindService(InstanceIdentifier instance) override {
+        if (running_.exchange(true)) return;
+        instance_ = instance;
+        receiver_ = std::thread([this] { ReceiveLoop(); });
+    }
+
+    void StopFindService(InstanceIdentifier) override {
+        if (!running_.exchange(false)) return;
+        {
+            std::lock_guard<std::mutex> lk(attach_mu_);
+            if (lay_) lay_->clients[client_].bell.Ring();
+        }
+        if (receiver_.joinable()) receiver_.join();
+    }
+
+    // Attachment is polled: the receive thread attaches once the skeleton's segment exists
+    bool WaitAvailable(std::chrono::milliseconds timeout) override {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!attached_.load(std::memory_order_acquire)) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    // Fire-and-forget call; the response goes to the registered response handler
+    void MethodCall(MethodId method, Payload req) override {
+        if (Service::MethodIndex(method) < 0) {
+            ARA_LOG_ERROR("[Client] Method 0x{:x} is not declared by the service", method);
+            return;
+        }
+        if (!FitsSlot(req)) return;
+        std::lock_guard<std::mutex> lk(attach_mu_);
+        if (!attached_.load(std::memory_order_acquire) || !PushLocked(method, NextSession(), req)) {
+            ARA_LOG_WARN("[Client] Cannot send method 0x{:x}: service not available or request queue full", method);
+        }
+    }
+
+    // Asynchronous call matched by session; fails with CallStatus::kTimeout
+    // if nothing arrives within timeout
+    CallHandle MethodCall(MethodId method, Payload req, std::chrono::milliseconds timeout) override {
+        auto st = std::make_shared<CallState>();
+        if (Service::MethodIndex(method) < 0) {
+            st->Fail(CallStatus::kError, "method is not declared by the service");
+            return CallHandle(std::move(st), 0);
+        }
+        if (!FitsSlot(req)) {
+            st->Fail(CallStatus::kError, "request exceeds the shared memory slot");
+            return CallHandle(std::move(st), 0);
+        }
+        std::lock_guard<std::mutex> lk(attach_mu_);
+        if (!attached_.load(std::memory_order_acquire)) {
+            st->Fail(CallStatus::kUnavailable, "service not available");
+            return CallHandle(std::move(st), 0);
+        }
+        // The session is chosen here, so the call is tracked before the request is visible
+        const uint16_t session = NextSession();
+        const RequestToken token = MakeRequestToken(static_cast<uint16_t>(client_), session);
+        CallHandle h = calls_.Track(token, st, std::chrono::steady_clock::now() + timeout);
+        if (!PushLocked(method, session, req)) {
+            std::shared_ptr<CallState> taken;
+            if (calls_.Take(token, taken)) taken->Fail(CallStatus::kError, "request queue full");
+        }
+        return h;
+    }
+
+    // Typed variants: M must be a method of Service
+    template <typename M>
+    void MethodCall(const typename M::Request& req) {
+        Service::template IndexOfMethod<M>();
+        MethodCall(M::kId, ser::Encode(req));
+    }
+
+    template <typename M>
+    CallHandle MethodCall(const typename M::Request& req, std::chrono::milliseconds timeout) {
+        Service::template IndexOfMethod<M>();
+        return MethodCall(M::kId, ser::Encode(req), timeout);
+    }
+
+    // Number of asynchronous calls still waiting for a response
+    size_t PendingCalls() const { return calls_.Size(); }
+
+    // Subscribe to an event; the callback runs on the receive thread
+    void SubscribeEvent(EventId event, std::function<void(const Payload&)> cb) override {
+        const int idx = Service::EventIndex(event);
+        if (idx < 0) {
+            ARA_LOG_ERROR("[Client] Event 0x{:x} is not declared by the service", event);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(events_mu_);
+            std::unique_ptr<EventTable> t(new EventTable(*events_.load()));
+            (*t)[idx] = std::move(cb);
+            events_.store(t.get(), std::memory_order_release);
+            tables_.emplace_back(std::move(t));
+        }
+        subscribed_.fetch_or(uint64_t(1) << idx, std::memory_order_release);
+        std::lock_guard<std::mutex> lk(attach_mu_);
+        if (lay_) lay_->clients[client_].bell.Ring(); // let the receiver publish the new mask
+    }
+
+    // Typed variant: every notification is decoded in place into one object
+    // owned by the subscription
+    template <typename E>
+    void SubscribeEvent(std::function<void(const typename E::Type&)> cb) {
+        Service::template IndexOfEvent<E>();
+        auto value = std::make_shared<typename E::Type>();
+        SubscribeEvent(E::kId, [cb, value](const Payload& data) {
+            if (!ser::Decode(data, *value)) {
+                ARA_LOG_WARN("[Client] Malformed payload for event 0x{:x}", E::kId);
+                return;
+            }
+            cb(*value);
+        });
+    }
+
+    // Register a callback to handle responses for a specific method
+    void RegisterResponseHandler(MethodId method, std::function<void(const Payload&)> cb) override {
+        const int idx = Service::MethodIndex(method);
+        if (idx >= 0) response_callbacks_[idx] = cb;
+    }
+
+private:
+    uint16_t NextSession() {
+        uint16_t s = session_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (s == 0) s = session_.fetch_add(1, std::memory_order_relaxed) + 1; // 0 is never used
+        return s;
+    }
+
+    static bool FitsSlot(const Payload& req) {
+        if (req.size() <= shm::kMsgBytes) return true;
+        ARA_LOG_ERROR("[Client] Request of {} bytes exceeds the {} byte slot", req.size(), shm::kMsgBytes);
+        return false;
+    }
+
+    // Write one request into the service queue; attach_mu_ must be held
+    bool PushLocked(MethodId method, uint16_t session, const Payload& req) {
+        const bool ok = lay_->requests.TryPush([&](shm::Slot<shm::kMsgBytes>& s) {
+            s.size = static_cast<uint32_t>(req.size());
+            s.client = static_cast<uint16_t>(client_);
+            s.session = session;
+            s.id = method;
+            s.status = 0;
+            s.gen = static_cast<uint8_t>(gen_);
+            if (!req.empty()) std::memcpy(s.data, req.data(), req.size());
+        });
+        if (ok) lay_->serverBell.Ring();
+        return ok;
+    }
+
+    // Map the segment and claim a client entry; false if the service is not offered
+    bool Attach() {
+        auto seg = shm::Segment::Open(shm::SegmentName(Service::kServiceId, instance_), sizeof(shm::Layout));
+        if (!seg) return false;
+        auto* lay = static_cast<shm::Layout*>(seg->Data());
+        if (lay->magic.load(std::memory_order_acquire) != shm::kMagic || lay->version != shm::kVersion ||
+            lay->ready.load() == 0 || !shm::ProcessAlive(lay->serverPid.load())) {
+            return false;
+        }
+        for (size_t i = 0; i < shm::kMaxClients; ++i) {
+            auto& c = lay->clients[i];
+            uint32_t expected = shm::kFree;
+            if (!c.state.compare_exchange_strong(expected, shm::kClaiming)) continue;
+            c.pid.store(getpid());
+            c.subscriptions.store(0);
+            c.eventCursor.store(lay->events.Head());
+            c.bell.Init();
+            c.responses.Init();
+            const uint32_t gen = (c.gen.load() + 1) & 0xff;
+            c.gen.store(gen);
+            c.state.store(shm::kActive);
+            {
+                std::lock_guard<std::mutex> lk(attach_mu_);
+                seg_ = std::move(seg);
+                lay_ = lay;
+                client_ = i;
+                gen_ = gen;
+                attached_.store(true, std::memory_order_release);
+            }
+            ARA_LOG_INFO("[{}] Attached to {} as client {}", name_, seg_->Name(), i);
+            return true;
+        }
+        ARA_LOG_ERROR("[Client] No free client slot in {}", seg->Name());
+        return false;
+    }
+
+    void Detach() {
+        std::lock_guard<std::mutex> lk(attach_mu_);
+        if (!lay_) return;
+        auto& c = lay_->clients[client_];
+        c.subscriptions.store(0);
+        c.state.store(shm::kFree);
+        attached_.store(false, std::memory_order_release);
+        lay_ = nullptr;
+        seg_.reset();
+    }
+
+    void ReceiveLoop() {
+        uint64_t published = 0; // subscription mask visible to the skeleton
+        auto lastCheck = std::chrono::steady_clock::now();
+        while (running_) {
+            if (!lay_) {
+                if (!Attach()) {
+                    std::this_thread::sleep_for(shm::kIdleWait);
+                    continue;
+                }
+                published = 0;
+            }
+            auto& c = lay_->clients[client_];
+
+            const uint64_t wanted = subscribed_.load(std::memory_order_acquire);
+            if (wanted != published) {
+                if (published == 0) c.eventCursor.store(lay_->events.Head(), std::memory_order_release);
+                c.subscriptions.store(wanted);
+                published = wanted;
+            }
+
+            bool any = false;
+            while (c.responses.TryPop([this](shm::Slot<shm::kMsgBytes>& s) { OnResponse(s); })) any = true;
+            if (published != 0) any |= DrainEvents(c, published);
+            if (any) continue;
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastCheck >= shm::kIdleWait) {
+                lastCheck = now;
+                if (lay_->ready.load() == 0 || !shm::ProcessAlive(lay_->serverPid.load())) {
+                    ARA_LOG_WARN("[Client] Service 0x{:x} went away, detaching", Service::kServiceId);
+                    Detach();
+                    continue;
+                }
+            }
+            const uint64_t mask = published;
+            shm::WaitForWork(c.bell, [&] {
+                return !c.responses.Empty() || (mask != 0 && lay_->events.Peek(c.eventCursor.load()) != nullptr) ||
+                       subscribed_.load(std::memory_order_relaxed) != mask || !running_;
+            });
+        }
+        Detach();
+    }
+
+    // Lend every published event to its callback, then advance the cursor past it
+    bool DrainEvents(shm::ClientEntry& c, uint64_t mask) {
+        uint64_t cur = c.eventCursor.load(std::memory_order_relaxed);
+        bool any = false;
+        while (const auto* s = lay_->events.Peek(cur)) {
+            const int idx = Service::EventIndex(s->id);
+            if (idx >= 0 && (mask & (uint64_t(1) << idx))) {
+                (*events_.load(std::memory_order_acquire))[idx](Payload::Borrowed(s->data, s->size));
+            }
+            c.eventCursor.store(++cur, std::memory_order_release);
+            any = true;
+        }
+        return any;
+    }
+
+    void OnResponse(const shm::Slot<shm::kMsgBytes>& s) {
+        if (s.gen != static_cast<uint8_t>(gen_)) return; // meant for a previous owner of this entry
+        const RequestToken token = MakeRequestToken(s.client, s.session);
+        std::shared_ptr<CallState> st;
+        if (calls_.Take(token, st)) {
+            if (s.status != 0) {
+                st->Fail(CallStatus::kError, "method call failed on the server");
+                return;
+            }
+            st->Complete(Message{s.id, Payload(std::vector<uint8_t>(s.data, s.data + s.size)), token});
+            return;
+        }
+        const int idx = Service::MethodIndex(s.id);
+        if (idx >= 0 && response_callbacks_[idx] && s.status == 0) {
+            response_callbacks_[idx](Payload(std::vector<uint8_t>(s.data, s.data + s.size)));
+        }
+    }
+};
+
+} // namespace com
+} // namespace ara
@@ -0,0 +1,246 @@
+// ShmRing.h - Lock-free queues and wakeups placed in POSIX shared memory
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace ara {
+namespace com {
+namespace shm {
+
+// Everything below is shared between processes: atomics must not fall back to locks
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "shared memory rings need address-free lock-free atomics");
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Futex on a word of a shared mapping (no FUTEX_PRIVATE_FLAG: waiters live in other processes)
+inline void FutexWait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::microseconds timeout) {
+    timespec ts;
+    ts.tv_sec  = static_cast<time_t>(timeout.count() / 1000000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000000) * 1000;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+inline void FutexWakeAll(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Wakeup channel of one consumer. The consumer takes Arm() before its last
+// check for work and then Wait()s; producers Ring() after publishing. The
+// futex syscall is skipped while nobody sleeps.
+struct Doorbell {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> sleepers;
+
+    void Init() {
+        seq.store(0);
+        sleepers.store(0);
+    }
+
+    uint32_t Arm() const { return seq.load(); }
+
+    void Ring() {
+        seq.fetch_add(1);
+        if (sleepers.load() != 0) FutexWakeAll(seq);
+    }
+
+    void Wait(uint32_t armed, std::chrono::microseconds timeout) {
+        sleepers.fetch_add(1);
+        if (seq.load() == armed) FutexWait(seq, armed, timeout);
+        sleepers.fetch_sub(1);
+    }
+};
+
+// Fixed-size message slot: routing header plus inline payload bytes
+template <size_t Bytes>
+struct Slot {
+    std::atomic<uint64_t> seq; // publication state, see the queues below
+    uint32_t size;             // payload bytes in data
+    uint16_t client;           // client table index of the requester
+    uint16_t session;          // session chosen by the requester
+    uint16_t id;               // method or event ID
+    uint8_t  status;           // 0 = ok; non-zero marks a failed call
+    uint8_t  gen;              // generation of the client table entry
+    uint8_t  data[Bytes];
+};
+
+// Bounded multi-producer / single-consumer queue (Vyukov): producers claim a
+// position with one CAS and publish it through the slot sequence, so neither
+// side ever blocks on the other
+template <size_t N, size_t Bytes>
+struct MpscQueue {
+    static_assert((N & (N - 1)) == 0, "queue length must be a power of two");
+    using SlotT = Slot<Bytes>;
+
+    alignas(64) std::atomic<uint64_t> enq;
+    alignas(64) std::atomic<uint64_t> deq;
+    alignas(64) SlotT slots[N];
+
+    void Init() {
+        for (size_t i = 0; i < N; ++i) slots[i].seq.store(i, std::memory_order_relaxed);
+        enq.store(0, std::memory_order_relaxed);
+        deq.store(0, std::memory_order_release);
+    }
+
+    // Claim a slot, let fill(SlotT&) write it and publish it; false if full
+    template <typename F>
+    bool TryPush(F&& fill) {
+        uint64_t pos = enq.load(std::memory_order_relaxed);
+        for (;;) {
+            SlotT& s = slots[pos & (N - 1)];
+            const int64_t dif = static_cast<int64_t>(s.seq.load(std::memory_order_acquire) - pos);
+            if (dif == 0) {
+                if (enq.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    fill(s);
+                    s.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = enq.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer only: hand the oldest slot to consume(SlotT&) and free it; false if empty
+    template <typename F>
+    bool TryPop(F&& consume) {
+        const uint64_t pos = deq.load(std::memory_order_relaxed);
+        SlotT& s = slots[pos & (N - 1)];
+        if (s.seq.load(std::memory_order_acquire) != pos + 1) return false;
+        consume(s);
+        s.seq.store(pos + N, std::memory_order_release);
+        deq.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool Empty() const {
+        const uint64_t pos = deq.load(std::memory_order_relaxed);
+        return slots[pos & (N - 1)].seq.load(std::memory_order_acquire) != pos + 1;
+    }
+};
+
+// Single-producer ring read by any number of consumers, each with its own
+// cursor. Readers get the bytes in place; the producer must not publish while
+// head - (slowest registered cursor) == N, so a slot being read is never reused.
+template <size_t N, size_t Bytes>
+struct BroadcastRing {
+    static_assert((N & (N - 1)) == 0, "ring length must be a power of two");
+    using SlotT = Slot<Bytes>;
+
+    alignas(64) std::atomic<uint64_t> head; // next position to publish
+    alignas(64) SlotT slots[N];
+
+    void Init() {
+        for (size_t i = 0; i < N; ++i) slots[i].seq.store(UINT64_MAX, std::memory_order_relaxed);
+        head.store(0, std::memory_order_release);
+    }
+
+    uint64_t Head() const { return head.load(std::memory_order_acquire); }
+
+    // Producer only: fill(SlotT&) the next slot and publish it
+    template <typename F>
+    void Publish(F&& fill) {
+        const uint64_t pos = head.load(std::memory_order_relaxed);
+        SlotT& s = slots[pos & (N - 1)];
+        fill(s);
+        s.seq.store(pos, std::memory_order_release);
+        head.store(pos + 1, std::memory_order_release);
+    }
+
+    // Slot published at position cursor, or null if not there (yet)
+    const SlotT* Peek(uint64_t cursor) const {
+        if (cursor >= head.load(std::memory_order_acquire)) return nullptr;
+        const SlotT& s = slots[cursor & (N - 1)];
+        return s.seq.load(std::memory_order_acquire) == cursor ? &s : nullptr;
+    }
+};
+
+// A POSIX shared memory object mapped into this process. The creator unlinks
+// the name again when the mapping goes away.
+class Segment {
+    void* addr_{nullptr};
+    size_t size_{0};
+    std::string name_;
+    bool owner_{false};
+
+    Segment(void* addr, size_t size, const std::string& name, bool owner)
+        : addr_(addr), size_(size), name_(name), owner_(owner) {}
+
+public:
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    ~Segment() {
+        if (addr_) munmap(addr_, size_);
+        if (owner_) shm_unlink(name_.c_str());
+    }
+
+    // Create a zero-filled object of size bytes, replacing a stale one left by a
+    // crashed owner; null on failure
+    static std::shared_ptr<Segment> Create(const std::string& name, size_t size) {
+        shm_unlink(name.c_str());
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+        if (fd < 0) {
+            std::cerr << "[Shm] Cannot create " << name << ": " << std::strerror(errno) << std::endl;
+            return nullptr;
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            std::cerr << "[Shm] Cannot size " << name << ": " << std::strerror(errno) << std::endl;
+            close(fd);
+            shm_unlink(name.c_str());
+            return nullptr;
+        }
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            std::cerr << "[Shm] Cannot map " << name << ": " << std::strerror(errno) << std::endl;
+            shm_unlink(name.c_str());
+            return nullptr;
+        }
+        return std::shared_ptr<Segment>(new Segment(addr, size, name, true));
+    }
+
+    // Map an existing object of at least size bytes; null if it does not exist (yet)
+    static std::shared_ptr<Segment> Open(const std::string& name, size_t size) {
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < size) {
+            close(fd);
+            return nullptr;
+        }
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) return nullptr;
+        return std::shared_ptr<Segment>(new Segment(addr, size, name, false));
+    }
+
+    void* Data() const { return addr_; }
+    size_t Size() const { return size_; }
+    const std::string& Name() const { return name_; }
+};
+
+} // namespace shm
+} // namespace com
+} // namespace ara
@@ -1,121 +1,721 @@
 // SomeipBinding.h
 #pragma once
 #include "AraCom_Skeleton.h"
+#include "ServiceInterface.h"
+#include "PendingRequests.h"
+#include "PayloadPool.h"
+#include "SomeipSerializer.h"
+#include "EventBatcher.h"
+#include "EventShaper.h"
+#include "PayloadCodec.h"
+#include "EventQueue.h"
+#include "ResponseCache.h"
+#include "SomeipTp.h"
+#include "Executor.h"
+#include "Metrics.h"
+#include "AraLog.h"
 #include <vsomeip/vsomeip.hpp>
 #include <memory>
+#include <array>
+#include <set>
 #include <map>
+#include <deque>
+#include <chrono>
 #include <thread>
-#include <iostream>
-
-#define RADAR_SERVICE_ID    0x1234 // Service ID for Radar
-#define RADAR_INSTANCE_ID   0x5678 // Instance ID for Radar
-#define CALIBRATE_METHOD_ID 0x42   // Method ID for Calibrate
+#include <mutex>
 
 namespace ara {
 namespace com {
 
-// Implementation of Skeleton using SOME/IP protocol
+// Tag marking Payload views that wrap a whole vsomeip::payload
+inline const void* SomeipPayloadKind() {
+    static const char tag = 0;
+    return &tag;
+}
+
+// Wrap a received vsomeip payload without copying its bytes
+inline Payload FromSomeip(const std::shared_ptr<vsomeip::payload>& pl) {
+    return Payload(pl, pl->get_data(), pl->get_length(), SomeipPayloadKind());
+}
+
+// Convert to a vsomeip payload for sending: a wrapped vsomeip payload is reused
+// as is, an exclusively owned vector is moved in, anything else is copied once
+inline std::shared_ptr<vsomeip::payload> ToSomeip(Payload&& p) {
+    if (auto pl = p.Owner<vsomeip::payload>(SomeipPayloadKind())) return pl;
+    auto pl = vsomeip::runtime::get()->create_payload();
+    pl->set_data(p.Release());
+    return pl;
+}
+
+// Binding-internal method (never declared by a ServiceDesc): a proxy sends
+// the EventPolicy of one of its subscriptions as a fire-and-forget request
+constexpr vsomeip::method_t kEventPolicyMethod = 0x7FFE;
+
+// Binding-internal IDs of traffic routed by size (see SomeipTp.h): SOME/IP-TP
+// segments of requests and responses, segments of event notifications, and
+// notifications too large to segment, sent whole over TCP
+constexpr vsomeip::method_t kTpMethod = 0x7FFD;
+constexpr vsomeip::event_t kTpEvent = 0xFFFD;
+constexpr vsomeip::event_t kTcpEvent = 0xFFFC;
+
+struct EventPolicyRequest {
+    uint16_t event{0};
+    uint32_t minIntervalUs{0};
+    uint32_t everyNth{1};
+    bool latestOnly{false};
+    SOMEIP_FIELDS(event, minIntervalUs, everyNth, latestOnly)
+};
+
+// Implementation of Skeleton using SOME/IP protocol for the service described by Service
+// (a ServiceDesc, see ServiceInterface.h)
+template <typename Service>
 class SomeipSkeleton : public Skeleton {
+public:
+    using Handler = std::function<void(const Message&)>;
+
+private:
     std::shared_ptr<vsomeip::application> app_; // SOME/IP application instance
-    std::function<void(const Message&)> handler_; // Callback to handle incoming messages
+    Handler handler_; // Callback for methods without a dedicated handler
+    std::array<Handler, Service::kNumMethods> method_handlers_; // Indexed by method position in Service
+
+    // Outstanding requests keyed by client/session, kept until answered or timed out
+    struct InFlight {
+        std::shared_ptr<vsomeip::message> req;
+        std::chrono::steady_clock::time_point received; // start of the response latency
+        size_t method{0};      // index in Service (req may be the last segment of a TP request)
+        bool cacheable{false}; // idempotent method: store the response under cacheHash
+        uint64_t cacheHash{0};
+        uint64_t cacheGen{0};  // cache generation the request was received in
+        Payload request;       // kept for the response cache only
+    };
+    PendingTable<InFlight> pending_;
+
+    // Response caches of idempotent methods (null for the others)
+    std::array<std::unique_ptr<ResponseCache>, Service::kNumMethods> caches_;
+
+    // UDP/TCP thresholds; segments of large requests are put back together in
+    // reassembler_ (allocated by OfferService)
+    SomeipTransportConfig transport_;
+    TpSegmenter segmenter_;
+    std::unique_ptr<TpReassembler> reassembler_;
+
+    // Per-method/per-event histograms; declared before dispatch_ so handlers still
+    // running during destruction can record into it
+    BindingMetrics<Service::kNumMethods, Service::kNumEvents> metrics_;
+
+    // Encoders of Coded<> events (null for other events); the lock keeps
+    // frames leaving in the order they were encoded. enc codes the stream every
+    // subscriber without a policy gets; a subscriber with a policy skips frames
+    // of that stream, so it gets its own delta stream in shaped.
+    struct EventEncoder {
+        std::mutex mu;
+        FrameEncoder enc;
+        CodecConfig cfg;
+        std::map<EventShaper::ClientId, FrameEncoder> shaped;
+    };
+    std::array<std::unique_ptr<EventEncoder>, Service::kNumEvents> encoders_;
 
-    // Store the original request to create a correct response context
-    std::map<MethodId, std::shared_ptr<vsomeip::message>> last_requests_;
+    // Per-subscriber event policies (slot = event index); declared before
+    // batcher_ so batches flushed during destruction can still be shaped
+    EventShaper shaper_;
+
+    // Frames notifications of Batched<> events (slot = event index); declared
+    // after app_ so remaining batches are flushed while it is still alive
+    std::unique_ptr<EventBatcher> batcher_;
+
+    // Runs handlers per their MethodConcurrency; declared last so running
+    // handlers finish while everything they may touch still exists
+    MethodDispatcher<Service::kNumMethods> dispatch_;
 
 public:
-    // Constructor: create SOME/IP application and set message handler callback
-    SomeipSkeleton(const std::string& name, std::function<void(const Message&)> cb)
-        : handler_(cb) {
+    // Constructor: create SOME/IP application and set message handler callback.
+    // Requests not answered within requestTimeout are dropped from the pending table.
+    SomeipSkeleton(const std::string& name, Handler cb = nullptr,
+                   std::chrono::milliseconds requestTimeout = std::chrono::seconds(5))
+        : handler_(cb), pending_(requestTimeout),
+          shaper_(Service::kNumEvents, [this](size_t slot, const EventShaper::ClientId* clients, size_t n,
+                                              bool shaped, const uint8_t* data, size_t size) {
+              NotifyClients(slot, clients, n, shaped, data, size);
+          }) {
         app_ = vsomeip::runtime::get()->create_application(name);
+        for (size_t i = 0; i < Service::kNumEvents; ++i) {
+            if (Service::kEventCoded[i]) encoders_[i].reset(new EventEncoder);
+        }
+        if (Service::kAnyBatched) {
+            batcher_.reset(new EventBatcher(Service::kNumEvents,
+                [this](size_t slot, const uint8_t* data, size_t size) {
+                    NotifyPooled(slot, data, size);
+                }));
+        }
+    }
+
+    // Tune the batch window / byte budget of a Batched<> event
+    template <typename E>
+    void SetBatching(BatchConfig cfg) {
+        static_assert(E::kBatched, "event is not declared as Batched<> in the service description");
+        batcher_->Configure(Service::template IndexOfEvent<E>(), cfg);
+    }
+
+    // Delta/compression settings of a Coded<> event
+    template <typename E>
+    void SetCodec(const CodecConfig& cfg) {
+        static_assert(E::kCoded, "event is not declared as Coded<> in the service description");
+        EventEncoder& e = *encoders_[Service::template IndexOfEvent<E>()];
+        std::lock_guard<std::mutex> lk(e.mu);
+        e.enc.Configure(cfg);
+        e.cfg = cfg;
+        e.shaped.clear();
     }
 
-    // Start offering the service and register message handler for a specific method
+    // Send every pending batch now
+    void FlushEvents() {
+        if (batcher_) batcher_->FlushAll();
+    }
+
+    // Install the handler for one method of Service (checked at compile time)
+    template <typename M>
+    void SetMethodHandler(Handler cb) {
+        method_handlers_[Service::template IndexOfMethod<M>()] = std::move(cb);
+    }
+
+    void SetConcurrency(MethodId method, MethodConcurrency c) override {
+        const int idx = Service::MethodIndex(method);
+        if (idx < 0) {
+            ARA_LOG_ERROR("[Server] Method 0x{:x} is not declared by the service", method);
+            return;
+        }
+        dispatch_.Configure(idx, c);
+    }
+
+    template <typename M>
+    void SetConcurrency(MethodConcurrency c) {
+        dispatch_.Configure(Service::template IndexOfMethod<M>(), c);
+    }
+
+    void SetIdempotent(MethodId method, ResponseCacheConfig cfg = ResponseCacheConfig()) override {
+        const int idx = Service::MethodIndex(method);
+        if (idx < 0) {
+            ARA_LOG_ERROR("[Server] Method 0x{:x} is not declared by the service", method);
+            return;
+        }
+        caches_[idx].reset(new ResponseCache(cfg));
+    }
+
+    template <typename M>
+    void SetIdempotent(ResponseCacheConfig cfg = ResponseCacheConfig()) {
+        caches_[Service::template IndexOfMethod<M>()].reset(new ResponseCache(cfg));
+    }
+
+    void InvalidateResponses() override {
+        for (auto& c : caches_) {
+            if (c) c->Clear();
+        }
+    }
+
+    // Run non-inline handlers on exec instead of Executor::Shared() (call before SetConcurrency)
+    void SetExecutor(std::shared_ptr<Executor> exec) { dispatch_.SetExecutor(std::move(exec)); }
+
+    // Size thresholds choosing UDP, SOME/IP-TP or TCP per response and
+    // notification (call before OfferService; proxies need the same maxTpMessage)
+    void SetTransport(const SomeipTransportConfig& cfg) { transport_ = cfg; }
+
+    // Reassembly of segmented requests (all zero before OfferService)
+    TpStats ReassemblyStats() const { return reassembler_ ? reassembler_->Stats() : TpStats(); }
+
+    // Requests of method M rejected because its queue was full
+    template <typename M>
+    uint64_t RejectedRequests() const { return dispatch_.Rejected(Service::template IndexOfMethod<M>()); }
+
+    // Start offering the service: one message handler per declared method,
+    // each bound to its table slot so dispatch needs no lookup
     void OfferService() override {
         app_->init();
+        reassembler_.reset(new TpReassembler(transport_));
 
-        // Register handler for CALIBRATE_METHOD_ID (0x42)
-        app_->register_message_handler(RADAR_SERVICE_ID, RADAR_INSTANCE_ID, CALIBRATE_METHOD_ID,
-            [this](const std::shared_ptr<vsomeip::message>& req) {
-                // Save the original request for response context
-                last_requests_[req->get_method()] = req;
-
-                // Convert SOME/IP message to generic Message and invoke user handler
-                Message m;
-                m.method = req->get_method();
-                auto pl = req->get_payload();
-                m.payload.assign(pl->get_data(), pl->get_data() + pl->get_length());
-                handler_(m);
-            });
+        for (size_t i = 0; i < Service::kNumMethods; ++i) {
+            app_->register_message_handler(Service::kServiceId, Service::kInstanceId, Service::kMethodIds[i],
+                [this, i](const std::shared_ptr<vsomeip::message>& req) {
+                    OnRequest(i, req, FromSomeip(req->get_payload()));
+                });
+        }
+        app_->register_message_handler(Service::kServiceId, Service::kInstanceId, kTpMethod,
+            [this](const std::shared_ptr<vsomeip::message>& req) { OnRequestSegment(req); });
+        for (size_t i = 0; i < Service::kNumEvents; ++i) {
+            app_->offer_event(Service::kServiceId, Service::kInstanceId, Service::kEventIds[i],
+                              std::set<vsomeip::eventgroup_t>{Service::kEventGroups[i]});
+        }
+        // Large notifications of any event travel on two shared events, in every eventgroup
+        std::set<vsomeip::eventgroup_t> groups(Service::kEventGroups, Service::kEventGroups + Service::kNumEvents);
+        if (!groups.empty()) {
+            app_->offer_event(Service::kServiceId, Service::kInstanceId, kTpEvent, groups,
+                              vsomeip::event_type_e::ET_EVENT, std::chrono::milliseconds::zero(), false, true,
+                              nullptr, vsomeip::reliability_type_e::RT_UNRELIABLE);
+            app_->offer_event(Service::kServiceId, Service::kInstanceId, kTcpEvent, groups,
+                              vsomeip::event_type_e::ET_EVENT, std::chrono::milliseconds::zero(), false, true,
+                              nullptr, vsomeip::reliability_type_e::RT_RELIABLE);
+        }
+        // Track subscribers per event so policies can be applied to each of them
+        for (vsomeip::eventgroup_t g : groups) {
+            app_->register_subscription_handler(Service::kServiceId, Service::kInstanceId, g,
+                [this, g](vsomeip::client_t client, uid_t, gid_t, bool subscribed) {
+                    for (size_t i = 0; i < Service::kNumEvents; ++i) {
+                        if (Service::kEventGroups[i] != g) continue;
+                        shaper_.Subscribe(i, client, subscribed);
+                        // A new subscriber has no reference frame: send the next one whole
+                        // (one with a policy starts a new stream of its own)
+                        if (encoders_[i]) {
+                            std::lock_guard<std::mutex> lk(encoders_[i]->mu);
+                            if (subscribed) encoders_[i]->enc.Reset();
+                            encoders_[i]->shaped.erase(client);
+                        }
+                    }
+                    return true;
+                });
+        }
+        app_->register_message_handler(Service::kServiceId, Service::kInstanceId, kEventPolicyMethod,
+            [this](const std::shared_ptr<vsomeip::message>& req) { OnEventPolicy(req); });
 
         // Offer the service to clients
-        app_->offer_service(RADAR_SERVICE_ID, RADAR_INSTANCE_ID);
+        app_->offer_service(Service::kServiceId, Service::kInstanceId);
         // Start the SOME/IP application in a separate thread
         std::thread([&] { app_->start(); }).detach();
     }
 
     // Stop offering the service
     void StopOfferService() override {
-        app_->stop_offer_service(RADAR_SERVICE_ID, RADAR_INSTANCE_ID);
+        app_->stop_offer_service(Service::kServiceId, Service::kInstanceId);
+    }
+
+    // Send a response to the client for the request identified by msg.request
+    void SendResponse(Message msg) override {
+        InFlight f;
+        if (!pending_.Take(msg.request, f)) {
+            ARA_LOG_WARN("[Server] No pending request 0x{:x} for method {} (answered or timed out)",
+                         msg.request, msg.method);
+            return;
+        }
+        metrics_.Method(f.method).latencyNs.RecordSince(f.received);
+        metrics_.Method(f.method).responseBytes.Record(msg.payload.size());
+        if (f.cacheable) caches_[f.method]->Store(f.cacheHash, f.cacheGen, f.request, msg.payload);
+        Respond(f.req, msg.method, std::move(msg.payload));
+    }
+
+    // Number of requests still waiting for SendResponse
+    size_t PendingRequests() const { return pending_.Size(); }
+
+    // Instrumentation of this skeleton, indexed like the Service tables
+    const BindingMetrics<Service::kNumMethods, Service::kNumEvents>& Metrics() const { return metrics_; }
+
+    std::string MetricsSnapshot() const override {
+        return metrics_.Json(Service::kMethodIds, Service::kEventIds);
     }
 
-    // Send a response to the client for a specific method
-    void SendResponse(const Message& msg) override {
-        if (!last_requests_.count(msg.method)) {
-            std::cerr << "[Server] No request found for method " << msg.method << std::endl;
+    // Send an event notification to all subscribed clients.
+    // The bytes are copied into a pooled payload, so publishing does not allocate.
+    void SendEvent(EventId event, Payload data) override {
+        const int idx = Service::EventIndex(event);
+        if (idx < 0) {
+            ARA_LOG_ERROR("[Server] Event 0x{:x} is not declared by the service", event);
             return;
         }
+        metrics_.Event(idx).bytes.Record(data.size());
+        // Batched events are framed and sent together with their neighbours
+        if (Service::kEventBatched[idx]) {
+            batcher_->Add(idx, data.data(), data.size());
+            return;
+        }
+        // Some subscriber has a policy: one notify_one per admitted subscriber
+        if (shaper_.Shaped(idx)) {
+            shaper_.Publish(idx, data.data(), data.size());
+            return;
+        }
+        // Coded events always go through their encoder
+        if (Service::kEventCoded[idx]) {
+            NotifyPooled(idx, data.data(), data.size());
+            return;
+        }
+        // Too large for one datagram: segmented or sent over TCP
+        if (transport_.Route(data.size()) != SomeipRoute::kUdp) {
+            NotifyRouted(event, data.data(), data.size(), nullptr, 0);
+            return;
+        }
+        // Forwarding a received payload: reuse it directly
+        if (auto pl = data.Owner<vsomeip::payload>(SomeipPayloadKind())) {
+            app_->notify(Service::kServiceId, Service::kInstanceId, event, pl);
+            return;
+        }
+        if (data.size() > PayloadPool::ClassSize(PayloadPool::kNumClasses - 1)) {
+            app_->notify(Service::kServiceId, Service::kInstanceId, event, ToSomeip(std::move(data)));
+            return;
+        }
+        NotifyPooled(idx, data.data(), data.size());
+    }
+
+    // Typed variant: E must be an event of Service. The value is serialized into
+    // a per-thread scratch buffer and then copied into a pooled payload.
+    template <typename E>
+    void SendEvent(const typename E::Type& value) {
+        SendTyped(Service::template IndexOfEvent<E>(), value);
+    }
+
+    // Typed response to the request identified by token (M must be a method of Service)
+    template <typename M>
+    void SendResponse(RequestToken request, const typename M::Response& value) {
+        Service::template IndexOfMethod<M>();
+        SendResponse(Message{M::kId, ser::Encode(value), request});
+    }
+
+    // Subscribers and policies shaping events sent to them (see EventShaper)
+    const EventShaper& Shaper() const { return shaper_; }
+
+private:
+    // Copy size bytes (encoded if the event is coded) into a pooled payload and
+    // notify the subscribers of event idx
+    void NotifyPooled(size_t idx, const uint8_t* data, size_t size) {
+        if (shaper_.Shaped(idx)) {
+            shaper_.Publish(idx, data, size);
+            return;
+        }
+        if (encoders_[idx]) {
+            std::lock_guard<std::mutex> lk(encoders_[idx]->mu);
+            const std::vector<uint8_t>& frame = encoders_[idx]->enc.Encode(data, size);
+            Notify(Service::kEventIds[idx], frame.data(), frame.size());
+            return;
+        }
+        Notify(Service::kEventIds[idx], data, size);
+    }
+
+    void Notify(EventId event, const uint8_t* data, size_t size) {
+        if (transport_.Route(size) != SomeipRoute::kUdp) {
+            NotifyRouted(event, data, size, nullptr, 0);
+            return;
+        }
+        auto lease = PayloadPool::Instance().Acquire(size);
+        if (!lease) {
+            app_->notify(Service::kServiceId, Service::kInstanceId, event,
+                         vsomeip::runtime::get()->create_payload(data, static_cast<uint32_t>(size)));
+            return;
+        }
+        lease.Get()->set_data(data, static_cast<vsomeip::length_t>(size));
+        app_->notify(Service::kServiceId, Service::kInstanceId, event, lease.Get());
+    }
 
-        auto req = last_requests_[msg.method];
+    // One payload for the n subscribers a notification of a shaped event goes to.
+    // Coded events: subscribers without a policy get the next frame of the shared
+    // stream, each one with a policy a frame of its own stream (it skipped some
+    // of the shared frames, so it could not decode their deltas).
+    void NotifyClients(size_t idx, const EventShaper::ClientId* clients, size_t n, bool shaped,
+                       const uint8_t* data, size_t size) {
+        if (!encoders_[idx]) {
+            SendToClients(idx, clients, n, data, size);
+            return;
+        }
+        EventEncoder& e = *encoders_[idx];
+        std::lock_guard<std::mutex> lk(e.mu);
+        if (!shaped) {
+            const std::vector<uint8_t>& frame = e.enc.Encode(data, size);
+            SendToClients(idx, clients, n, frame.data(), frame.size());
+            return;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            auto it = e.shaped.find(clients[i]);
+            if (it == e.shaped.end()) it = e.shaped.emplace(clients[i], FrameEncoder(e.cfg)).first;
+            const std::vector<uint8_t>& frame = it->second.Encode(data, size);
+            SendToClients(idx, &clients[i], 1, frame.data(), frame.size());
+        }
+    }
+
+    // One payload (already coded) for n subscribers of event idx
+    void SendToClients(size_t idx, const EventShaper::ClientId* clients, size_t n, const uint8_t* data, size_t size) {
+        if (transport_.Route(size) != SomeipRoute::kUdp) {
+            NotifyRouted(Service::kEventIds[idx], data, size, clients, n);
+            return;
+        }
+        auto lease = PayloadPool::Instance().Acquire(size);
+        std::shared_ptr<vsomeip::payload> pl = lease ? lease.Get()
+            : vsomeip::runtime::get()->create_payload(data, static_cast<uint32_t>(size));
+        if (lease) pl->set_data(data, static_cast<vsomeip::length_t>(size));
+        for (size_t i = 0; i < n; ++i) {
+            app_->notify_one(Service::kServiceId, Service::kInstanceId, Service::kEventIds[idx], pl, clients[i]);
+        }
+    }
+
+    // Notification larger than one datagram, to all subscribers (clients null)
+    // or to n of them: SOME/IP-TP segments on kTpEvent, or beyond maxTpMessage
+    // one message on the reliable kTcpEvent
+    void NotifyRouted(EventId event, const uint8_t* data, size_t size, const EventShaper::ClientId* clients, size_t n) {
+        auto send = [&](vsomeip::event_t id, const std::shared_ptr<vsomeip::payload>& pl) {
+            if (!clients) {
+                app_->notify(Service::kServiceId, Service::kInstanceId, id, pl);
+                return;
+            }
+            for (size_t i = 0; i < n; ++i) app_->notify_one(Service::kServiceId, Service::kInstanceId, id, pl, clients[i]);
+        };
+        if (transport_.Route(size) == SomeipRoute::kTcp) {
+            send(kTcpEvent, ToSomeip(Payload(segmenter_.Whole(event, data, size))));
+            return;
+        }
+        segmenter_.Segment(event, data, size, transport_.maxUdpPayload, [&](const uint8_t* seg, size_t len, bool) {
+            auto lease = PayloadPool::Instance().Acquire(len);
+            std::shared_ptr<vsomeip::payload> pl = lease ? lease.Get() : vsomeip::runtime::get()->create_payload();
+            pl->set_data(seg, static_cast<vsomeip::length_t>(len));
+            send(kTpEvent, pl);
+        });
+    }
+
+    // Response to req over UDP, SOME/IP-TP segments or TCP by its size
+    void Respond(const std::shared_ptr<vsomeip::message>& req, MethodId method, Payload data) {
+        const SomeipRoute route = transport_.Route(data.size());
+        if (route == SomeipRoute::kTp) {
+            segmenter_.Segment(method, data.data(), data.size(), transport_.maxUdpPayload,
+                [&](const uint8_t* seg, size_t len, bool) {
+                    auto resp = vsomeip::runtime::get()->create_response(req);
+                    resp->set_method(kTpMethod);
+                    resp->set_reliable(false);
+                    resp->set_payload(vsomeip::runtime::get()->create_payload(seg, static_cast<uint32_t>(len)));
+                    app_->send(resp);
+                });
+            return;
+        }
         auto resp = vsomeip::runtime::get()->create_response(req);
 
         // Set service, instance, and method IDs for the response
-        resp->set_service(RADAR_SERVICE_ID);
-        resp->set_instance(RADAR_INSTANCE_ID);
-        resp->set_method(msg.method);
+        resp->set_service(Service::kServiceId);
+        resp->set_instance(Service::kInstanceId);
+        resp->set_method(method);
+        resp->set_reliable(route == SomeipRoute::kTcp);
 
         // Set the response payload
-        auto pl = vsomeip::runtime::get()->create_payload();
-        pl->set_data(msg.payload.data(), msg.payload.size());
-        resp->set_payload(pl);
+        resp->set_payload(ToSomeip(std::move(data)));
 
         // Send the response message
         app_->send(resp);
     }
 
-    // Send an event notification to all subscribed clients
-    void SendEvent(EventId event, const std::vector<uint8_t>& data) override {
-        auto pl = vsomeip::runtime::get()->create_payload();
-        pl->set_data(data.data(), data.size());
-        app_->notify(RADAR_SERVICE_ID, RADAR_INSTANCE_ID, event, pl);
+    // One segment of a request too large for a datagram; the request is
+    // dispatched once all its segments are in
+    void OnRequestSegment(const std::shared_ptr<vsomeip::message>& msg) {
+        const Payload data = FromSomeip(msg->get_payload());
+        tp::Segment seg;
+        if (!tp::Parse(data.data(), data.size(), seg)) {
+            ARA_LOG_WARN("[Server] Malformed request segment from client 0x{:x}", msg->get_client());
+            return;
+        }
+        Payload whole;
+        std::shared_ptr<vsomeip::message> last;
+        if (!reassembler_->Add(msg->get_client(), seg, msg, whole, last)) return;
+        const int idx = Service::MethodIndex(seg.id);
+        if (idx < 0) {
+            ARA_LOG_ERROR("[Server] Method 0x{:x} is not declared by the service", seg.id);
+            return;
+        }
+        OnRequest(static_cast<size_t>(idx), last, std::move(whole));
+    }
+
+    void OnEventPolicy(const std::shared_ptr<vsomeip::message>& req) {
+        EventPolicyRequest r;
+        const int idx = ser::Decode(FromSomeip(req->get_payload()), r) ? Service::EventIndex(r.event) : -1;
+        if (idx < 0) {
+            ARA_LOG_WARN("[Server] Ignoring event policy of client 0x{:x}: malformed or unknown event",
+                         req->get_client());
+            return;
+        }
+        EventPolicy p;
+        p.minInterval = std::chrono::microseconds(r.minIntervalUs);
+        p.everyNth = r.everyNth ? r.everyNth : 1;
+        p.latestOnly = r.latestOnly;
+        shaper_.SetPolicy(static_cast<size_t>(idx), req->get_client(), p);
+        // The client may move between the shared and its own coded stream: the
+        // next frame of either one is sent whole
+        if (encoders_[idx]) {
+            std::lock_guard<std::mutex> lk(encoders_[idx]->mu);
+            encoders_[idx]->enc.Reset();
+            encoders_[idx]->shaped.erase(req->get_client());
+        }
+        ARA_LOG_INFO("[Server] Client 0x{:x} event 0x{:x}: every {} notification(s), min interval {}us{}",
+                     req->get_client(), r.event, p.everyNth, r.minIntervalUs, p.latestOnly ? ", latest value only" : "");
+    }
+
+    void SendTyped(size_t idx, const Payload& p) { SendEvent(Service::kEventIds[idx], p); }
+
+    template <typename T>
+    void SendTyped(size_t idx, const T& value) {
+        static thread_local std::vector<uint8_t> scratch;
+        ser::EncodeInto(value, scratch);
+        metrics_.Event(idx).bytes.Record(scratch.size());
+        if (Service::kEventBatched[idx]) {
+            batcher_->Add(idx, scratch.data(), scratch.size());
+        } else {
+            NotifyPooled(idx, scratch.data(), scratch.size());
+        }
+    }
+
+    // Dispatch one request (received whole, or put together from segments)
+    // to the handler in table slot idx
+    void OnRequest(size_t idx, const std::shared_ptr<vsomeip::message>& req, Payload request) {
+        const auto received = std::chrono::steady_clock::now();
+        MethodMetrics& mm = metrics_.Method(idx);
+        mm.requestBytes.Record(request.size());
+
+        // Idempotent method: answer a request seen before without running the handler
+        InFlight f;
+        f.req = req;
+        f.received = received;
+        f.method = idx;
+        if (ResponseCache* cache = caches_[idx].get()) {
+            f.cacheHash = HashBytes(request.data(), request.size());
+            std::vector<uint8_t> cached;
+            if (cache->Lookup(f.cacheHash, request, cached)) {
+                mm.cacheHits.fetch_add(1, std::memory_order_relaxed);
+                mm.latencyNs.RecordSince(received);
+                mm.responseBytes.Record(cached.size());
+                Respond(req, Service::kMethodIds[idx], Payload(std::move(cached)));
+                return;
+            }
+            mm.cacheMisses.fetch_add(1, std::memory_order_relaxed);
+            f.cacheable = true;
+            f.cacheGen = cache->Generation();
+            f.request = request;
+        }
+
+        // Save the original request for response context
+        const RequestToken token = MakeRequestToken(req->get_client(), req->get_session());
+        pending_.MaybeEvict();
+        pending_.Insert(token, std::move(f));
+
+        // Convert SOME/IP message to generic Message and invoke user handler
+        Message m;
+        m.method = Service::kMethodIds[idx];
+        m.request = token;
+        m.payload = std::move(request);
+        const Handler* h = method_handlers_[idx] ? &method_handlers_[idx] : &handler_;
+        if (!*h) return;
+        auto run = [h, &mm, m = std::move(m)]() {
+            const auto t0 = std::chrono::steady_clock::now();
+            (*h)(m);
+            mm.handlerNs.RecordSince(t0);
+        };
+        if (!dispatch_.Dispatch(idx, std::move(run))) Reject(token);
+    }
+
+    // Answer a request whose method queue is full with E_NOT_READY so the caller backs off
+    void Reject(RequestToken token) {
+        InFlight f;
+        if (!pending_.Take(token, f)) return;
+        auto resp = vsomeip::runtime::get()->create_response(f.req);
+        resp->set_method(Service::kMethodIds[f.method]);
+        resp->set_message_type(vsomeip::message_type_e::MT_ERROR);
+        resp->set_return_code(vsomeip::return_code_e::E_NOT_READY);
+        app_->send(resp);
     }
 };
 
-// Implementation of Proxy using SOME/IP protocol
+// Implementation of Proxy using SOME/IP protocol for the service described by Service
+template <typename Service>
 class SomeipProxy : public Proxy {
     std::shared_ptr<vsomeip::application> app_; // SOME/IP application instance
-    std::map<EventId, std::function<void(const std::vector<uint8_t>&)>> event_callbacks_; // Event callbacks
-    std::map<MethodId, std::function<void(const std::vector<uint8_t>&)>> response_callbacks_; // Response callbacks
+    InstanceIdentifier instance_{Service::kInstanceId}; // Instance selected by FindService
+    // Callbacks indexed by method position in Service
+    std::array<std::function<void(const Payload&)>, Service::kNumMethods> response_callbacks_;
+
+    // Callback and delivery queue per event position. A table is immutable once
+    // published: SubscribeEvent/SetDelivery store a changed copy with one atomic
+    // store, so the receive thread and the consumers read it without a lock.
+    // Replaced tables are kept until the proxy goes away, since a reader may
+    // still use one; they only change when the proxy is (re)configured.
+    struct EventTable {
+        std::array<std::function<void(const Payload&)>, Service::kNumEvents> callbacks;
+        std::array<EventQueue*, Service::kNumEvents> queues{};
+    };
+    std::atomic<const EventTable*> events_{nullptr};
+    std::mutex events_mu_; // serializes writers only
+    std::vector<std::unique_ptr<const EventTable>> tables_;
+
+    // Decoders of Coded<> events (null for other events)
+    struct EventDecoder {
+        std::mutex mu;
+        FrameDecoder dec;
+    };
+    std::array<std::unique_ptr<EventDecoder>, Service::kNumEvents> decoders_;
+
+    // Asynchronous calls waiting for a response, keyed by client/session
+    CallTracker calls_;
+    std::mutex send_mu_; // held across send() so the session is known before the reply is handled
+
+    // Calls made while the service is not offered, sent in order once it is.
+    // A queued call with a timeout is tracked under a placeholder token until
+    // then, so it still times out. Guarded by send_mu_ like available_.
+    struct QueuedCall {
+        MethodId method;
+        Payload req;
+        RequestToken placeholder; // 0: no response expected
+        std::chrono::steady_clock::time_point deadline;
+        std::chrono::steady_clock::time_point queued;
+    };
+    static constexpr RequestToken kQueuedToken = 0xFFFF0000u; // client 0xFFFF is never assigned
+    std::deque<QueuedCall> queued_;
+    size_t maxQueued_{256};
+    uint16_t nextPlaceholder_{0};
+    bool available_{false};
+    bool everAvailable_{false};
+    std::condition_variable available_cv_;
+    std::chrono::steady_clock::time_point findAt_;  // FindService
+    std::chrono::steady_clock::time_point lostAt_;  // last outage began
+    std::atomic<bool> responded_{false};
+    AvailabilityMetrics availability_;
+
+    BindingMetrics<Service::kNumMethods, Service::kNumEvents> metrics_;
+
+    // Policies requested per event, sent again whenever the service (re)appears
+    std::mutex policy_mu_;
+    std::array<EventPolicy, Service::kNumEvents> policies_;
+
+    // UDP/TCP thresholds; segmented responses and notifications are put back
+    // together in reassembler_ (allocated by FindService)
+    SomeipTransportConfig transport_;
+    TpSegmenter segmenter_;
+    std::unique_ptr<TpReassembler> reassembler_;
+
+    // Delivery queues, replaced ones included; declared last so consumers
+    // finish while the tables and metrics they use still exist
+    std::vector<std::unique_ptr<EventQueue>> queues_;
 
 public:
     // Constructor: create SOME/IP application
     SomeipProxy(const std::string& name) {
+        tables_.emplace_back(new EventTable);
+        events_.store(tables_.back().get());
         app_ = vsomeip::runtime::get()->create_application(name);
+        for (size_t i = 0; i < Service::kNumEvents; ++i) {
+            if (Service::kEventCoded[i]) decoders_[i].reset(new EventDecoder);
+        }
     }
 
-    // Request a service and register response handler for a specific method
+    // Request a service and register a response handler for every declared method
     void FindService(InstanceIdentifier instance) override {
+        instance_ = instance;
+        findAt_ = std::chrono::steady_clock::now();
         app_->init();
-        app_->request_service(RADAR_SERVICE_ID, instance);
-
-        // Register handler for CALIBRATE_METHOD_ID response
-        app_->register_message_handler(RADAR_SERVICE_ID, RADAR_INSTANCE_ID, CALIBRATE_METHOD_ID,
-            [this](const std::shared_ptr<vsomeip::message>& resp) {
-                auto pl = resp->get_payload();
-                std::vector<uint8_t> data(pl->get_data(), pl->get_data() + pl->get_length());
-                // Invoke registered response callback if available
-                if (response_callbacks_.count(CALIBRATE_METHOD_ID))
-                    response_callbacks_[CALIBRATE_METHOD_ID](data);
-            });
+        reassembler_.reset(new TpReassembler(transport_));
+        app_->request_service(Service::kServiceId, instance_);
+
+        for (size_t i = 0; i < Service::kNumMethods; ++i) {
+            app_->register_message_handler(Service::kServiceId, instance_, Service::kMethodIds[i],
+                [this, i](const std::shared_ptr<vsomeip::message>& resp) {
+                    OnResponse(i, resp, FromSomeip(resp->get_payload()));
+                });
+        }
+        // Responses and notifications too large for one datagram
+        app_->register_message_handler(Service::kServiceId, instance_, kTpMethod,
+            [this](const std::shared_ptr<vsomeip::message>& msg) { OnSegment(msg, false); });
+        app_->register_message_handler(Service::kServiceId, instance_, kTpEvent,
+            [this](const std::shared_ptr<vsomeip::message>& msg) { OnSegment(msg, true); });
+        app_->register_message_handler(Service::kServiceId, instance_, kTcpEvent,
+            [this](const std::shared_ptr<vsomeip::message>& msg) { OnSegment(msg, true); });
+        // Calls wait while the service is not offered; a restarted skeleton has
+        // also forgotten the policies of this proxy
+        app_->register_availability_handler(Service::kServiceId, instance_,
+            [this](vsomeip::service_t, vsomeip::instance_t, bool available) { OnAvailability(available); });
 
         // Start the SOME/IP application in a separate thread
         std::thread([&] { app_->start(); }).detach();
@@ -123,41 +723,427 @@ public:
 
     // Release the requested service
     void StopFindService(InstanceIdentifier instance) override {
-        app_->release_service(RADAR_SERVICE_ID, instance);
+        app_->release_service(Service::kServiceId, instance);
     }
 
     // Send a method call request to the server
-    void MethodCall(MethodId method, const std::vector<uint8_t>& req) override {
-        auto msg = vsomeip::runtime::get()->create_request();
-        msg->set_service(RADAR_SERVICE_ID);
-        msg->set_instance(RADAR_INSTANCE_ID);
-        msg->set_method(method);
+    void MethodCall(MethodId method, Payload req) override {
+        if (Service::MethodIndex(method) < 0) {
+            ARA_LOG_ERROR("[Client] Method 0x{:x} is not declared by the service", method);
+            return;
+        }
+        std::lock_guard<std::mutex> lk(send_mu_);
+        if (!available_) {
+            Enqueue(method, std::move(req), nullptr, {});
+            return;
+        }
+        SendRequest(method, std::move(req));
+    }
 
-        // Set the request payload
-        auto pl = vsomeip::runtime::get()->create_payload();
-        pl->set_data(req.data(), req.size());
-        msg->set_payload(pl);
+    // Send a method call and return a handle whose future holds the response.
+    // The reply is matched by SOME/IP session ID; the call fails with
+    // CallStatus::kTimeout if nothing arrives within timeout. While the
+    // service is unavailable the call is queued (its timeout keeps running)
+    // and its Token() is a placeholder; if the service goes away while the
+    // call is in flight, it fails with CallStatus::kUnavailable.
+    CallHandle MethodCall(MethodId method, Payload req, std::chrono::milliseconds timeout) override {
+        auto st = std::make_shared<CallState>();
+        if (Service::MethodIndex(method) < 0) {
+            st->Fail(CallStatus::kError, "method is not declared by the service");
+            return CallHandle(std::move(st), 0);
+        }
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        // send() assigns client/session; register before a reply can be looked up
+        std::lock_guard<std::mutex> lk(send_mu_);
+        if (!available_) return Enqueue(method, std::move(req), std::move(st), deadline);
+        const auto msg = SendRequest(method, std::move(req));
+        return calls_.Track(MakeRequestToken(msg->get_client(), msg->get_session()), std::move(st), deadline);
+    }
 
-        // Send the request message
-        app_->send(msg);
+    // Typed variants: M must be a method of Service; the request is serialized
+    // with its declared type (decode the response with ser::Decode)
+    template <typename M>
+    void MethodCall(const typename M::Request& req) {
+        Service::template IndexOfMethod<M>();
+        MethodCall(M::kId, ser::Encode(req));
     }
 
+    template <typename M>
+    CallHandle MethodCall(const typename M::Request& req, std::chrono::milliseconds timeout) {
+        Service::template IndexOfMethod<M>();
+        return MethodCall(M::kId, ser::Encode(req), timeout);
+    }
+
+    // Number of asynchronous calls still waiting for a response
+    size_t PendingCalls() const { return calls_.Size(); }
+
+    bool WaitAvailable(std::chrono::milliseconds timeout) override {
+        std::unique_lock<std::mutex> lk(send_mu_);
+        return available_cv_.wait_for(lk, timeout, [this] { return available_; });
+    }
+
+    // Calls held while the service is unavailable; beyond n they fail with
+    // CallStatus::kUnavailable (fire-and-forget ones are dropped)
+    void SetCallQueueLimit(size_t n) {
+        std::lock_guard<std::mutex> lk(send_mu_);
+        maxQueued_ = n;
+    }
+
+    // Calls waiting for the service to be offered
+    size_t QueuedCalls() {
+        std::lock_guard<std::mutex> lk(send_mu_);
+        return queued_.size();
+    }
+
+    // Size thresholds choosing UDP, SOME/IP-TP or TCP per request (call
+    // before FindService; the skeleton needs the same maxTpMessage)
+    void SetTransport(const SomeipTransportConfig& cfg) { transport_ = cfg; }
+
+    // Reassembly of segmented responses and notifications (all zero before FindService)
+    TpStats ReassemblyStats() const { return reassembler_ ? reassembler_->Stats() : TpStats(); }
+
+    // Instrumentation of this proxy: call round trips, payload sizes, event callback times
+    const BindingMetrics<Service::kNumMethods, Service::kNumEvents>& Metrics() const { return metrics_; }
+
+    std::string MetricsSnapshot() const override {
+        return metrics_.Json(Service::kMethodIds, Service::kEventIds, "\"availability\":" + availability_.Json());
+    }
+
+    // Startup and outage recovery of the service (see AvailabilityMetrics)
+    const AvailabilityMetrics& Availability() const { return availability_; }
+
     // Subscribe to an event and register a callback to handle event data
-    void SubscribeEvent(EventId event, std::function<void(const std::vector<uint8_t>&)> cb) override {
-        event_callbacks_[event] = cb;
-        app_->register_message_handler(RADAR_SERVICE_ID, RADAR_INSTANCE_ID, event,
-            [this, event](const std::shared_ptr<vsomeip::message>& msg) {
-                auto pl = msg->get_payload();
-                std::vector<uint8_t> data(pl->get_data(), pl->get_data() + pl->get_length());
-                event_callbacks_[event](data);
+    void SubscribeEvent(EventId event, std::function<void(const Payload&)> cb) override {
+        const int idx = Service::EventIndex(event);
+        if (idx < 0) {
+            ARA_LOG_ERROR("[Client] Event 0x{:x} is not declared by the service", event);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(events_mu_);
+            Publish([&](EventTable& t) { t.callbacks[idx] = std::move(cb); });
+        }
+        app_->register_message_handler(Service::kServiceId, instance_, event,
+            [this, idx](const std::shared_ptr<vsomeip::message>& msg) {
+                OnNotification(idx, FromSomeip(msg->get_payload()));
             });
-        // Subscribe to the event
-        app_->subscribe(RADAR_SERVICE_ID, RADAR_INSTANCE_ID, event);
+        // Subscribe to the event's eventgroup, large notifications included
+        const std::set<vsomeip::eventgroup_t> group{Service::kEventGroups[idx]};
+        app_->request_event(Service::kServiceId, instance_, event, group);
+        app_->request_event(Service::kServiceId, instance_, kTpEvent, group, vsomeip::event_type_e::ET_EVENT,
+                            vsomeip::reliability_type_e::RT_UNRELIABLE);
+        app_->request_event(Service::kServiceId, instance_, kTcpEvent, group, vsomeip::event_type_e::ET_EVENT,
+                            vsomeip::reliability_type_e::RT_RELIABLE);
+        app_->subscribe(Service::kServiceId, instance_, Service::kEventGroups[idx]);
+    }
+
+    // Run the callback of event on the receive thread or on a consumer thread
+    // behind a bounded queue (see EventDelivery). May be changed at any time:
+    // what the previous queue holds is still delivered.
+    void SetDelivery(EventId event, EventDelivery d) override {
+        const int idx = Service::EventIndex(event);
+        if (idx < 0) {
+            ARA_LOG_ERROR("[Client] Event 0x{:x} is not declared by the service", event);
+            return;
+        }
+        EventQueue* old = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(events_mu_);
+            EventQueue* q = nullptr;
+            if (d.mode == EventDelivery::kQueued) {
+                queues_.emplace_back(new EventQueue(d, [this, idx](const Payload& p) { Invoke(idx, p); },
+                                                    metrics_.Event(idx)));
+                q = queues_.back().get();
+            }
+            old = events_.load()->queues[idx];
+            Publish([&](EventTable& t) { t.queues[idx] = q; });
+        }
+        if (old) old->Stop();
+    }
+
+    template <typename E>
+    void SetDelivery(EventDelivery d) {
+        Service::template IndexOfEvent<E>();
+        SetDelivery(E::kId, d);
+    }
+
+    // Subscribe and ask the skeleton to shape notifications sent to this proxy
+    // (rate limit, decimation, latest value only; see EventPolicy)
+    void SubscribeEvent(EventId event, std::function<void(const Payload&)> cb, const EventPolicy& policy) override {
+        const int idx = Service::EventIndex(event);
+        bool send = false;
+        if (idx >= 0) {
+            std::lock_guard<std::mutex> lk(policy_mu_);
+            send = !policy.Unshaped() || !policies_[idx].Unshaped(); // set, or lift an earlier one
+            policies_[idx] = policy;
+        }
+        // Sent ahead of the subscription, so the first notification is already shaped
+        if (send) SendPolicy(static_cast<size_t>(idx), policy);
+        SubscribeEvent(event, std::move(cb));
+    }
+
+    // Typed variant: every notification is decoded in place into one object
+    // owned by the subscription, so steady-state decoding reuses its storage
+    template <typename E>
+    void SubscribeEvent(std::function<void(const typename E::Type&)> cb, const EventPolicy& policy = EventPolicy()) {
+        Service::template IndexOfEvent<E>();
+        auto value = std::make_shared<typename E::Type>();
+        SubscribeEvent(E::kId, [cb, value](const Payload& data) {
+            if (!ser::Decode(data, *value)) {
+                ARA_LOG_WARN("[Client] Malformed payload for event 0x{:x}", E::kId);
+                return;
+            }
+            cb(*value);
+        }, policy);
     }
 
     // Register a callback to handle responses for a specific method
-    void RegisterResponseHandler(MethodId method, std::function<void(const std::vector<uint8_t>&)> cb) override {
-        response_callbacks_[method] = cb;
+    void RegisterResponseHandler(MethodId method, std::function<void(const Payload&)> cb) override {
+        const int idx = Service::MethodIndex(method);
+        if (idx >= 0) response_callbacks_[idx] = cb;
+    }
+
+private:
+    std::shared_ptr<vsomeip::message> MakeRequest(vsomeip::method_t method, std::shared_ptr<vsomeip::payload> pl) {
+        auto msg = vsomeip::runtime::get()->create_request();
+        msg->set_service(Service::kServiceId);
+        msg->set_instance(instance_);
+        msg->set_method(method);
+        // Set the request payload
+        msg->set_payload(std::move(pl));
+        return msg;
+    }
+
+    // Send a request over UDP, SOME/IP-TP segments or TCP by its size; returns
+    // the message whose client/session the response will carry
+    std::shared_ptr<vsomeip::message> SendRequest(MethodId method, Payload&& req) {
+        metrics_.Method(Service::MethodIndex(method)).requestBytes.Record(req.size());
+        const SomeipRoute route = transport_.Route(req.size());
+        if (route != SomeipRoute::kTp) {
+            auto msg = MakeRequest(method, ToSomeip(std::move(req)));
+            msg->set_reliable(route == SomeipRoute::kTcp);
+            app_->send(msg);
+            return msg;
+        }
+        // Only the last segment expects a response
+        std::shared_ptr<vsomeip::message> last;
+        segmenter_.Segment(method, req.data(), req.size(), transport_.maxUdpPayload,
+            [&](const uint8_t* seg, size_t len, bool final) {
+                auto msg = MakeRequest(kTpMethod,
+                                       vsomeip::runtime::get()->create_payload(seg, static_cast<uint32_t>(len)));
+                msg->set_message_type(final ? vsomeip::message_type_e::MT_REQUEST
+                                            : vsomeip::message_type_e::MT_REQUEST_NO_RETURN);
+                app_->send(msg);
+                if (final) last = msg;
+            });
+        return last;
+    }
+
+    // Hold a call made while the service is unavailable (caller holds send_mu_)
+    CallHandle Enqueue(MethodId method, Payload&& req, std::shared_ptr<CallState> st,
+                       std::chrono::steady_clock::time_point deadline) {
+        if (queued_.size() >= maxQueued_) {
+            availability_.rejected.fetch_add(1, std::memory_order_relaxed);
+            ARA_LOG_WARN("[Client] Service 0x{:x} unavailable and {} calls queued: dropping call of method 0x{:x}",
+                         Service::kServiceId, queued_.size(), method);
+            if (!st) return CallHandle();
+            st->Fail(CallStatus::kUnavailable, "service unavailable and call queue full");
+            return CallHandle(std::move(st), 0);
+        }
+        availability_.queued.fetch_add(1, std::memory_order_relaxed);
+        const auto now = std::chrono::steady_clock::now();
+        if (!st) {
+            queued_.push_back(QueuedCall{method, std::move(req), 0, deadline, now});
+            return CallHandle();
+        }
+        const RequestToken placeholder = kQueuedToken | nextPlaceholder_++;
+        queued_.push_back(QueuedCall{method, std::move(req), placeholder, deadline, now});
+        return calls_.Track(placeholder, std::move(st), deadline);
+    }
+
+    // Service offered: send the queued calls in order. Service gone: calls in
+    // flight will not be answered, fail them now instead of at their timeout.
+    void OnAvailability(bool available) {
+        using Clock = std::chrono::steady_clock;
+        if (available) SendPolicies();
+        std::lock_guard<std::mutex> lk(send_mu_);
+        if (available == available_) return;
+        available_ = available;
+        const auto now = Clock::now();
+        if (!available) {
+            lostAt_ = now;
+            const size_t failed = calls_.FailAll(CallStatus::kUnavailable, "service became unavailable");
+            availability_.failedInFlight.fetch_add(failed, std::memory_order_relaxed);
+            ARA_LOG_WARN("[Client] Service 0x{:x} unavailable: {} call(s) in flight failed, new calls are queued",
+                         Service::kServiceId, failed);
+            return;
+        }
+        const int64_t waitedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            now - (everAvailable_ ? lostAt_ : findAt_)).count();
+        if (everAvailable_) {
+            availability_.reofferNs.Record(static_cast<uint64_t>(waitedNs));
+        } else {
+            availability_.timeToAvailableNs.store(waitedNs, std::memory_order_relaxed);
+        }
+        everAvailable_ = true;
+        size_t sent = 0;
+        while (!queued_.empty()) {
+            QueuedCall c = std::move(queued_.front());
+            queued_.pop_front();
+            std::shared_ptr<CallState> st;
+            // Timed out or cancelled while queued: nobody waits for it anymore
+            if (c.placeholder && (!calls_.Take(c.placeholder, st) || st->Done())) continue;
+            availability_.queueWaitNs.RecordSince(c.queued);
+            const auto msg = SendRequest(c.method, std::move(c.req));
+            if (st) calls_.Watch(MakeRequestToken(msg->get_client(), msg->get_session()), std::move(st), c.deadline);
+            ++sent;
+        }
+        available_cv_.notify_all();
+        ARA_LOG_INFO("[Client] Service 0x{:x} available after {}ms, {} queued call(s) sent",
+                     Service::kServiceId, waitedNs / 1000000, sent);
+    }
+
+    // A response received whole or put together from segments
+    void OnResponse(size_t idx, const std::shared_ptr<vsomeip::message>& resp, Payload data) {
+        if (!responded_.exchange(true, std::memory_order_relaxed)) {
+            availability_.timeToFirstResponseNs.store(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - findAt_).count(),
+                std::memory_order_relaxed);
+        }
+        metrics_.Method(idx).responseBytes.Record(data.size());
+        // Complete the matching asynchronous call, if this reply belongs to one
+        if (CompleteCall(idx, resp, data)) return;
+        // Invoke registered response callback if available
+        if (response_callbacks_[idx]) response_callbacks_[idx](data);
+    }
+
+    // One notification of event idx as received (or reassembled)
+    void OnNotification(size_t idx, Payload data) {
+        if (decoders_[idx] && !Decode(idx, data)) return;
+        // Decoding and unbatching stay on the receive thread (they depend
+        // on arrival order); callbacks run here or on the event's consumer
+        EventQueue* q = events_.load(std::memory_order_acquire)->queues[idx];
+        auto deliver = [this, idx, q](const Payload& p) {
+            if (q) {
+                q->Push(p);
+            } else {
+                Invoke(idx, p);
+            }
+        };
+        // A batch frame carries several notifications: one callback each
+        if (Service::kEventBatched[idx]) {
+            if (!ForEachRecord(data, deliver)) {
+                ARA_LOG_WARN("[Client] Truncated batch frame for event 0x{:x}", Service::kEventIds[idx]);
+            }
+            return;
+        }
+        deliver(data);
+    }
+
+    // A segment of a response (kTpMethod) or notification (kTpEvent), or a
+    // notification sent whole over TCP (kTcpEvent, a single segment: no copy)
+    void OnSegment(const std::shared_ptr<vsomeip::message>& msg, bool event) {
+        Payload data = FromSomeip(msg->get_payload());
+        tp::Segment seg;
+        if (!tp::Parse(data.data(), data.size(), seg)) {
+            ARA_LOG_WARN("[Client] Malformed segment on 0x{:x}", msg->get_method());
+            return;
+        }
+        Payload whole;
+        std::shared_ptr<vsomeip::message> last = msg;
+        if (seg.offset == 0 && !seg.more) {
+            whole = data.Slice(tp::kHeaderSize, seg.size);
+        } else if (!reassembler_->Add(0, seg, msg, whole, last)) {
+            return;
+        }
+        if (!event) {
+            const int idx = Service::MethodIndex(seg.id);
+            if (idx >= 0) OnResponse(static_cast<size_t>(idx), last, std::move(whole));
+            return;
+        }
+        // Large notifications of all events of the group arrive here: skip unsubscribed ones
+        const int idx = Service::EventIndex(seg.id);
+        if (idx < 0 || !events_.load(std::memory_order_acquire)->callbacks[idx]) return;
+        OnNotification(static_cast<size_t>(idx), std::move(whole));
+    }
+
+    // Publish a copy of the current event table with change applied (caller holds events_mu_)
+    template <typename F>
+    void Publish(F&& change) {
+        std::unique_ptr<EventTable> t(new EventTable(*events_.load()));
+        change(*t);
+        events_.store(t.get(), std::memory_order_release);
+        tables_.emplace_back(std::move(t));
+    }
+
+    // Run the current callback of event idx
+    void Invoke(size_t idx, const Payload& p) {
+        EventMetrics& em = metrics_.Event(idx);
+        em.bytes.Record(p.size());
+        const auto& cb = events_.load(std::memory_order_acquire)->callbacks[idx];
+        const auto t0 = std::chrono::steady_clock::now();
+        cb(p);
+        em.handlerNs.RecordSince(t0);
+    }
+
+    // Replace a coded frame by the notification it carries; false if it cannot be decoded
+    bool Decode(size_t idx, Payload& data) {
+        EventDecoder& d = *decoders_[idx];
+        std::lock_guard<std::mutex> lk(d.mu);
+        const bool synced = d.dec.Synced();
+        if (d.dec.Decode(data.data(), data.size(), data)) return true;
+        // Logged once per gap: deltas are dropped quietly until the next keyframe
+        if (synced) {
+            ARA_LOG_WARN("[Client] Event 0x{:x}: frame lost or malformed, waiting for a keyframe",
+                         Service::kEventIds[idx]);
+        }
+        return false;
+    }
+
+    void SendPolicy(size_t idx, const EventPolicy& policy) {
+        EventPolicyRequest r;
+        r.event = Service::kEventIds[idx];
+        r.minIntervalUs = static_cast<uint32_t>(policy.minInterval.count());
+        r.everyNth = policy.everyNth;
+        r.latestOnly = policy.latestOnly;
+        auto msg = vsomeip::runtime::get()->create_request();
+        msg->set_service(Service::kServiceId);
+        msg->set_instance(instance_);
+        msg->set_method(kEventPolicyMethod);
+        msg->set_message_type(vsomeip::message_type_e::MT_REQUEST_NO_RETURN);
+        msg->set_payload(ToSomeip(ser::Encode(r)));
+        app_->send(msg);
+    }
+
+    void SendPolicies() {
+        std::array<EventPolicy, Service::kNumEvents> policies;
+        {
+            std::lock_guard<std::mutex> lk(policy_mu_);
+            policies = policies_;
+        }
+        for (size_t i = 0; i < Service::kNumEvents; ++i) {
+            if (!policies[i].Unshaped()) SendPolicy(i, policies[i]);
+        }
+    }
+
+    // Route a reply to the CallState registered for its session; false if none
+    bool CompleteCall(size_t idx, const std::shared_ptr<vsomeip::message>& resp, Payload& data) {
+        const RequestToken token = MakeRequestToken(resp->get_client(), resp->get_session());
+        std::shared_ptr<CallState> st;
+        if (!calls_.Take(token, st)) {
+            // The sender may still be between send() and Track(); wait for it once
+            { std::lock_guard<std::mutex> lk(send_mu_); }
+            if (!calls_.Take(token, st)) return false;
+        }
+        metrics_.Method(idx).latencyNs.RecordSince(st->Issued());
+        if (resp->get_message_type() == vsomeip::message_type_e::MT_ERROR ||
+            resp->get_return_code() != vsomeip::return_code_e::E_OK) {
+            st->Fail(CallStatus::kError, "method call failed with return code " +
+                     std::to_string(static_cast<int>(resp->get_return_code())));
+            return true;
+        }
+        st->Complete(Message{Service::kMethodIds[idx], std::move(data), token});
+        return true;
     }
 };
 
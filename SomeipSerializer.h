@@ -0,0 +1,443 @@
+// SomeipSerializer.h
+#pragma once
+#include "AraCom_Skeleton.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ARACOM_SER_X86 1
+#endif
+
+/**
+ * SOME/IP serialization of C++ types (big endian, no alignment padding):
+ * - integers, floats, bool and enums: fixed size, network byte order
+ * - std::array<T, N>: fixed length array, no length field
+ * - std::vector<T>: dynamic array with 32-bit length field (bytes)
+ * - std::string: 32-bit length field + UTF-8 BOM + chars + '\0'
+ * - structs: members in order, declared with SOMEIP_FIELDS
+ *
+ *   struct Detection {
+ *       float range; float azimuth;
+ *       SOMEIP_FIELDS(range, azimuth)
+ *   };
+ *
+ * Wire sizes of fixed layouts are computed at compile time. Arrays of
+ * arithmetic values (or of structs made only of same-width arithmetic
+ * members) are byte-swapped in bulk with SSSE3/AVX2 when the CPU has it.
+ * Decoding reuses the storage already held by the target object.
+ */
+#define SOMEIP_FIELDS(...) \
+    auto SomeipTie() { return std::tie(__VA_ARGS__); } \
+    auto SomeipTie() const { return std::tie(__VA_ARGS__); }
+
+namespace ara {
+namespace com {
+namespace ser {
+
+namespace detail {
+
+constexpr bool kLittleEndianHost = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+// Byte-reverse count elements of width bytes from src into dst (scalar)
+inline void SwapCopyScalar(uint8_t* dst, const uint8_t* src, size_t count, size_t width) {
+    switch (width) {
+    case 2:
+        for (size_t i = 0; i < count; ++i) {
+            uint16_t v; std::memcpy(&v, src + 2 * i, 2);
+            v = __builtin_bswap16(v); std::memcpy(dst + 2 * i, &v, 2);
+        }
+        break;
+    case 4:
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t v; std::memcpy(&v, src + 4 * i, 4);
+            v = __builtin_bswap32(v); std::memcpy(dst + 4 * i, &v, 4);
+        }
+        break;
+    case 8:
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t v; std::memcpy(&v, src + 8 * i, 8);
+            v = __builtin_bswap64(v); std::memcpy(dst + 8 * i, &v, 8);
+        }
+        break;
+    default:
+        std::memcpy(dst, src, count * width);
+    }
+}
+
+#if defined(ARACOM_SER_X86)
+// Shuffle mask reversing each width-byte element of a 16-byte lane
+inline void SwapMask(uint8_t* m, size_t width) {
+    for (size_t i = 0; i < 16; ++i) m[i] = static_cast<uint8_t>((i / width) * width + (width - 1 - i % width));
+}
+
+__attribute__((target("ssse3")))
+inline void SwapCopySsse3(uint8_t* dst, const uint8_t* src, size_t count, size_t width) {
+    alignas(16) uint8_t m[16];
+    SwapMask(m, width);
+    const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(m));
+    const size_t bytes = count * width;
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, mask));
+    }
+    SwapCopyScalar(dst + i, src + i, (bytes - i) / width, width);
+}
+
+__attribute__((target("avx2")))
+inline void SwapCopyAvx2(uint8_t* dst, const uint8_t* src, size_t count, size_t width) {
+    alignas(32) uint8_t m[32];
+    SwapMask(m, width);
+    SwapMask(m + 16, width);
+    const __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(m));
+    const size_t bytes = count * width;
+    size_t i = 0;
+    for (; i + 64 <= bytes; i += 64) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 32), _mm256_shuffle_epi8(b, mask));
+    }
+    for (; i + 32 <= bytes; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(a, mask));
+    }
+    SwapCopyScalar(dst + i, src + i, (bytes - i) / width, width);
+}
+
+// 0 = scalar, 1 = SSSE3, 2 = AVX2 (detected once)
+inline int SimdLevel() {
+    static const int level = __builtin_cpu_supports("avx2") ? 2 :
+                             __builtin_cpu_supports("ssse3") ? 1 : 0;
+    return level;
+}
+#endif
+
+// Copy count elements of width bytes converting between host and network order
+inline void SwapCopy(void* dst, const void* src, size_t count, size_t width) {
+    auto* d = static_cast<uint8_t*>(dst);
+    auto* s = static_cast<const uint8_t*>(src);
+    if (width == 1 || !kLittleEndianHost) {
+        std::memcpy(d, s, count * width);
+        return;
+    }
+#if defined(ARACOM_SER_X86)
+    if (count * width >= 32) {
+        const int level = SimdLevel();
+        if (level == 2) { SwapCopyAvx2(d, s, count, width); return; }
+        if (level == 1) { SwapCopySsse3(d, s, count, width); return; }
+    }
+#endif
+    SwapCopyScalar(d, s, count, width);
+}
+
+template <typename T, typename = void>
+struct HasFields : std::false_type {};
+template <typename T>
+struct HasFields<T, decltype(std::declval<T&>().SomeipTie(), void())> : std::true_type {};
+
+} // namespace detail
+
+// Sequential writer into a buffer already sized with WireSize()
+class Writer {
+    uint8_t* p_;
+public:
+    explicit Writer(uint8_t* p) : p_(p) {}
+    void Put(const void* src, size_t count, size_t width) {
+        detail::SwapCopy(p_, src, count, width);
+        p_ += count * width;
+    }
+    void PutRaw(const void* src, size_t n) { std::memcpy(p_, src, n); p_ += n; }
+    uint8_t* Pos() const { return p_; }
+};
+
+// Bounds-checked sequential reader; once a read fails every later read fails too
+class Reader {
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool ok_{true};
+public:
+    Reader(const uint8_t* p, size_t n) : p_(p), end_(p + n) {}
+    bool Get(void* dst, size_t count, size_t width) {
+        if (!Need(count * width)) return false;
+        detail::SwapCopy(dst, p_, count, width);
+        p_ += count * width;
+        return true;
+    }
+    bool GetRaw(void* dst, size_t n) {
+        if (!Need(n)) return false;
+        std::memcpy(dst, p_, n);
+        p_ += n;
+        return true;
+    }
+    bool Skip(size_t n) { if (!Need(n)) return false; p_ += n; return true; }
+    bool Need(size_t n) {
+        if (!ok_ || static_cast<size_t>(end_ - p_) < n) ok_ = false;
+        return ok_;
+    }
+    const uint8_t* Pos() const { return p_; }
+    size_t Remaining() const { return static_cast<size_t>(end_ - p_); }
+    bool Ok() const { return ok_; }
+    void Fail() { ok_ = false; }
+};
+
+// Codec<T>: kFixedSize (0 = variable), Size(v), Write(w, v), Read(r, v)
+template <typename T, typename Enable = void>
+struct Codec;
+
+// Width of the bulk element swap usable for an array of T, 0 if none
+template <typename T, typename Enable = void>
+struct BulkWidth { static size_t Get() { return 0; } };
+
+// Integers, floats, bool, enums
+template <typename T>
+struct Codec<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type> {
+    static constexpr size_t kFixedSize = sizeof(T);
+    static size_t Size(const T&) { return sizeof(T); }
+    static void Write(Writer& w, const T& v) { w.Put(&v, 1, sizeof(T)); }
+    static bool Read(Reader& r, T& v) { return r.Get(&v, 1, sizeof(T)); }
+};
+
+template <typename T>
+struct BulkWidth<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type> {
+    static size_t Get() { return sizeof(T); }
+};
+
+namespace detail {
+
+template <typename Tuple, size_t... I>
+constexpr size_t TupleFixedSize(std::index_sequence<I...>) {
+    // Sum of member sizes, 0 as soon as one member is variable
+    size_t sizes[] = {Codec<typename std::decay<typename std::tuple_element<I, Tuple>::type>::type>::kFixedSize..., 0};
+    size_t total = 0;
+    for (size_t i = 0; i < sizeof...(I); ++i) {
+        if (sizes[i] == 0) return 0;
+        total += sizes[i];
+    }
+    return total;
+}
+
+template <typename Tuple, size_t... I>
+size_t TupleSize(const Tuple& t, std::index_sequence<I...>) {
+    size_t sizes[] = {Codec<typename std::decay<typename std::tuple_element<I, Tuple>::type>::type>::Size(std::get<I>(t))..., 0};
+    size_t total = 0;
+    for (size_t s : sizes) total += s;
+    return total;
+}
+
+template <typename Tuple, size_t... I>
+void TupleWrite(Writer& w, const Tuple& t, std::index_sequence<I...>) {
+    int dummy[] = {(Codec<typename std::decay<typename std::tuple_element<I, Tuple>::type>::type>::Write(w, std::get<I>(t)), 0)..., 0};
+    (void)dummy;
+}
+
+template <typename Tuple, size_t... I>
+bool TupleRead(Reader& r, Tuple& t, std::index_sequence<I...>) {
+    bool ok = true;
+    int dummy[] = {(ok = ok && Codec<typename std::decay<typename std::tuple_element<I, Tuple>::type>::type>::Read(r, std::get<I>(t)), 0)..., 0};
+    (void)dummy;
+    return ok;
+}
+
+// True if every member is arithmetic of the same width W and the members sit
+// back to back in declaration order (so the struct array can be swapped as W-wide words)
+template <typename T, typename Tuple, size_t... I>
+size_t UniformWidth(std::index_sequence<I...>) {
+    constexpr size_t widths[] = {(std::is_arithmetic<typename std::decay<typename std::tuple_element<I, Tuple>::type>::type>::value
+                                  ? sizeof(typename std::decay<typename std::tuple_element<I, Tuple>::type>::type) : 0)..., 0};
+    const size_t w = widths[0];
+    for (size_t i = 0; i < sizeof...(I); ++i) {
+        if (widths[i] == 0 || widths[i] != w) return 0;
+    }
+    if (sizeof(T) != w * sizeof...(I)) return 0;
+    T probe{};
+    auto tie = probe.SomeipTie();
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&probe);
+    const uint8_t* addrs[] = {reinterpret_cast<const uint8_t*>(&std::get<I>(tie))..., nullptr};
+    for (size_t i = 0; i < sizeof...(I); ++i) {
+        if (addrs[i] != base + i * w) return 0;
+    }
+    return w;
+}
+
+} // namespace detail
+
+// Structs declared with SOMEIP_FIELDS
+template <typename T>
+struct Codec<T, typename std::enable_if<detail::HasFields<T>::value>::type> {
+    using Tuple = decltype(std::declval<const T&>().SomeipTie());
+    using Index = std::make_index_sequence<std::tuple_size<Tuple>::value>;
+    static constexpr size_t kFixedSize = detail::TupleFixedSize<Tuple>(Index{});
+
+    static size_t Size(const T& v) {
+        return kFixedSize ? kFixedSize : detail::TupleSize(v.SomeipTie(), Index{});
+    }
+    static void Write(Writer& w, const T& v) { detail::TupleWrite(w, v.SomeipTie(), Index{}); }
+    static bool Read(Reader& r, T& v) {
+        auto t = v.SomeipTie();
+        return detail::TupleRead(r, t, Index{});
+    }
+};
+
+template <typename T>
+struct BulkWidth<T, typename std::enable_if<detail::HasFields<T>::value>::type> {
+    static size_t Get() {
+        using Tuple = decltype(std::declval<T&>().SomeipTie());
+        static const size_t w = detail::UniformWidth<T, Tuple>(std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+        return w;
+    }
+};
+
+namespace detail {
+
+template <typename T>
+size_t ElementsSize(const T* v, size_t n) {
+    if (Codec<T>::kFixedSize) return n * Codec<T>::kFixedSize;
+    size_t total = 0;
+    for (size_t i = 0; i < n; ++i) total += Codec<T>::Size(v[i]);
+    return total;
+}
+
+template <typename T>
+void WriteElements(Writer& w, const T* v, size_t n) {
+    const size_t width = BulkWidth<T>::Get();
+    if (width) {
+        w.Put(v, n * sizeof(T) / width, width);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) Codec<T>::Write(w, v[i]);
+}
+
+template <typename T>
+bool ReadElements(Reader& r, T* v, size_t n) {
+    const size_t width = BulkWidth<T>::Get();
+    if (width) return r.Get(v, n * sizeof(T) / width, width);
+    for (size_t i = 0; i < n; ++i) {
+        if (!Codec<T>::Read(r, v[i])) return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+// Fixed length arrays: no length field
+template <typename T, size_t N>
+struct Codec<std::array<T, N>> {
+    static constexpr size_t kFixedSize = Codec<T>::kFixedSize * N;
+    static size_t Size(const std::array<T, N>& v) { return detail::ElementsSize(v.data(), N); }
+    static void Write(Writer& w, const std::array<T, N>& v) { detail::WriteElements(w, v.data(), N); }
+    static bool Read(Reader& r, std::array<T, N>& v) { return detail::ReadElements(r, v.data(), N); }
+};
+
+// Dynamic arrays: uint32 length field in bytes
+template <typename T, typename A>
+struct Codec<std::vector<T, A>> {
+    static constexpr size_t kFixedSize = 0;
+    static size_t Size(const std::vector<T, A>& v) { return 4 + detail::ElementsSize(v.data(), v.size()); }
+    static void Write(Writer& w, const std::vector<T, A>& v) {
+        const uint32_t len = static_cast<uint32_t>(detail::ElementsSize(v.data(), v.size()));
+        Codec<uint32_t>::Write(w, len);
+        detail::WriteElements(w, v.data(), v.size());
+    }
+    // Decodes into v's existing storage; only grows it when more elements arrive
+    static bool Read(Reader& r, std::vector<T, A>& v) {
+        uint32_t len = 0;
+        if (!Codec<uint32_t>::Read(r, len) || !r.Need(len)) return false;
+        if (Codec<T>::kFixedSize) {
+            if (len % Codec<T>::kFixedSize) { r.Fail(); return false; }
+            v.resize(len / Codec<T>::kFixedSize);
+            return detail::ReadElements(r, v.data(), v.size());
+        }
+        Reader sub(r.Pos(), len);
+        size_t n = 0;
+        while (sub.Remaining() > 0) {
+            if (n == v.size()) v.emplace_back();
+            if (!Codec<T>::Read(sub, v[n++])) { r.Fail(); return false; }
+        }
+        v.resize(n);
+        return r.Skip(len);
+    }
+};
+
+// Strings: uint32 length field (bytes incl. BOM and terminator), UTF-8 BOM, chars, '\0'
+template <>
+struct Codec<std::string> {
+    static constexpr size_t kFixedSize = 0;
+    static const uint8_t* Bom() {
+        static const uint8_t bom[3] = {0xEF, 0xBB, 0xBF};
+        return bom;
+    }
+    static size_t Size(const std::string& s) { return 4 + 3 + s.size() + 1; }
+    static void Write(Writer& w, const std::string& s) {
+        Codec<uint32_t>::Write(w, static_cast<uint32_t>(3 + s.size() + 1));
+        w.PutRaw(Bom(), 3);
+        w.PutRaw(s.data(), s.size());
+        const uint8_t zero = 0;
+        w.PutRaw(&zero, 1);
+    }
+    static bool Read(Reader& r, std::string& s) {
+        uint32_t len = 0;
+        if (!Codec<uint32_t>::Read(r, len) || !r.Need(len)) return false;
+        const uint8_t* p = r.Pos();
+        size_t n = len;
+        if (n >= 3 && std::memcmp(p, Bom(), 3) == 0) { p += 3; n -= 3; }
+        if (n > 0 && p[n - 1] == 0) --n;
+        s.assign(reinterpret_cast<const char*>(p), n);
+        return r.Skip(len);
+    }
+};
+
+// Serialized size of v (constant for fixed layouts)
+template <typename T>
+size_t WireSize(const T& v) {
+    return Codec<T>::kFixedSize ? Codec<T>::kFixedSize : Codec<T>::Size(v);
+}
+
+// Compile-time wire size of T, 0 if it contains variable length members
+template <typename T>
+constexpr size_t FixedWireSize() { return Codec<T>::kFixedSize; }
+
+// Serialize into buf, reusing its capacity; returns the number of bytes written
+template <typename T>
+size_t EncodeInto(const T& v, std::vector<uint8_t>& buf) {
+    const size_t n = WireSize(v);
+    buf.resize(n);
+    Writer w(buf.data());
+    Codec<T>::Write(w, v);
+    return n;
+}
+
+// Serialize into a new Payload (the buffer is handed over, not copied)
+template <typename T>
+Payload Encode(const T& v) {
+    std::vector<uint8_t> buf;
+    EncodeInto(v, buf);
+    return Payload(std::move(buf));
+}
+
+// Raw payloads pass through untouched
+inline Payload Encode(Payload p) { return p; }
+
+// Deserialize into an existing object, reusing its storage; false on malformed input
+template <typename T>
+bool Decode(const uint8_t* data, size_t size, T& out) {
+    Reader r(data, size);
+    return Codec<T>::Read(r, out) && r.Ok();
+}
+
+template <typename T>
+bool Decode(const Payload& p, T& out) { return Decode(p.data(), p.size(), out); }
+
+inline bool Decode(const Payload& p, Payload& out) { out = p; return true; }
+
+} // namespace ser
+} // namespace com
+} // namespace ara
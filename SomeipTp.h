@@ -0,0 +1,272 @@
+// SomeipTp.h - Size-based UDP/TCP selection and SOME/IP-TP segmentation
+#pragma once
+#include "AraCom_Skeleton.h"
+#include <vsomeip/vsomeip.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * A message that fits one UDP datagram goes unreliable as is. A larger one is
+ * cut into SOME/IP-TP segments that each fit a datagram, up to maxTpMessage;
+ * anything larger goes over TCP.
+ *
+ * Segment layout (big endian):
+ *   [uint16 id][uint16 tag][uint32 message size][uint32 offset | more][data]
+ *   id: method/event the message belongs to; tag: message number of the sender
+ *   offset: byte position of data, a multiple of 16 as in SOME/IP-TP, whose
+ *   low 4 bits hold the more-segments flag (bit 0)
+ * All segments but the last carry a multiple of 16 bytes.
+ */
+
+namespace ara {
+namespace com {
+
+enum class SomeipRoute { kUdp, kTp, kTcp };
+
+inline const char* ToString(SomeipRoute r) {
+    return r == SomeipRoute::kUdp ? "udp" : r == SomeipRoute::kTp ? "udp-tp" : "tcp";
+}
+
+// Thresholds of one SOME/IP binding (set on skeleton and proxy alike)
+struct SomeipTransportConfig {
+    size_t maxUdpPayload{1400};      // largest payload sent in one datagram (vsomeip default)
+    size_t maxTpMessage{256 * 1024}; // up to here segmented over UDP, beyond over TCP (0 = never segment)
+    size_t reassemblySlots{4};       // messages reassembled at once, each in a preallocated buffer
+    std::chrono::milliseconds reassemblyTimeout{500}; // an incomplete message older than this is dropped
+
+    SomeipRoute Route(size_t size) const {
+        if (size <= maxUdpPayload) return SomeipRoute::kUdp;
+        return size <= maxTpMessage ? SomeipRoute::kTp : SomeipRoute::kTcp;
+    }
+};
+
+namespace tp {
+
+constexpr size_t kHeaderSize = 12;
+constexpr uint32_t kMore = 0x1;
+
+// Data bytes per segment so that header + data fit maxUdpPayload
+inline size_t SegmentData(size_t maxUdpPayload) {
+    const size_t room = maxUdpPayload > kHeaderSize + 16 ? maxUdpPayload - kHeaderSize : 16;
+    return room & ~size_t(15);
+}
+
+inline void Put16(uint8_t* p, uint16_t v) { p[0] = uint8_t(v >> 8); p[1] = uint8_t(v); }
+inline void Put32(uint8_t* p, uint32_t v) {
+    p[0] = uint8_t(v >> 24); p[1] = uint8_t(v >> 16); p[2] = uint8_t(v >> 8); p[3] = uint8_t(v);
+}
+inline uint16_t Get16(const uint8_t* p) { return uint16_t(p[0] << 8 | p[1]); }
+inline uint32_t Get32(const uint8_t* p) {
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+}
+
+struct Segment {
+    uint16_t id{0};
+    uint16_t tag{0};
+    uint32_t total{0};
+    uint32_t offset{0};
+    bool more{false};
+    const uint8_t* data{nullptr};
+    size_t size{0};
+};
+
+// False if p is not a well formed segment
+inline bool Parse(const uint8_t* p, size_t n, Segment& s) {
+    if (n < kHeaderSize) return false;
+    s.id = Get16(p);
+    s.tag = Get16(p + 2);
+    s.total = Get32(p + 4);
+    const uint32_t word = Get32(p + 8);
+    s.offset = word & ~uint32_t(15);
+    s.more = word & kMore;
+    s.data = p + kHeaderSize;
+    s.size = n - kHeaderSize;
+    if (s.total == 0 || s.offset > s.total || s.size > s.total - s.offset) return false;
+    if (s.more ? (s.size == 0 || s.size % 16) : s.offset + s.size != s.total) return false;
+    return true;
+}
+
+} // namespace tp
+
+// Cuts messages into segments (one per sender; thread safe)
+class TpSegmenter {
+public:
+    // Call emit(segment, size, last) for each segment of the size bytes at data
+    template <typename Emit>
+    size_t Segment(uint16_t id, const uint8_t* data, size_t size, size_t maxUdpPayload, Emit&& emit) {
+        const uint16_t tag = static_cast<uint16_t>(next_.fetch_add(1, std::memory_order_relaxed));
+        const size_t step = tp::SegmentData(maxUdpPayload);
+        static thread_local std::vector<uint8_t> seg;
+        seg.resize(tp::kHeaderSize + std::min(step, size));
+        size_t n = 0;
+        size_t off = 0;
+        do {
+            const size_t len = std::min(step, size - off);
+            const bool more = off + len < size;
+            tp::Put16(seg.data(), id);
+            tp::Put16(seg.data() + 2, tag);
+            tp::Put32(seg.data() + 4, static_cast<uint32_t>(size));
+            tp::Put32(seg.data() + 8, static_cast<uint32_t>(off) | (more ? tp::kMore : 0));
+            if (len) std::memcpy(seg.data() + tp::kHeaderSize, data + off, len);
+            emit(seg.data(), tp::kHeaderSize + len, !more);
+            off += len;
+            ++n;
+        } while (off < size);
+        segments_.fetch_add(n, std::memory_order_relaxed);
+        return n;
+    }
+
+    // The size bytes at data as one segment (a message sent over TCP)
+    std::vector<uint8_t> Whole(uint16_t id, const uint8_t* data, size_t size) {
+        const uint16_t tag = static_cast<uint16_t>(next_.fetch_add(1, std::memory_order_relaxed));
+        std::vector<uint8_t> out(tp::kHeaderSize + size);
+        tp::Put16(out.data(), id);
+        tp::Put16(out.data() + 2, tag);
+        tp::Put32(out.data() + 4, static_cast<uint32_t>(size));
+        tp::Put32(out.data() + 8, 0);
+        if (size) std::memcpy(out.data() + tp::kHeaderSize, data, size);
+        return out;
+    }
+
+    uint64_t SegmentsSent() const { return segments_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> next_{0};
+    std::atomic<uint64_t> segments_{0};
+};
+
+// Counters of a TpReassembler (monotonic)
+struct TpStats {
+    uint64_t segments{0};  // accepted segments
+    uint64_t messages{0};  // messages completed
+    uint64_t dropped{0};   // incomplete messages given up (timeout, slot needed, malformed, too large)
+    uint64_t allocated{0}; // slot buffers replaced because a caller still held the previous message
+};
+
+// Puts segmented messages back together. Each slot owns a buffer of
+// maxTpMessage bytes allocated up front; a completed message is handed out
+// as a view of it, and the slot takes a fresh buffer only if the caller
+// still holds the previous message when the slot is reused. Segments may
+// arrive out of order or twice; 16-byte blocks already received are tracked.
+class TpReassembler {
+public:
+    TpReassembler(const SomeipTransportConfig& cfg)
+        : slotBytes_(std::max<size_t>(cfg.maxTpMessage, 16)), timeout_(cfg.reassemblyTimeout),
+          slots_(std::max<size_t>(cfg.reassemblySlots, 1)) {
+        for (Slot& s : slots_) {
+            s.buf = std::make_shared<std::vector<uint8_t>>(slotBytes_);
+            s.blocks.resize(slotBytes_ / 16 + 1);
+        }
+    }
+
+    // Add a segment sent by sender in msg. True once it completes its message:
+    // out then holds the message, last the vsomeip message of its last segment
+    // (the one a request's response must be created from).
+    bool Add(uint16_t sender, const tp::Segment& seg, const std::shared_ptr<vsomeip::message>& msg,
+             Payload& out, std::shared_ptr<vsomeip::message>& last) {
+        const auto now = Clock::now();
+        const uint64_t key = uint64_t(sender) << 32 | uint64_t(seg.id) << 16 | seg.tag;
+        std::lock_guard<std::mutex> lk(mu_);
+        // Larger messages are sent over TCP: total comes from the wire, so a
+        // segment claiming more is dropped before anything is allocated for it
+        if (seg.total > slotBytes_) {
+            ++stats_.dropped;
+            return false;
+        }
+        Slot* s = Find(key, seg.total, now);
+        if (!s) return false;
+        ++stats_.segments;
+
+        const size_t first = seg.offset / 16;
+        const size_t end = (seg.offset + seg.size + 15) / 16;
+        size_t fresh = 0;
+        for (size_t b = first; b < end; ++b) {
+            if (!s->blocks[b]) {
+                s->blocks[b] = true;
+                ++fresh;
+            }
+        }
+        if (!fresh) return false; // duplicate
+        std::memcpy(s->buf->data() + seg.offset, seg.data, seg.size);
+        s->covered += fresh;
+        if (!seg.more) s->last = msg;
+        if (s->covered < (s->total + 15) / 16) return false;
+
+        out = Payload(s->buf, s->buf->data(), s->total);
+        last = std::move(s->last);
+        s->busy = false;
+        ++stats_.messages;
+        return true;
+    }
+
+    TpStats Stats() const {
+        std::lock_guard<std::mutex> lk(mu_);
+        return stats_;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Slot {
+        bool busy{false};
+        uint64_t key{0};
+        size_t total{0};
+        size_t covered{0}; // blocks received
+        Clock::time_point started;
+        std::shared_ptr<std::vector<uint8_t>> buf;
+        std::vector<bool> blocks; // 16-byte blocks received
+        std::shared_ptr<vsomeip::message> last;
+    };
+
+    // Slot collecting key, claiming one for a new message (caller holds mu_,
+    // total fits a slot buffer)
+    Slot* Find(uint64_t key, size_t total, Clock::time_point now) {
+        Slot* claim = nullptr;
+        for (Slot& s : slots_) {
+            if (s.busy && now - s.started > timeout_) Drop(s);
+            if (s.busy && s.key == key) {
+                if (s.total == total) return &s;
+                Drop(s); // same tag reused for another message: the old one is lost
+            }
+            if (!s.busy && !claim) claim = &s;
+        }
+        if (!claim) {
+            // All slots collect other messages: give up the oldest
+            claim = &*std::min_element(slots_.begin(), slots_.end(),
+                                       [](const Slot& a, const Slot& b) { return a.started < b.started; });
+            Drop(*claim);
+        }
+        if (claim->buf.use_count() > 1) {
+            claim->buf = std::make_shared<std::vector<uint8_t>>(slotBytes_);
+            ++stats_.allocated;
+        }
+        std::fill(claim->blocks.begin(), claim->blocks.begin() + (total + 15) / 16, false);
+        claim->busy = true;
+        claim->key = key;
+        claim->total = total;
+        claim->covered = 0;
+        claim->started = now;
+        return claim;
+    }
+
+    void Drop(Slot& s) {
+        s.busy = false;
+        s.last.reset();
+        ++stats_.dropped;
+    }
+
+    const size_t slotBytes_;
+    const std::chrono::milliseconds timeout_;
+    mutable std::mutex mu_;
+    std::vector<Slot> slots_;
+    TpStats stats_;
+};
+
+} // namespace com
+} // namespace ara
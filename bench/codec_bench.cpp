@@ -0,0 +1,171 @@
+// codec_bench.cpp - Bytes on the wire vs CPU of the event payload codec
+//
+// Encodes and decodes a stream of serialized point clouds in which a given
+// share of the points changes from one frame to the next, once per codec
+// mode. Prints one CSV row per case:
+//   points,changed_pct,frame_bytes,mode,wire_bytes,ratio,enc_ns,dec_ns,enc_mbps,dec_mbps
+// (wire_bytes, enc_ns and dec_ns are per frame; ratio = frame_bytes / wire_bytes)
+// The "+shaped" modes publish to two subscribers, one of them with
+// EventPolicy::EveryNth(4), and count the bytes sent to both.
+#include "PayloadCodec.h"
+#include "RadarService.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace ara::com;
+
+namespace {
+
+constexpr size_t kFrames = 64;
+
+// kFrames serialized frames of a cloud where changedPct % of the points move
+std::vector<std::vector<uint8_t>> MakeFrames(size_t points, unsigned changedPct) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(-50.f, 50.f);
+    std::normal_distribution<float> jitter(0.f, 0.02f);
+    radar::PointCloud c;
+    for (size_t i = 0; i < points; ++i) {
+        c.xyz.push_back(pos(rng)); c.xyz.push_back(pos(rng)); c.xyz.push_back(pos(rng) * 0.05f);
+        c.intensity.push_back(static_cast<uint16_t>(rng() % 4096));
+    }
+    std::vector<std::vector<uint8_t>> frames(kFrames);
+    for (size_t f = 0; f < kFrames; ++f) {
+        c.frameId = static_cast<uint32_t>(f);
+        c.timestampNs = 1000000000ull + f * 50000000ull;
+        for (size_t i = 0; i < points; ++i) {
+            if (rng() % 100 >= changedPct) continue;
+            for (size_t k = 0; k < 3; ++k) c.xyz[3 * i + k] += jitter(rng);
+            c.intensity[i] = static_cast<uint16_t>(c.intensity[i] + rng() % 64);
+        }
+        ser::EncodeInto(c, frames[f]);
+    }
+    return frames;
+}
+
+static volatile size_t g_sink;
+
+void Run(size_t points, unsigned changedPct, const char* mode, const CodecConfig& cfg) {
+    using Clock = std::chrono::steady_clock;
+    const auto frames = MakeFrames(points, changedPct);
+    std::vector<std::vector<uint8_t>> wire(kFrames);
+
+    // Repeat the stream until it has run ~200 ms; the last pass is kept for decoding
+    size_t passes = 0;
+    double encNs = 0;
+    do {
+        FrameEncoder enc(cfg);
+        const auto t0 = Clock::now();
+        for (size_t f = 0; f < kFrames; ++f) wire[f] = enc.Encode(frames[f].data(), frames[f].size());
+        encNs += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        ++passes;
+    } while (encNs < 2e8);
+    encNs /= passes * kFrames;
+
+    size_t decPasses = 0;
+    double decNs = 0;
+    bool same = true;
+    do {
+        FrameDecoder dec;
+        Payload out;
+        const auto t0 = Clock::now();
+        for (size_t f = 0; f < kFrames; ++f) {
+            same &= dec.Decode(wire[f].data(), wire[f].size(), out);
+            g_sink = out.size();
+        }
+        decNs += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        same &= std::equal(out.begin(), out.end(), frames.back().begin(), frames.back().end());
+        ++decPasses;
+    } while (decNs < 2e8);
+    decNs /= decPasses * kFrames;
+    if (!same) std::fprintf(stderr, "[bench] %s: decoded frames differ\n", mode);
+
+    size_t raw = 0, sent = 0;
+    for (size_t f = 0; f < kFrames; ++f) {
+        raw += frames[f].size();
+        sent += wire[f].size();
+    }
+    const double frameBytes = double(raw) / kFrames;
+    const double wireBytes = double(sent) / kFrames;
+    std::printf("%zu,%u,%.0f,%s,%.0f,%.2f,%.0f,%.0f,%.0f,%.0f\n", points, changedPct, frameBytes, mode, wireBytes,
+                frameBytes / wireBytes, encNs, decNs, frameBytes * 1e3 / encNs, frameBytes * 1e3 / decNs);
+}
+
+// Two subscribers of a shaped event: one gets every frame, one every kNth.
+// ownStream codes the second one's frames as a delta stream of its own, as
+// the skeleton does; otherwise every frame is a keyframe, which is all a
+// single stream shared by subscribers that skip different frames allows.
+void RunShaped(size_t points, unsigned changedPct, const char* mode, bool ownStream) {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t kNth = 4;
+    const CodecConfig cfg{true, true, 32};
+    const auto frames = MakeFrames(points, changedPct);
+    std::vector<std::vector<uint8_t>> wire(kFrames), wireNth(kFrames / kNth);
+
+    size_t passes = 0;
+    double encNs = 0;
+    do {
+        FrameEncoder all(cfg), nth(cfg);
+        const auto t0 = Clock::now();
+        for (size_t f = 0; f < kFrames; ++f) {
+            if (!ownStream) all.Reset();
+            wire[f] = all.Encode(frames[f].data(), frames[f].size());
+            if (f % kNth == 0) wireNth[f / kNth] = ownStream ? nth.Encode(frames[f].data(), frames[f].size()) : wire[f];
+        }
+        encNs += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        ++passes;
+    } while (encNs < 2e8);
+    encNs /= passes * kFrames;
+
+    size_t decPasses = 0;
+    double decNs = 0;
+    bool same = true;
+    do {
+        FrameDecoder all, nth;
+        Payload out, outNth;
+        const auto t0 = Clock::now();
+        for (size_t f = 0; f < kFrames; ++f) {
+            same &= all.Decode(wire[f].data(), wire[f].size(), out);
+            if (f % kNth == 0) same &= nth.Decode(wireNth[f / kNth].data(), wireNth[f / kNth].size(), outNth);
+        }
+        decNs += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        same &= std::equal(out.begin(), out.end(), frames.back().begin(), frames.back().end());
+        same &= std::equal(outNth.begin(), outNth.end(), frames[kFrames - kNth].begin(), frames[kFrames - kNth].end());
+        ++decPasses;
+    } while (decNs < 2e8);
+    decNs /= decPasses * kFrames;
+    if (!same) std::fprintf(stderr, "[bench] %s: decoded frames differ\n", mode);
+
+    size_t raw = 0, sent = 0;
+    for (size_t f = 0; f < kFrames; ++f) {
+        raw += frames[f].size();
+        sent += wire[f].size();
+    }
+    for (const auto& w : wireNth) sent += w.size();
+    const double frameBytes = double(raw) / kFrames;
+    const double wireBytes = double(sent) / kFrames;
+    std::printf("%zu,%u,%.0f,%s,%.0f,%.2f,%.0f,%.0f,%.0f,%.0f\n", points, changedPct, frameBytes, mode, wireBytes,
+                frameBytes / wireBytes, encNs, decNs, frameBytes * 1e3 / encNs, frameBytes * 1e3 / decNs);
+}
+
+} // namespace
+
+int main() {
+#if defined(ARACOM_SER_X86)
+    const int level = ser::detail::SimdLevel();
+    std::fprintf(stderr, "[bench] xor/match: %s\n", level == 2 ? "AVX2" : level == 1 ? "SSE2" : "scalar");
+#endif
+    std::printf("points,changed_pct,frame_bytes,mode,wire_bytes,ratio,enc_ns,dec_ns,enc_mbps,dec_mbps\n");
+    for (size_t points : {256u, 4096u, 65536u}) {
+        for (unsigned changed : {5u, 50u}) {
+            Run(points, changed, "raw", CodecConfig{false, false, 0});
+            Run(points, changed, "lz", CodecConfig{false, true, 0});
+            Run(points, changed, "xor", CodecConfig{true, false, 32});
+            Run(points, changed, "xor+lz", CodecConfig{true, true, 32});
+            RunShaped(points, changed, "keyframes+shaped", false);
+            RunShaped(points, changed, "xor+lz+shaped", true);
+        }
+    }
+    return 0;
+}
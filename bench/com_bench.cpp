@@ -0,0 +1,387 @@
+// com_bench.cpp - Method round-trip latency and event throughput of the ara::com bindings
+//
+// Forks a server process (app "RadarService", the routing manager in
+// vsomeip.json) and runs the client ("RadarClient") in the parent, so both
+// sides talk over the 127.0.0.1 setup exactly like the demo. For every
+// payload size it measures:
+//   - MethodCall -> SendResponse round trip of sequential calls (percentiles)
+//   - SendEvent throughput: one burst of notifications, timed at the proxy
+//     (notifications the binding dropped show up as received < --events)
+//
+// Usage: bench [--transport someip|shm] [--format csv|json] [--sizes 16,64,...]
+//              [--calls N] [--events N] [--route auto|tp|tcp] [--out FILE]
+//
+// --route picks how SOME/IP sends payloads larger than one datagram: the
+// default thresholds (auto), SOME/IP-TP segments over UDP for every size
+// given (tp) or TCP (tcp). Multi-megabyte runs, e.g.
+//   bench --sizes 1048576,4194304 --calls 20 --events 50 --route tp
+//
+// CSV columns:
+//   test,transport,payload_bytes,samples,p50_us,p90_us,p99_us,p999_us,max_us,events_per_sec,mbytes_per_sec
+#include "ComFactory.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ara;
+
+namespace bench {
+
+// Ask the server for count notifications of size bytes, tagged with burst
+struct BurstRequest {
+    uint32_t burst{0};
+    uint32_t size{0};
+    uint32_t count{0};
+    SOMEIP_FIELDS(burst, size, count)
+};
+
+using Echo  = com::MethodDesc<0x42>;
+using Burst = com::MethodDesc<0x43, BurstRequest>;
+using Notification = com::EventDesc<0x8002>;
+
+// Same service/instance as the radar demo, so vsomeip.json needs no changes
+using BenchService = com::ServiceDesc<0x1234, 0x5678,
+    com::MethodList<Echo, Burst>,
+    com::EventList<Notification>>;
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    com::Transport transport{com::Transport::kSomeip};
+    bool json{false};
+    std::vector<size_t> sizes{16, 64, 256, 1024, 4096};
+    size_t calls{2000};
+    size_t events{20000};
+    std::string route{"auto"};
+    std::string out;
+};
+
+struct LatencyRow {
+    size_t bytes{0};
+    size_t samples{0};
+    double p50{0}, p90{0}, p99{0}, p999{0}, max{0}; // microseconds
+};
+
+struct EventRow {
+    size_t bytes{0};
+    size_t received{0};
+    double perSec{0};
+    double mbPerSec{0};
+};
+
+inline double Percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    const size_t i = std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()));
+    return sorted[i];
+}
+
+inline void PutTag(std::vector<uint8_t>& buf, uint32_t tag) {
+    std::memcpy(buf.data(), &tag, sizeof(tag));
+}
+
+inline uint32_t GetTag(const com::Payload& p) {
+    uint32_t tag = 0;
+    if (p.size() >= sizeof(tag)) std::memcpy(&tag, p.data(), sizeof(tag));
+    return tag;
+}
+
+// SOME/IP thresholds for --route (both sides use the same)
+inline com::SomeipTransportConfig RouteConfig(const Options& opt) {
+    com::SomeipTransportConfig cfg;
+    if (opt.route == "tp") {
+        for (size_t s : opt.sizes) cfg.maxTpMessage = std::max(cfg.maxTpMessage, s);
+        cfg.reassemblySlots = 2;
+    } else if (opt.route == "tcp") {
+        cfg.maxTpMessage = 0;
+    }
+    return cfg;
+}
+
+// ---------------- Server process ----------------
+
+int RunServer(const Options& opt) {
+    const com::Transport transport = opt.transport;
+    std::unique_ptr<com::Skeleton> skeleton;
+    skeleton = com::MakeSkeleton<BenchService>(transport, "RadarService",
+        [&](const com::Message& msg) {
+            if (msg.method == Echo::kId) {
+                skeleton->SendResponse(com::Message{msg.method, msg.payload, msg.request});
+                return;
+            }
+            BurstRequest req;
+            if (!com::ser::Decode(msg.payload, req)) return;
+            std::vector<uint8_t> data(std::max<size_t>(req.size, 4));
+            PutTag(data, req.burst);
+            for (uint32_t i = 0; i < req.count; ++i) {
+                skeleton->SendEvent(Notification::kId, com::Payload(data));
+            }
+            skeleton->SendResponse(com::Message{msg.method, com::Payload(), msg.request});
+        });
+    if (transport == com::Transport::kSomeip) {
+        static_cast<com::SomeipSkeleton<BenchService>&>(*skeleton).SetTransport(RouteConfig(opt));
+    }
+    skeleton->OfferService();
+    while (true) pause(); // terminated by the client
+}
+
+// ---------------- Client process ----------------
+
+class Client {
+public:
+    Client(const Options& opt) : opt_(opt) {
+        proxy_ = com::MakeProxy<BenchService>(opt.transport, "RadarClient");
+        if (opt.transport == com::Transport::kSomeip) {
+            static_cast<com::SomeipProxy<BenchService>&>(*proxy_).SetTransport(RouteConfig(opt));
+        }
+        proxy_->FindService(BenchService::kInstanceId);
+        proxy_->SubscribeEvent(Notification::kId, [this](const com::Payload& p) { OnEvent(p); });
+    }
+
+    // Retry a call until the service answers; false after timeout
+    bool WaitAvailable(std::chrono::seconds timeout) {
+        const auto deadline = Clock::now() + timeout;
+        while (Clock::now() < deadline) {
+            auto h = proxy_->MethodCall(Echo::kId, com::Payload(std::vector<uint8_t>(4)),
+                                        std::chrono::milliseconds(200));
+            try {
+                h.Get();
+                return true;
+            } catch (const com::CallError&) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+        }
+        return false;
+    }
+
+    // Event subscription is asynchronous: probe with one-event bursts until one arrives
+    bool WaitSubscribed(std::chrono::seconds timeout) {
+        const auto deadline = Clock::now() + timeout;
+        while (Clock::now() < deadline) {
+            if (RunBurst(16, 1, std::chrono::milliseconds(200)).received == 1) return true;
+        }
+        return false;
+    }
+
+    LatencyRow MeasureLatency(size_t bytes) {
+        std::vector<uint8_t> data(bytes);
+        for (size_t i = 0; i < std::min<size_t>(opt_.calls / 10, 200); ++i) Call(data); // warm up
+        std::vector<double> us;
+        us.reserve(opt_.calls);
+        for (size_t i = 0; i < opt_.calls; ++i) {
+            const auto t0 = Clock::now();
+            if (!Call(data)) continue;
+            us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+        std::sort(us.begin(), us.end());
+        LatencyRow r;
+        r.bytes = bytes;
+        r.samples = us.size();
+        r.p50 = Percentile(us, 0.50);
+        r.p90 = Percentile(us, 0.90);
+        r.p99 = Percentile(us, 0.99);
+        r.p999 = Percentile(us, 0.999);
+        r.max = us.empty() ? 0 : us.back();
+        return r;
+    }
+
+    EventRow MeasureEvents(size_t bytes) {
+        return RunBurst(bytes, opt_.events, std::chrono::seconds(10));
+    }
+
+private:
+    bool Call(const std::vector<uint8_t>& data) {
+        auto h = proxy_->MethodCall(Echo::kId, com::Payload(data), std::chrono::milliseconds(1000));
+        try {
+            h.Get();
+            return true;
+        } catch (const com::CallError& e) {
+            std::cerr << "[Bench] Call failed: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    EventRow RunBurst(size_t bytes, size_t count, Clock::duration timeout) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            ++burst_;
+            received_ = 0;
+            expected_ = count;
+        }
+        BurstRequest req;
+        req.burst = burst_;
+        req.size = static_cast<uint32_t>(bytes);
+        req.count = static_cast<uint32_t>(count);
+
+        const auto t0 = Clock::now();
+        auto done = proxy_->MethodCall(Burst::kId, com::ser::Encode(req),
+                                       std::chrono::duration_cast<std::chrono::milliseconds>(timeout));
+        done.WaitFor(timeout); // the server answers once it has sent the whole burst
+        // A binding may drop notifications under overload: stop once they stop coming
+        std::unique_lock<std::mutex> lk(mu_);
+        size_t seen = received_;
+        while (!cv_.wait_for(lk, std::chrono::milliseconds(100), [&] { return received_ >= expected_; }) &&
+               received_ != seen) {
+            seen = received_;
+        }
+        const double secs = std::chrono::duration<double>((received_ ? last_ : Clock::now()) - t0).count();
+
+        EventRow r;
+        r.bytes = bytes;
+        r.received = received_;
+        r.perSec = secs > 0 ? received_ / secs : 0;
+        r.mbPerSec = r.perSec * bytes / 1e6;
+        ++burst_; // late notifications of this burst are ignored
+        return r;
+    }
+
+    void OnEvent(const com::Payload& p) {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (GetTag(p) != burst_) return;
+        last_ = Clock::now();
+        if (++received_ == expected_) cv_.notify_all();
+    }
+
+    const Options& opt_;
+    std::unique_ptr<com::Proxy> proxy_;
+    std::mutex mu_;
+    std::condition_variable cv_;
+    uint32_t burst_{0};
+    size_t received_{0};
+    size_t expected_{0};
+    Clock::time_point last_;
+};
+
+// ---------------- Output ----------------
+
+// "someip", or "someip:tp" / "someip:tcp" when --route forces a route
+inline std::string TransportLabel(const Options& opt) {
+    std::string t = com::ToString(opt.transport);
+    if (opt.transport == com::Transport::kSomeip && opt.route != "auto") t += ":" + opt.route;
+    return t;
+}
+
+void WriteCsv(std::ostream& os, const Options& opt, const std::vector<LatencyRow>& lat,
+              const std::vector<EventRow>& ev) {
+    const std::string label = TransportLabel(opt);
+    const char* t = label.c_str();
+    os << "test,transport,payload_bytes,samples,p50_us,p90_us,p99_us,p999_us,max_us,events_per_sec,mbytes_per_sec\n";
+    char line[256];
+    for (const auto& r : lat) {
+        std::snprintf(line, sizeof(line), "method_rtt,%s,%zu,%zu,%.2f,%.2f,%.2f,%.2f,%.2f,,\n",
+                      t, r.bytes, r.samples, r.p50, r.p90, r.p99, r.p999, r.max);
+        os << line;
+    }
+    for (const auto& r : ev) {
+        std::snprintf(line, sizeof(line), "event_throughput,%s,%zu,%zu,,,,,,%.0f,%.2f\n",
+                      t, r.bytes, r.received, r.perSec, r.mbPerSec);
+        os << line;
+    }
+}
+
+void WriteJson(std::ostream& os, const Options& opt, const std::vector<LatencyRow>& lat,
+               const std::vector<EventRow>& ev) {
+    char line[256];
+    os << "{\n  \"transport\": \"" << TransportLabel(opt) << "\",\n  \"method_rtt\": [\n";
+    for (size_t i = 0; i < lat.size(); ++i) {
+        const auto& r = lat[i];
+        std::snprintf(line, sizeof(line),
+                      "    {\"payload_bytes\": %zu, \"samples\": %zu, \"p50_us\": %.2f, \"p90_us\": %.2f, "
+                      "\"p99_us\": %.2f, \"p999_us\": %.2f, \"max_us\": %.2f}%s\n",
+                      r.bytes, r.samples, r.p50, r.p90, r.p99, r.p999, r.max, i + 1 < lat.size() ? "," : "");
+        os << line;
+    }
+    os << "  ],\n  \"event_throughput\": [\n";
+    for (size_t i = 0; i < ev.size(); ++i) {
+        const auto& r = ev[i];
+        std::snprintf(line, sizeof(line),
+                      "    {\"payload_bytes\": %zu, \"received\": %zu, \"events_per_sec\": %.0f, "
+                      "\"mbytes_per_sec\": %.2f}%s\n",
+                      r.bytes, r.received, r.perSec, r.mbPerSec, i + 1 < ev.size() ? "," : "");
+        os << line;
+    }
+    os << "  ]\n}\n";
+}
+
+bool ParseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (a == "--transport" && v) { opt.transport = com::ParseTransport(v); ++i; }
+        else if (a == "--format" && v) { opt.json = std::string(v) == "json"; ++i; }
+        else if (a == "--calls" && v) { opt.calls = std::strtoul(v, nullptr, 10); ++i; }
+        else if (a == "--events" && v) { opt.events = std::strtoul(v, nullptr, 10); ++i; }
+        else if (a == "--out" && v) { opt.out = v; ++i; }
+        else if (a == "--route" && v && (std::string(v) == "auto" || std::string(v) == "tp" ||
+                                         std::string(v) == "tcp")) { opt.route = v; ++i; }
+        else if (a == "--sizes" && v) {
+            opt.sizes.clear();
+            std::stringstream ss(v);
+            std::string item;
+            while (std::getline(ss, item, ',')) opt.sizes.push_back(std::strtoul(item.c_str(), nullptr, 10));
+            ++i;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--transport someip|shm] [--format csv|json]"
+                      << " [--sizes 16,64,...] [--calls N] [--events N] [--route auto|tp|tcp] [--out FILE]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace bench
+
+int main(int argc, char** argv) {
+    using namespace bench;
+    Options opt;
+    if (!ParseArgs(argc, argv, opt)) return 2;
+
+#ifdef BENCH_VSOMEIP_CONFIG
+    setenv("VSOMEIP_CONFIGURATION", BENCH_VSOMEIP_CONFIG, 0); // keep a caller-provided config
+#endif
+
+    const pid_t server = fork();
+    if (server < 0) {
+        std::perror("fork");
+        return 1;
+    }
+    if (server == 0) return RunServer(opt);
+
+    std::vector<LatencyRow> lat;
+    std::vector<EventRow> ev;
+    int rc = 0;
+    {
+        Client client(opt);
+        if (!client.WaitAvailable(std::chrono::seconds(10)) || !client.WaitSubscribed(std::chrono::seconds(10))) {
+            std::cerr << "[Bench] Service not available" << std::endl;
+            rc = 1;
+        } else {
+            for (size_t s : opt.sizes) {
+                lat.push_back(client.MeasureLatency(s));
+                ev.push_back(client.MeasureEvents(std::max<size_t>(s, 4)));
+            }
+        }
+    }
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+    if (rc) return rc;
+
+    std::ofstream file;
+    if (!opt.out.empty()) file.open(opt.out);
+    std::ostream& os = opt.out.empty() ? std::cout : file;
+    if (opt.json) WriteJson(os, opt, lat, ev);
+    else WriteCsv(os, opt, lat, ev);
+    return 0;
+}
@@ -0,0 +1,139 @@
+// serializer_bench.cpp - SomeipSerializer vs a naive per-field serializer
+//
+// Prints one CSV row per case:
+//   case,elements,bytes,naive_enc_ns,ser_enc_ns,naive_dec_ns,ser_dec_ns,enc_speedup,dec_speedup
+#include "RadarService.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+using namespace ara::com;
+
+namespace naive {
+
+// Typical hand-written code: one push_back per byte, fresh vectors on decode
+inline void PutU16(std::vector<uint8_t>& b, uint16_t v) { b.push_back(v >> 8); b.push_back(v & 0xFF); }
+inline void PutU32(std::vector<uint8_t>& b, uint32_t v) {
+    b.push_back(v >> 24); b.push_back((v >> 16) & 0xFF); b.push_back((v >> 8) & 0xFF); b.push_back(v & 0xFF);
+}
+inline void PutU64(std::vector<uint8_t>& b, uint64_t v) { PutU32(b, uint32_t(v >> 32)); PutU32(b, uint32_t(v)); }
+inline void PutF32(std::vector<uint8_t>& b, float f) { uint32_t v; std::memcpy(&v, &f, 4); PutU32(b, v); }
+
+inline uint16_t GetU16(const uint8_t*& p) { uint16_t v = uint16_t(p[0] << 8 | p[1]); p += 2; return v; }
+inline uint32_t GetU32(const uint8_t*& p) {
+    uint32_t v = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3]; p += 4; return v;
+}
+inline uint64_t GetU64(const uint8_t*& p) { uint64_t h = GetU32(p); return h << 32 | GetU32(p); }
+inline float GetF32(const uint8_t*& p) { uint32_t v = GetU32(p); float f; std::memcpy(&f, &v, 4); return f; }
+
+std::vector<uint8_t> Encode(const radar::DetectionList& d) {
+    std::vector<uint8_t> b;
+    PutU32(b, d.frameId);
+    PutU64(b, d.timestampNs);
+    PutU32(b, uint32_t(d.detections.size() * 20));
+    for (const auto& x : d.detections) {
+        PutF32(b, x.range); PutF32(b, x.azimuth); PutF32(b, x.elevation); PutF32(b, x.velocity); PutF32(b, x.snr);
+    }
+    return b;
+}
+
+radar::DetectionList DecodeDetections(const std::vector<uint8_t>& b) {
+    radar::DetectionList d;
+    const uint8_t* p = b.data();
+    d.frameId = GetU32(p);
+    d.timestampNs = GetU64(p);
+    const uint32_t n = GetU32(p) / 20;
+    for (uint32_t i = 0; i < n; ++i) {
+        radar::Detection x;
+        x.range = GetF32(p); x.azimuth = GetF32(p); x.elevation = GetF32(p); x.velocity = GetF32(p); x.snr = GetF32(p);
+        d.detections.push_back(x);
+    }
+    return d;
+}
+
+std::vector<uint8_t> Encode(const radar::PointCloud& c) {
+    std::vector<uint8_t> b;
+    PutU32(b, c.frameId);
+    PutU64(b, c.timestampNs);
+    PutU32(b, uint32_t(c.xyz.size() * 4));
+    for (float f : c.xyz) PutF32(b, f);
+    PutU32(b, uint32_t(c.intensity.size() * 2));
+    for (uint16_t v : c.intensity) PutU16(b, v);
+    return b;
+}
+
+radar::PointCloud DecodeCloud(const std::vector<uint8_t>& b) {
+    radar::PointCloud c;
+    const uint8_t* p = b.data();
+    c.frameId = GetU32(p);
+    c.timestampNs = GetU64(p);
+    uint32_t n = GetU32(p) / 4;
+    for (uint32_t i = 0; i < n; ++i) c.xyz.push_back(GetF32(p));
+    n = GetU32(p) / 2;
+    for (uint32_t i = 0; i < n; ++i) c.intensity.push_back(GetU16(p));
+    return c;
+}
+
+} // namespace naive
+
+// Average ns per call of fn over enough iterations to run ~200 ms
+static double TimeNs(const std::function<void()>& fn) {
+    using Clock = std::chrono::steady_clock;
+    size_t iters = 1;
+    for (;;) {
+        const auto t0 = Clock::now();
+        for (size_t i = 0; i < iters; ++i) fn();
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        if (ns > 2e8 || iters > (1u << 26)) return ns / iters;
+        iters *= 2;
+    }
+}
+
+static volatile size_t g_sink;
+
+template <typename T, typename NaiveEnc, typename NaiveDec>
+static void Run(const char* name, size_t elements, const T& value, NaiveEnc nenc, NaiveDec ndec) {
+    std::vector<uint8_t> buf;
+    T out;
+    const auto ref = nenc(value);
+    ser::EncodeInto(value, buf);
+    if (buf != ref) std::fprintf(stderr, "[bench] %s: encodings differ\n", name);
+
+    const double nEnc = TimeNs([&] { g_sink = nenc(value).size(); });
+    const double sEnc = TimeNs([&] { g_sink = ser::EncodeInto(value, buf); });
+    const double nDec = TimeNs([&] { g_sink = ndec(ref).frameId; });
+    const double sDec = TimeNs([&] { g_sink = ser::Decode(ref.data(), ref.size(), out); });
+    std::printf("%s,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%.2f,%.2f\n", name, elements, ref.size(),
+                nEnc, sEnc, nDec, sDec, nEnc / sEnc, nDec / sDec);
+}
+
+int main() {
+#if defined(ARACOM_SER_X86)
+    const int level = ser::detail::SimdLevel();
+    std::fprintf(stderr, "[bench] byte swap: %s\n", level == 2 ? "AVX2" : level == 1 ? "SSSE3" : "scalar");
+#endif
+    std::printf("case,elements,bytes,naive_enc_ns,ser_enc_ns,naive_dec_ns,ser_dec_ns,enc_speedup,dec_speedup\n");
+    for (size_t n : {16u, 128u, 1024u, 8192u}) {
+        radar::DetectionList d;
+        d.frameId = 42;
+        d.timestampNs = 123456789;
+        for (size_t i = 0; i < n; ++i) {
+            d.detections.push_back({float(i), 0.1f * i, -0.05f, 12.5f, 20.f});
+        }
+        Run("detections", n, d, [](const radar::DetectionList& v) { return naive::Encode(v); },
+            [](const std::vector<uint8_t>& b) { return naive::DecodeDetections(b); });
+    }
+    for (size_t n : {1024u, 16384u, 262144u}) {
+        radar::PointCloud c;
+        c.frameId = 7;
+        for (size_t i = 0; i < n; ++i) {
+            c.xyz.push_back(float(i)); c.xyz.push_back(-float(i)); c.xyz.push_back(0.5f);
+            c.intensity.push_back(uint16_t(i));
+        }
+        Run("pointcloud", n, c, [](const radar::PointCloud& v) { return naive::Encode(v); },
+            [](const std::vector<uint8_t>& b) { return naive::DecodeCloud(b); });
+    }
+    return 0;
+}
@@ -1,34 +1,13 @@
-#include "SomeipBinding.h"
+#include "ComFactory.h"
+#include "RadarService.h"
 #include "AraExec.h"      // ara::exec::ApplicationClient (client does not auto-restart)
+#include "ManifestCompiler.h" // ara::manifest::LoadManifest (image, JSON fallback)
 #include <iostream>
 #include <thread>
-#include <fstream>
 #include <cstdlib>
 
-#include <nlohmann/json.hpp>
-using json = nlohmann::json;
-
 using namespace ara;
 
-// Lightweight manifest reader for hint (not required for client)
-struct ManifestView {
-    std::string appName     = "RadarServiceApp";
-    std::string defaultMode = "NormalMode";
-};
-
-static ManifestView LoadManifestLite(const std::string& path) {
-    ManifestView v;
-    try {
-        std::ifstream f(path);
-        if (!f) return v;
-        json j; f >> j;
-        auto& m = j.at("applicationManifest");
-        if (m.contains("name"))        v.appName     = m["name"].get<std::string>();
-        if (m.contains("defaultMode")) v.defaultMode = m["defaultMode"].get<std::string>();
-    } catch (...) { /* optional */ }
-    return v;
-}
-
 static std::string pick_manifest_path(int argc, char** argv) {
     if (argc > 1) return argv[1];
     if (const char* p = std::getenv("RADAR_MANIFEST")) return std::string(p);
@@ -38,40 +17,89 @@ static std::string pick_manifest_path(int argc, char** argv) {
 int main(int argc, char** argv) {
     // Print manifest hint (optional)
     const std::string manifestPath = pick_manifest_path(argc, argv);
-    ManifestView mv = LoadManifestLite(manifestPath);
-    std::cout << "[Client] Service manifest hint: name=" << mv.appName
-              << ", defaultMode=" << mv.defaultMode << "\n";
+    const manifest::Manifest mv = manifest::LoadManifest(manifestPath);
+    if (mv.Valid()) {
+        std::cout << "[Client] Service manifest hint: name=" << mv.AppName()
+                  << ", defaultMode=" << mv.DefaultMode() << " (" << mv.Source() << ")\n";
+    }
 
     // Register client with Execution API (no auto-restart)
     exec::ApplicationClient appCli("RadarClient", false);
     appCli.RegisterApplication();
     appCli.Start();
 
-    // SOME/IP proxy: find & call service
-    com::SomeipProxy proxy("RadarClient");
-    proxy.FindService(RADAR_INSTANCE_ID);
+    // Proxy over the transport the manifest configures for the radar service: find & call service
+    const com::Transport transport = com::TransportFor<radar::RadarService>(com::BindingsFromManifest(mv));
+    std::cout << "[Client] Radar service transport: " << com::ToString(transport) << "\n";
+    std::unique_ptr<com::Proxy> proxy = com::MakeProxy<radar::RadarService>(transport, "RadarClient");
+    proxy->FindService(radar::RadarService::kInstanceId);
 
-    proxy.RegisterResponseHandler(CALIBRATE_METHOD_ID, [](const std::vector<uint8_t>& data) {
+    proxy->RegisterResponseHandler(radar::Calibrate::kId, [](const com::Payload& data) {
         std::string resp(data.begin(), data.end());
         std::cout << "[Client] Received response: " << resp << std::endl;
     });
 
-    // Send a normal request
+    // Pipeline a batch of normal requests and wait for all replies together
     std::thread t1([&] {
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-        std::string req = "Config_X";
-        proxy.MethodCall(CALIBRATE_METHOD_ID, std::vector<uint8_t>(req.begin(), req.end()));
-    });
+        // Calls made earlier would be queued until the service is offered; waiting
+        // here keeps their timeouts from running during server startup
+        if (!proxy->WaitAvailable(std::chrono::seconds(10))) {
+            std::cerr << "[Client] Radar service not available after 10s" << std::endl;
+            return;
+        }
+        std::vector<com::CallHandle> calls;
+        for (const char* cfg : {"Config_X", "Config_Y", "Config_Z"}) {
+            std::string req = cfg;
+            calls.push_back(proxy->MethodCall(radar::Calibrate::kId,
+                std::vector<uint8_t>(req.begin(), req.end()), std::chrono::milliseconds(1000)));
+        }
+        for (auto& c : calls) {
+            try {
+                com::Message m = c.Get();
+                std::cout << "[Client] Response for call 0x" << std::hex << c.Token() << std::dec << ": "
+                          << std::string(m.payload.begin(), m.payload.end()) << std::endl;
+            } catch (const com::CallError& e) {
+                std::cerr << "[Client] Call 0x" << std::hex << c.Token() << std::dec
+                          << " failed: " << e.what() << std::endl;
+            }
+        }
+
+        // Server metrics snapshot: the server only answers it in DiagnosticMode,
+        // so switch there at runtime and back afterwards
+        auto call = [&](com::MethodId id, const std::string& req, const char* what) {
+            auto c = proxy->MethodCall(id, std::vector<uint8_t>(req.begin(), req.end()), std::chrono::milliseconds(1000));
+            try {
+                com::Message m = c.Get();
+                std::cout << "[Client] " << what << ": " << std::string(m.payload.begin(), m.payload.end()) << std::endl;
+            } catch (const com::CallError& e) {
+                std::cerr << "[Client] " << what << " failed: " << e.what() << std::endl;
+            }
+        };
+        call(radar::SwitchMode::kId, "DiagnosticMode", "SwitchMode");
+        call(radar::GetMetrics::kId, "", "Server metrics");
+        call(radar::SwitchMode::kId, "NormalMode", "SwitchMode");
 
-    // After 5s, send a request that causes server crash to see EM restart
-    std::thread t2([&] {
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-        std::string req = "CrashMe";
-        proxy.MethodCall(CALIBRATE_METHOD_ID, std::vector<uint8_t>(req.begin(), req.end()));
+        // Crash the server to see EM restart it. The next call is either lost
+        // with the old server (failed as unavailable, so retried) or queued
+        // until the restarted server offers the service again.
+        std::string crash = "CrashMe";
+        proxy->MethodCall(radar::Calibrate::kId, std::vector<uint8_t>(crash.begin(), crash.end()));
+        const std::string req = "Config_After_Restart";
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            auto c = proxy->MethodCall(radar::Calibrate::kId, std::vector<uint8_t>(req.begin(), req.end()),
+                                       std::chrono::seconds(10));
+            try {
+                com::Message m = c.Get();
+                std::cout << "[Client] After restart: " << std::string(m.payload.begin(), m.payload.end()) << std::endl;
+                break;
+            } catch (const com::CallError& e) {
+                std::cerr << "[Client] Call after crash failed: " << e.what() << std::endl;
+                if (e.Status() != com::CallStatus::kUnavailable) break;
+            }
+        }
     });
 
     t1.join();
-    t2.join();
 
     // Keep client alive to observe server re-offer after restart
     while (true) std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -0,0 +1,120 @@
+// coro_client.cpp - Radar client written with coroutines (AraCoro.h, C++20)
+//
+// The request flows of client.cpp as straight-line coroutines on a two-thread
+// executor: calibrate -> verify -> commit, the diagnostic metrics round trip,
+// and a burst of concurrent logical requests that share those two threads.
+#include "ComFactory.h"
+#include "RadarService.h"
+#include "AraCoro.h"
+#include "AraExec.h"          // ara::exec::ApplicationClient (client does not auto-restart)
+#include "ManifestCompiler.h" // ara::manifest::LoadManifest (image, JSON fallback)
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace ara;
+using namespace std::chrono_literals;
+
+static std::string pick_manifest_path(int argc, char** argv) {
+    if (argc > 1) return argv[1];
+    if (const char* p = std::getenv("RADAR_MANIFEST")) return std::string(p);
+    return "./manifest.json";
+}
+
+static com::Payload Bytes(const std::string& s) { return std::vector<uint8_t>(s.begin(), s.end()); }
+static std::string Text(const com::Payload& p) { return std::string(p.begin(), p.end()); }
+
+// Calibrate with cfg, check the reply, then repeat the call as the commit
+// step; a call lost with a restarting server is retried once
+static com::coro::Task<std::string> CalibrateAndCommit(com::Proxy& proxy, std::string cfg) {
+    for (int attempt = 0;; ++attempt) {
+        try {
+            com::Message r = co_await com::coro::Call(proxy, radar::Calibrate::kId, Bytes(cfg), 1s);
+            if (Text(r.payload).rfind("Calibrated OK", 0) != 0) co_return "rejected: " + Text(r.payload);
+            r = co_await com::coro::Call(proxy, radar::Calibrate::kId, Bytes(cfg + ":commit"), 1s);
+            co_return Text(r.payload);
+        } catch (const com::CallError& e) {
+            if (e.Status() != com::CallStatus::kUnavailable || attempt > 0) throw;
+        }
+    }
+}
+
+// Server metrics are only answered in DiagnosticMode: switch there, read, switch back
+static com::coro::Task<std::string> DiagnosticMetrics(com::Proxy& proxy) {
+    com::Payload r = co_await com::coro::Call<radar::SwitchMode>(proxy, Bytes("DiagnosticMode"), 1s);
+    std::cout << "[Client] SwitchMode: " << Text(r) << std::endl;
+    com::Payload metrics = co_await com::coro::Call<radar::GetMetrics>(proxy, com::Payload(), 1s);
+    r = co_await com::coro::Call<radar::SwitchMode>(proxy, Bytes("NormalMode"), 1s);
+    std::cout << "[Client] SwitchMode: " << Text(r) << std::endl;
+    co_return Text(metrics);
+}
+
+// n calibrate/commit flows in flight at once; returns how many succeeded.
+// Each flow reports through a stream, so waiting for them holds no thread.
+static com::coro::Task<int> Burst(com::Executor& exec, com::Proxy& proxy, int n) {
+    com::coro::EventStream<int> results(n);
+    for (int i = 0; i < n; ++i) {
+        com::coro::Spawn(exec, [](com::Proxy& p, std::string cfg, com::coro::EventStream<int>& out) -> com::coro::Task<void> {
+            int ok = 0;
+            try {
+                ok = (co_await CalibrateAndCommit(p, cfg)).rfind("Calibrated OK", 0) == 0;
+            } catch (const com::CallError&) {
+            }
+            out.Push(ok);
+        }(proxy, "Config_" + std::to_string(i % 16), results));
+    }
+    int ok = 0;
+    for (int i = 0; i < n; ++i) ok += *co_await results.Next();
+    co_return ok;
+}
+
+static com::coro::Task<void> Run(com::Executor& exec, com::Proxy& proxy) {
+    for (const char* cfg : {"Config_X", "Config_Y", "Config_Z"}) {
+        try {
+            std::cout << "[Client] " << cfg << ": " << co_await CalibrateAndCommit(proxy, cfg) << std::endl;
+        } catch (const com::CallError& e) {
+            std::cerr << "[Client] " << cfg << " failed: " << e.what() << std::endl;
+        }
+    }
+    try {
+        std::cout << "[Client] Server metrics: " << co_await DiagnosticMetrics(proxy) << std::endl;
+    } catch (const com::CallError& e) {
+        std::cerr << "[Client] Server metrics failed: " << e.what() << std::endl;
+    }
+
+    constexpr int kFlows = 1000;
+    const uint64_t heap = com::coro::FramePool::HeapAllocations();
+    const auto t0 = std::chrono::steady_clock::now();
+    const int ok = co_await Burst(exec, proxy, kFlows);
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0);
+    std::cout << "[Client] " << ok << "/" << kFlows << " concurrent flows done in " << ms.count() << "ms on "
+              << exec.Threads() << " threads, " << com::coro::FramePool::HeapAllocations() - heap
+              << " coroutine frames from the heap" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const std::string manifestPath = pick_manifest_path(argc, argv);
+    const manifest::Manifest mv = manifest::LoadManifest(manifestPath);
+
+    exec::ApplicationClient appCli("RadarCoroClient", false);
+    appCli.RegisterApplication();
+    appCli.Start();
+
+    const com::Transport transport = com::TransportFor<radar::RadarService>(com::BindingsFromManifest(mv));
+    std::cout << "[Client] Radar service transport: " << com::ToString(transport) << "\n";
+    std::unique_ptr<com::Proxy> proxy = com::MakeProxy<radar::RadarService>(transport, "RadarCoroClient");
+    proxy->FindService(radar::RadarService::kInstanceId);
+    if (!proxy->WaitAvailable(10s)) {
+        std::cerr << "[Client] Radar service not available after 10s" << std::endl;
+        return 1;
+    }
+
+    com::Executor exec(2);
+    com::coro::SyncWait(exec, Run(exec, *proxy));
+    std::cout << "[Client] Proxy metrics: " << proxy->MetricsSnapshot() << std::endl;
+
+    // The binding's vsomeip application keeps running on its own thread (client.cpp
+    // never returns for the same reason): leave without destroying the proxy
+    proxy->StopFindService(radar::RadarService::kInstanceId);
+    std::quick_exit(0);
+}
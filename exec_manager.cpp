@@ -0,0 +1,115 @@
+#include "ProcessSupervisor.h" // posix_spawn + pidfd/epoll supervision of the executables
+#include "ExecManager.h"       // policy/dependency ordering/state listeners
+#include "AraLog.h"            // ARA_LOG_*: asynchronous logging
+#include "ManifestCompiler.h"  // ara::manifest::LoadManifest: mmap'ed image, JSON fallback
+#include "ManifestWatcher.h"   // hot reload of manifest changes
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <signal.h>
+
+using namespace ara::execm;
+
+//---------------- Manifest: executables to launch ----------------//
+struct ExecutableCfg {
+    AppConfig app;
+    ProcessSpec spec;
+};
+
+// Every executable with a "path" is launched; restartPolicy/maxRestarts may
+// be set per executable and default to the application-level values
+static std::vector<ExecutableCfg> ExecutablesOf(const ara::manifest::Manifest& m) {
+    std::vector<ExecutableCfg> out;
+    for (uint32_t i = 0; i < m.NumExecutables(); ++i) {
+        const ara::manifest::Executable exe = m.Exe(i);
+        if (!*exe.Path()) continue;
+        ExecutableCfg e;
+        e.app.appId       = exe.Name();
+        e.app.policy      = ParsePolicy(exe.RestartPolicy());
+        e.app.maxRestarts = exe.MaxRestarts();
+        for (uint32_t d = 0; d < exe.NumDependsOn(); ++d) e.app.dependsOn.push_back(exe.DependsOn(d));
+        e.spec.path = exe.Path();
+        for (uint32_t a = 0; a < exe.NumArgs(); ++a) e.spec.args.push_back(exe.Arg(a));
+        out.push_back(std::move(e));
+    }
+    return out;
+}
+
+static std::vector<ExecutableCfg> LoadExecutables(const std::string& path) {
+    const ara::manifest::Manifest m = ara::manifest::LoadManifest(path);
+    if (!m.Valid()) {
+        ARA_LOG_ERROR("[Manifest] Cannot load {}", path);
+        return {};
+    }
+    std::vector<ExecutableCfg> out = ExecutablesOf(m);
+    ARA_LOG_INFO("[Manifest] {} executables from {} ({})", out.size(), path, m.Source());
+    return out;
+}
+
+// Apply a reloaded manifest to the running system: changed policies/limits/
+// modes/dependencies and paths take effect in place (for the next exit or
+// spawn), removed executables are stopped, new ones are started in dependency
+// order. Executables whose config did not change are not touched.
+static void ApplyExecutables(const std::vector<ExecutableCfg>& next) {
+    auto& em = ExecManager::Instance();
+    auto& sup = ProcessSupervisor::Instance();
+    std::vector<AppConfig> desired;
+    for (const auto& e : next) desired.push_back(e.app);
+    const ConfigDiff diff = em.Reconfigure(desired, /*retireMissing*/ true);
+
+    for (const auto& e : next) {
+        const bool added = std::find(diff.added.begin(), diff.added.end(), e.app.appId) != diff.added.end();
+        if (added) sup.Supervise(e.app, e.spec);
+        else sup.Update(e.app, e.spec);
+    }
+    if (!diff.added.empty()) LogTimeline(em.StartGroup(diff.added));
+    ARA_LOG_INFO("[ExecMgr] Manifest applied: {} added, {} removed, {} updated",
+                 diff.added.size(), diff.removed.size(), diff.updated.size());
+}
+
+//---------------- Execution manager main ----------------//
+int main(int argc, char** argv) {
+    std::string manifestPath = "./manifest.json";
+    if (argc > 1) manifestPath = argv[1];
+    else if (const char* p = std::getenv("RADAR_MANIFEST")) manifestPath = p;
+
+    // Block the stop signals before any thread exists so only sigwait sees them
+    // (children get a clean signal mask from posix_spawn)
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    auto executables = LoadExecutables(manifestPath);
+    if (executables.empty()) {
+        ARA_LOG_ERROR("[ExecMgr] No executables with a \"path\" in {}", manifestPath);
+        return 1;
+    }
+
+    auto& em = ExecManager::Instance();
+    em.Subscribe([](const std::string& id, AppState st) {
+        ARA_LOG_INFO("[ExecMgr][Event] {} -> {}", id, ToString(st));
+    });
+    for (const auto& e : executables) ProcessSupervisor::Instance().Supervise(e.app, e.spec);
+
+    LogTimeline(em.StartAll());
+
+    {
+        // Edits of the manifest (or a recompiled image) are applied live
+        ara::manifest::ManifestWatcher watcher(manifestPath, [&](const ara::manifest::Manifest& m) {
+            auto next = ExecutablesOf(m);
+            ApplyExecutables(next);
+            executables = std::move(next);
+        });
+
+        int sig = 0;
+        sigwait(&stopSignals, &sig);
+        ARA_LOG_INFO("[ExecMgr] Signal {}, stopping executables", sig);
+    } // watcher joined: executables is no longer written
+    for (auto it = executables.rbegin(); it != executables.rend(); ++it) em.Stop(it->app.appId);
+    em.Flush();
+    return 0;
+}
@@ -1,16 +1,16 @@
-#include "SomeipBinding.h"   // Proxy/Skeleton SOME/IP
+#include "ComFactory.h"      // Proxy/Skeleton bindings (SOME/IP, shared memory)
+#include "RadarService.h"    // Radar service interface (IDs, methods, events)
 #include "AraExec.h"         // ara::exec::ApplicationClient (đã chuẩn hoá)
 #include "ExecManager.h"     // ExecManager mô phỏng: policy/mode/restart
+#include "AraLog.h"          // ARA_LOG_*: asynchronous logging
+#include "ManifestCompiler.h" // ara::manifest::LoadManifest (mmap'ed image, JSON fallback)
+#include "ManifestWatcher.h"  // hot reload of manifest changes
+#include "ModeDispatcher.h"   // per-mode handler tables, lock-free mode switch
 
-#include <iostream>
 #include <thread>
-#include <fstream>
 #include <cstdlib>
 #include <vector>
 
-#include <nlohmann/json.hpp>
-using json = nlohmann::json;
-
 using namespace ara;
 
 //---------------- Manifest model & loader ----------------//
@@ -21,6 +21,8 @@ struct ManifestCfg {
     std::string restartPolicy = "on-failure";   // always | on-failure | no
     int         maxRestarts   = -1;             // -1 = unlimited (demo)
     std::vector<std::string> modes{"NormalMode","DiagnosticMode"};
+    std::vector<std::string> dependsOn;         // executables that must be running first
+    std::vector<com::ServiceBinding> bindings;  // transport per service (default someip)
 };
     // NEW: Check if APP_MODE is in modes; if not, warn & fallback
     static std::string ValidateMode(const std::string& requested,
@@ -34,44 +36,57 @@ struct ManifestCfg {
         for (const auto& m : modes) {
             if (m == requested) return requested;
         }
-        std::cerr << "[Manifest][WARN] APP_MODE=\"" << requested
-                << "\" is not in applicationModeDeclarations. "
-                << "Fallback to defaultMode=\"" << fallback << "\"\n";
+        ARA_LOG_WARN("[Manifest][WARN] APP_MODE=\"{}\" is not in applicationModeDeclarations. "
+                     "Fallback to defaultMode=\"{}\"", requested, fallback);
         return fallback;
     }
-static ManifestCfg LoadManifest(const std::string& path) {
+// Fill the defaults above from the shared manifest (compiled image, or the
+// JSON validated in memory). The executable is the one exec_manager launched
+// (ARA_APP_ID), else the first one.
+static ManifestCfg ConfigFrom(const manifest::Manifest& m) {
     ManifestCfg cfg;
-    try {
-        std::ifstream f(path);
-        if (!f) {
-            std::cerr << "[Manifest] Cannot open file: " << path
-                      << " (using default values)\n";
-            return cfg;
-        }
-        json j; f >> j;
-        auto& m = j.at("applicationManifest");
-        if (m.contains("name")) cfg.appName = m["name"].get<std::string>();
-        if (m.contains("executables") && m["executables"].is_array() && !m["executables"].empty()) {
-            const auto& exe = m["executables"][0];
-            if (exe.contains("name")) cfg.exeName = exe["name"].get<std::string>();
-        }
-        if (m.contains("defaultMode"))    cfg.defaultMode   = m["defaultMode"].get<std::string>();
-        if (m.contains("restartPolicy"))  cfg.restartPolicy = m["restartPolicy"].get<std::string>();
-        if (m.contains("maxRestarts"))    cfg.maxRestarts   = m["maxRestarts"].get<int>();
-
-        if (m.contains("applicationModeDeclarations") && m["applicationModeDeclarations"].is_array()) {
-            cfg.modes.clear();
-            for (const auto& item : m["applicationModeDeclarations"]) {
-                if (item.contains("name") && item["name"].is_string()) {
-                    cfg.modes.push_back(item["name"].get<std::string>());
-                }
-            }
-            if (cfg.modes.empty()) cfg.modes = {"NormalMode","DiagnosticMode"};
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "[Manifest] Parse error: " << e.what()
-                  << " (using default values)\n";
+    cfg.appName       = m.AppName();
+    cfg.defaultMode   = m.DefaultMode();
+    cfg.restartPolicy = m.RestartPolicy();
+    cfg.maxRestarts   = m.MaxRestarts();
+    if (m.NumModes() > 0) {
+        cfg.modes.clear();
+        for (uint32_t i = 0; i < m.NumModes(); ++i) cfg.modes.push_back(m.Mode(i));
+    }
+    int idx = m.NumExecutables() > 0 ? 0 : -1;
+    if (const char* id = std::getenv("ARA_APP_ID")) {
+        const int found = m.FindExecutable(id);
+        if (found >= 0) idx = found;
     }
+    if (idx >= 0) {
+        const manifest::Executable exe = m.Exe(static_cast<uint32_t>(idx));
+        cfg.exeName       = exe.Name();
+        cfg.restartPolicy = exe.RestartPolicy();
+        cfg.maxRestarts   = exe.MaxRestarts();
+        for (uint32_t i = 0; i < exe.NumDependsOn(); ++i) cfg.dependsOn.push_back(exe.DependsOn(i));
+    }
+    cfg.bindings = com::BindingsFromManifest(m);
+    return cfg;
+}
+
+static ManifestCfg LoadManifest(const std::string& path) {
+    const manifest::Manifest m = manifest::LoadManifest(path);
+    if (!m.Valid()) {
+        ARA_LOG_ERROR("[Manifest] Cannot load {} (using default values)", path);
+        return ManifestCfg();
+    }
+    ARA_LOG_DEBUG("[Manifest] Loaded {} from {}", path, m.Source());
+    return ConfigFrom(m);
+}
+
+static execm::AppConfig AppConfigOf(const ManifestCfg& manifest) {
+    execm::AppConfig cfg;
+    cfg.appId       = manifest.exeName;                            // "RadarService"
+    cfg.policy      = execm::ParsePolicy(manifest.restartPolicy);  // always / on-failure / no
+    cfg.maxRestarts = manifest.maxRestarts;                        // -1 = unlimited
+    cfg.defaultMode = manifest.defaultMode;
+    cfg.modes       = manifest.modes;
+    cfg.dependsOn   = manifest.dependsOn;
     return cfg;
 }
 
@@ -99,20 +114,14 @@ int main(int argc, char** argv) {
 
     appCli.RegisterApplication();
     appCli.SetStopHandler([] {
-        std::cout << "[RadarService] Cleanup before stop...\n";
+        ARA_LOG_INFO("[RadarService] Cleanup before stop...");
     });
 
     // 4) Register with ExecManager (policy/mode/restart)
     using ara::execm::ExecManager;
     using ara::execm::AppConfig;
-    using ara::execm::ParsePolicy;
 
-    AppConfig cfg;
-    cfg.appId       = manifest.exeName;                     // "RadarService"
-    cfg.policy      = ParsePolicy(manifest.restartPolicy);  // always / on-failure / no
-    cfg.maxRestarts = manifest.maxRestarts;                 // -1 = unlimited
-    cfg.defaultMode = manifest.defaultMode;
-    cfg.modes       = manifest.modes;
+    const AppConfig cfg = AppConfigOf(manifest);
 
     auto& em = ExecManager::Instance();
 
@@ -121,58 +130,120 @@ int main(int argc, char** argv) {
         /*stopFn*/  [&](){ appCli.Stop();  }     // EM calls Stop  → delegate to ApplicationClient
     );
 
+    // Method handlers per application mode; the skeleton dispatches through
+    // the table of the active mode, which SetMode/SwitchMode swap at runtime
+    std::unique_ptr<com::Skeleton> skeleton;
+    auto reply = [&](const com::Message& req, const std::string& resp) {
+        skeleton->SendResponse(com::Message{req.method, std::vector<uint8_t>(resp.begin(), resp.end()), req.request});
+    };
+    auto calibrate = [&](const com::Message& msg) {
+        std::string cfgStr(msg.payload.begin(), msg.payload.end());
+        ARA_LOG_INFO("[Server] Calibrate called with: {} (mode=NormalMode)", cfgStr);
+        // Intentional error for testing → report crash to ExecManager (EM will decide restart/terminate)
+        if (cfgStr == "CrashMe") throw std::runtime_error("Simulated crash in RadarService");
+        reply(msg, "Calibrated OK: " + cfgStr);
+    };
+    com::ModeDispatcher modes;
+    modes.AddMode("NormalMode", com::HandlerTable()
+        .On(radar::Calibrate::kId, calibrate)
+        .On(radar::GetMetrics::kId, [&](const com::Message& msg) {
+            reply(msg, "ERROR: GetMetrics is only available in DiagnosticMode");
+        }));
+    modes.AddMode("DiagnosticMode", com::HandlerTable()
+        // Diagnostic: read-only, calibration disabled (unless testing crash)
+        .On(radar::Calibrate::kId, [&](const com::Message& msg) {
+            std::string cfgStr(msg.payload.begin(), msg.payload.end());
+            ARA_LOG_INFO("[Server] Calibrate called with: {} (mode=DiagnosticMode)", cfgStr);
+            if (cfgStr == "CrashMe") throw std::runtime_error("Simulated crash in RadarService");
+            reply(msg, "DIAG-ONLY: Calibration disabled in DiagnosticMode");
+        })
+        // Latency/size histograms per method and event of this binding, and of mode switches
+        .On(radar::GetMetrics::kId, [&](const com::Message& msg) {
+            reply(msg, "{\"binding\":" + skeleton->MetricsSnapshot() + ",\"modeSwitch\":" + modes.SwitchJson() + "}");
+        }));
+    for (const auto& m : manifest.modes) {
+        if (!modes.HasMode(m)) ARA_LOG_WARN("[Server][WARN] Mode {} is declared but has no handler table", m);
+    }
+
+    em.SubscribeMode([&](const std::string& id, const std::string& mode) {
+        if (id != cfg.appId || mode == modes.ActiveMode()) return;
+        const std::string prev = modes.ActiveMode();
+        const com::ModeSwitchResult r = modes.Switch(mode);
+        if (!r.ok) return;
+        // Cached responses were computed by the previous mode's handlers
+        if (skeleton) skeleton->InvalidateResponses();
+        ARA_LOG_INFO("[Server] Mode {} -> {}: published in {}ns, previous mode drained in {}us{}",
+                     prev, mode, static_cast<int64_t>(r.publish.count()),
+                     static_cast<int64_t>(r.total.count() / 1000), r.drained ? "" : " (deadline hit)");
+    });
+
     // Validate & set mode (fallback if APP_MODE is invalid)
     em.SetMode(cfg.appId, requestedMode);
     const std::string activeMode = em.GetMode(cfg.appId);
-    const bool isDiagnostic = (activeMode == "DiagnosticMode");
 
     // Subscribe to state events (compact log)
     em.Subscribe([](const std::string& id, ara::execm::AppState st){
-        std::cout << "[ExecMgr][Event] " << id << " -> " << ara::execm::ToString(st) << "\n";
+        ARA_LOG_INFO("[ExecMgr][Event] {} -> {}", id, ara::execm::ToString(st));
     });
 
-    std::cout << "[Manifest] name="   << manifest.appName
-              << ", exe="             << manifest.exeName
-              << ", defaultMode="     << manifest.defaultMode
-              << ", activeMode="      << activeMode
-              << ", restartPolicy="   << manifest.restartPolicy
-              << ", maxRestarts="     << manifest.maxRestarts << "\n";
+    ARA_LOG_INFO("[Manifest] name={}, exe={}, defaultMode={}, activeMode={}, restartPolicy={}, maxRestarts={}",
+                 manifest.appName, manifest.exeName, manifest.defaultMode, activeMode,
+                 manifest.restartPolicy, manifest.maxRestarts);
 
-    // 5) Start by ExecManager
-    em.Start(cfg.appId);
+    // 5) Start by ExecManager (dependency order, independent apps in parallel)
+    ara::execm::LogTimeline(em.StartAll());
 
-    // 6) SOME/IP service (offer & handle)
-    com::SomeipSkeleton skeleton(manifest.exeName,
+    // 6) Radar service over the transport configured in the manifest (offer & handle)
+    const com::Transport transport = com::TransportFor<radar::RadarService>(manifest.bindings);
+    ARA_LOG_INFO("[Server] Radar service transport: {}", com::ToString(transport));
+    skeleton = com::MakeSkeleton<radar::RadarService>(transport, manifest.exeName,
         [&](const com::Message& msg) {
             try {
-                std::string cfgStr(msg.payload.begin(), msg.payload.end());
-                std::cout << "[Server] Calibrate called with: " << cfgStr
-                          << " (mode=" << activeMode << ")\n";
-
-                // Diagnostic: read-only, calibration disabled (unless testing crash)
-                if (isDiagnostic && cfgStr != "CrashMe") {
-                    std::string resp = "DIAG-ONLY: Calibration disabled in DiagnosticMode";
-                    com::Message m{msg.method, std::vector<uint8_t>(resp.begin(), resp.end())};
-                    skeleton.SendResponse(m);
+                // Mode transitions are mode-independent and handled outside the tables
+                // (a switch waits for in-flight dispatches and must not wait for itself)
+                if (msg.method == radar::SwitchMode::kId) {
+                    const std::string requested(msg.payload.begin(), msg.payload.end());
+                    const auto t0 = std::chrono::steady_clock::now();
+                    if (!modes.HasMode(requested) || !em.SwitchMode(cfg.appId, requested)) {
+                        reply(msg, "ERROR: unknown mode " + requested + ", staying in " + modes.ActiveMode());
+                        return;
+                    }
+                    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - t0).count();
+                    reply(msg, "OK: mode " + modes.ActiveMode() + " (switched in " + std::to_string(us) + "us)");
                     return;
                 }
-
-                // Intentional error for testing → report crash to ExecManager (EM will decide restart/terminate)
-                if (cfgStr == "CrashMe") {
-                    throw std::runtime_error("Simulated crash in RadarService");
-                }
-
-                // Normal: handle calibration
-                std::string resp = "Calibrated OK: " + cfgStr;
-                com::Message m{msg.method, std::vector<uint8_t>(resp.begin(), resp.end())};
-                skeleton.SendResponse(m);
+                modes.Dispatch(msg);
             } catch (...) {
+                // Supervised: die for real, the supervisor respawns the process
+                if (exec::ApplicationClient::Supervised()) appCli.Crash();
                 ExecManager::Instance().OnCrash(manifest.exeName);
             }
         });
 
-    skeleton.OfferService();
+    // Calibrate stands in for a slow call to the sensor, which takes one calibration at a time:
+    // run it off the receive thread so it does not stall other traffic, one at a time and in
+    // arrival order; callers beyond 64 queued get an error
+    skeleton->SetConcurrency(radar::Calibrate::kId, com::MethodConcurrency::Serialized(64));
+    // The reply depends only on the config string and the mode: repeated calls are answered
+    // from the response cache, which a mode switch clears
+    skeleton->SetIdempotent(radar::Calibrate::kId);
+    skeleton->OfferService();
+
+    // 7) Hot reload: restart policy/limit and mode declarations of this app are
+    // replaced in place when the manifest changes; the service keeps running
+    manifest::ManifestWatcher watcher(manifestPath, [&](const manifest::Manifest& m) {
+        const ManifestCfg next = ConfigFrom(m);
+        if (next.exeName != cfg.appId) {
+            ARA_LOG_WARN("[Manifest][WARN] {} is no longer in the manifest, ignoring the reload", cfg.appId);
+            return;
+        }
+        const auto diff = em.Reconfigure({AppConfigOf(next)});
+        if (diff.updated.empty()) return;
+        ARA_LOG_INFO("[Manifest] {}: restartPolicy={}, maxRestarts={}, {} modes, activeMode={}",
+                     cfg.appId, next.restartPolicy, next.maxRestarts, next.modes.size(), em.GetMode(cfg.appId));
+    });
 
-    // 7) Keep process alive
+    // 8) Keep process alive
     while (true) std::this_thread::sleep_for(std::chrono::seconds(1));
 }
@@ -0,0 +1,125 @@
+// log_decode - Print a binary log written with ARA_LOG_FILE as text
+//
+//   log_decode <file> [--source]
+//
+// One line per record: local time, level, message (and file:line with --source).
+#include "AraLog.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ara::log;
+
+namespace {
+
+// Site as read back from the file; Site::fmt/file point into these strings
+struct StoredSite {
+    std::string fmt;
+    std::string file;
+    Site site;
+};
+
+template <typename T>
+bool ReadValue(std::FILE* f, T& v) {
+    return std::fread(&v, sizeof(T), 1, f) == 1;
+}
+
+bool ReadString(std::FILE* f, std::string& s) {
+    uint16_t n;
+    if (!ReadValue(f, n)) return false;
+    s.resize(n);
+    return n == 0 || std::fread(&s[0], 1, n, f) == n;
+}
+
+std::string FormatTime(uint64_t ns) {
+    const std::time_t secs = static_cast<std::time_t>(ns / 1000000000ull);
+    std::tm tm{};
+    localtime_r(&secs, &tm);
+    char buf[48];
+    const size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    std::snprintf(buf + n, sizeof(buf) - n, ".%06llu",
+                  static_cast<unsigned long long>((ns / 1000) % 1000000));
+    return buf;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <log file> [--source]\n", argv[0]);
+        return 2;
+    }
+    const bool source = argc > 2 && std::strcmp(argv[2], "--source") == 0;
+    std::FILE* f = std::fopen(argv[1], "rb");
+    if (!f) {
+        std::fprintf(stderr, "[LogDecode] Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    char magic[sizeof(kFileMagic)];
+    if (std::fread(magic, 1, sizeof(magic), f) != sizeof(magic) ||
+        std::memcmp(magic, kFileMagic, sizeof(magic)) != 0) {
+        std::fprintf(stderr, "[LogDecode] %s is not an ara log file\n", argv[1]);
+        return 1;
+    }
+
+    std::unordered_map<uint32_t, std::unique_ptr<StoredSite>> sites; // of the current session
+    std::vector<uint8_t> args;
+    std::string line;
+    uint64_t records = 0;
+    int kind;
+    while ((kind = std::fgetc(f)) != EOF) {
+        if (kind == kFileMagic[0]) {
+            // A process appended a new session
+            if (std::fread(magic + 1, 1, sizeof(magic) - 1, f) != sizeof(magic) - 1 ||
+                std::memcmp(magic + 1, kFileMagic + 1, sizeof(magic) - 1) != 0) break;
+            sites.clear();
+            std::printf("-- new session\n");
+        } else if (kind == 'S') {
+            uint32_t id, srcLine;
+            uint8_t level, nargs;
+            std::unique_ptr<StoredSite> s(new StoredSite);
+            if (!ReadValue(f, id) || !ReadValue(f, level) || !ReadValue(f, nargs)) break;
+            s->site.tags.resize(nargs);
+            if (nargs && std::fread(s->site.tags.data(), 1, nargs, f) != nargs) break;
+            if (!ReadValue(f, srcLine) || !ReadString(f, s->file) || !ReadString(f, s->fmt)) break;
+            s->site.level = static_cast<Level>(level);
+            s->site.line = static_cast<int>(srcLine);
+            s->site.fmt = s->fmt.c_str();
+            s->site.file = s->file.c_str();
+            sites[id] = std::move(s);
+        } else if (kind == 'L') {
+            uint32_t id, n;
+            uint64_t ns;
+            if (!ReadValue(f, id) || !ReadValue(f, ns) || !ReadValue(f, n)) break;
+            args.resize(n);
+            if (n && std::fread(args.data(), 1, n, f) != n) break;
+            ++records;
+            auto it = sites.find(id);
+            if (it == sites.end()) {
+                std::printf("%s ?     <unknown site %u>\n", FormatTime(ns).c_str(), id);
+                continue;
+            }
+            const Site& site = it->second->site;
+            line.clear();
+            if (!Format(site, args.data(), args.size(), line)) line += " <truncated>";
+            std::printf("%s %-5s %s", FormatTime(ns).c_str(), ToString(site.level), line.c_str());
+            if (source) std::printf("  (%s:%d)", site.file, site.line);
+            std::printf("\n");
+        } else if (kind == 'D') {
+            uint64_t dropped;
+            if (!ReadValue(f, dropped)) break;
+            std::printf("-- %llu records dropped (ring full)\n", static_cast<unsigned long long>(dropped));
+        } else {
+            std::fprintf(stderr, "[LogDecode] Corrupt record after %llu records\n",
+                         static_cast<unsigned long long>(records));
+            return 1;
+        }
+    }
+    std::fclose(f);
+    return 0;
+}
@@ -0,0 +1,49 @@
+// manifest-compiler - Validate a manifest.json and write its binary image
+//
+//   manifest-compiler <manifest.json> [<manifest.bin>]
+//
+// The output defaults to the JSON path with a .bin extension, which is where
+// LoadManifest() looks for it. Exits non-zero (one line per problem) if the
+// manifest is invalid.
+#include "ManifestCompiler.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace ara::manifest;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <manifest.json> [<manifest.bin>]\n", argv[0]);
+        return 2;
+    }
+    const std::string in = argv[1];
+    const std::string out = argc > 2 ? argv[2] : ImagePathFor(in);
+
+    std::vector<uint8_t> image;
+    std::vector<std::string> errors;
+    if (!CompileManifestFile(in, image, errors)) {
+        for (const auto& e : errors) std::fprintf(stderr, "%s: error: %s\n", in.c_str(), e.c_str());
+        return 1;
+    }
+
+    // Write next to the target and rename, so a running loader never maps a partial image
+    const std::string tmp = out + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    bool ok = f && std::fwrite(image.data(), 1, image.size(), f) == image.size();
+    if (f && std::fclose(f) != 0) ok = false;
+    if (!ok) {
+        std::fprintf(stderr, "%s: error: cannot write %s\n", in.c_str(), tmp.c_str());
+        return 1;
+    }
+    if (std::rename(tmp.c_str(), out.c_str()) != 0) {
+        std::fprintf(stderr, "%s: error: cannot rename %s to %s\n", in.c_str(), tmp.c_str(), out.c_str());
+        return 1;
+    }
+
+    const Manifest m = Manifest::FromImage(std::move(image), "image");
+    std::printf("%s -> %s: %u executables, %u modes, %u service bindings\n", in.c_str(), out.c_str(),
+                m.NumExecutables(), m.NumModes(), m.NumBindings());
+    return 0;
+}